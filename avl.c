@@ -1,28 +1,245 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "blockchain.h"
 #include "avl.h"
+#include "segment.h"
+#include "metrics.h"
+#include "logging.h"
 
+#define VOTER_RECORD_BATCH 4096  // records per fread/fwrite of the registry file
 
+/*
+On-disk registry record, in pre-order. It keeps the layout of the original
+pointer-based node on LP64 so existing registry files still load; left and right
+only say whether the node had that child.
+*/
+typedef struct voterRecord {
+    char voterID[VOTER_KEY_SIZE];
+    int32_t voted;
+    uint64_t left;
+    uint64_t right;
+    int32_t height;
+} voterRecord;
+
+static VoterNode *findVoterNode(const AVLTree *tree, const char *voterID);
 
 //initalize function;
 void initializeTree(AVLTree *tree) {
-    tree->root = NULL;
+    tree->root = 0;
+    initVoterPool(&tree->pool);
+    initVoterFilter(&tree->filter);
+    memset(&tree->stats, 0, sizeof(tree->stats));
         loadTreeFromBinaryFile(tree, "voter_data.bin");
 }
+
+/*
+Releases every node at once, one free per chunk. VoterNode pointers into the tree
+are invalid afterwards; the tree is left empty and can be reused.
+*/
+void destroyAVLTree(AVLTree *tree) {
+    freeVoterPool(&tree->pool);
+    freeVoterFilter(&tree->filter);
+    tree->root = 0;
+    memset(&tree->stats, 0, sizeof(tree->stats));
+}
+
+void initVoterPool(voterPool *pool) {
+    pool->chunks = NULL;
+    pool->chunkCount = 0;
+    pool->chunkCapacity = 0;
+    pool->used = 0;
+    pool->freeList = 0;
+}
+
+void freeVoterPool(voterPool *pool) {
+    for (uint32_t i = 0; i < pool->chunkCount; i++) {
+        free(pool->chunks[i]);
+    }
+    free(pool->chunks);
+    initVoterPool(pool);
+}
+
+/*
+Allocates chunks until count more nodes fit, without moving existing nodes.
+Returns 0 on success, -1 if memory ran out or the 32-bit index space is exhausted.
+*/
+int reserveVoterNodes(voterPool *pool, uint32_t count) {
+    uint64_t needed = (uint64_t)(pool->used ? pool->used : 1) + count;
+    if (needed > VOTER_POOL_MAX_NODES) {
+        return -1;
+    }
+    uint32_t chunksNeeded = (uint32_t)((needed + VOTER_POOL_CHUNK_NODES - 1) >> VOTER_POOL_CHUNK_SHIFT);
+
+    if (chunksNeeded > pool->chunkCapacity) {
+        uint32_t capacity = pool->chunkCapacity ? pool->chunkCapacity : 16;
+        while (capacity < chunksNeeded) {
+            capacity *= 2;
+        }
+        VoterNode **chunks = realloc(pool->chunks, capacity * sizeof(VoterNode *));
+        if (chunks == NULL) {
+            return -1;
+        }
+        pool->chunks = chunks;
+        pool->chunkCapacity = capacity;
+    }
+    while (pool->chunkCount < chunksNeeded) {
+        VoterNode *chunk = aligned_alloc(VOTER_POOL_ALIGN, VOTER_POOL_CHUNK_NODES * sizeof(VoterNode));
+        if (chunk == NULL) {
+            return -1;
+        }
+        pool->chunks[pool->chunkCount++] = chunk;
+    }
+    if (pool->used == 0) {
+        pool->used = 1;  // index 0 is the null link
+    }
+    return 0;
+}
+
+/*
+Copies voterID into a zero-padded fixed-size key. Zero-padded keys compared as
+VOTER_KEY_SIZE bytes order exactly like strcmp on the IDs.
+Returns -1, leaving key untouched, if the ID does not fit; cutting it short would
+make it alias a registered voter.
+*/
+static int voterKey(const char *voterID, char key[VOTER_KEY_SIZE]) {
+    size_t length = strnlen(voterID, VOTER_KEY_SIZE);
+    if (length == VOTER_KEY_SIZE) {
+        return -1;
+    }
+    memset(key, 0, VOTER_KEY_SIZE);
+    memcpy(key, voterID, length);
+    return 0;
+}
+
+// The key as a big-endian integer, so one integer compare gives the memcmp order
+static inline uint64_t voterKeyValue(const char *key) {
+    uint64_t value;
+    memcpy(&value, key, VOTER_KEY_SIZE);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+/*
+The integer key of a voter ID (or of an already padded VoterNode ID), in tree order.
+Returns VOTER_KEY_INVALID for an ID too long to be registered.
+*/
+uint64_t voterIDKey(const char *voterID) {
+    char key[VOTER_KEY_SIZE];
+    if (voterKey(voterID, key) != 0) {
+        return VOTER_KEY_INVALID;
+    }
+    return voterKeyValue(key);
+}
+
+/*
+Sizes the membership filter for twice the nodes in the pool and adds every live key,
+which also drops keys of deleted voters. The pool is scanned in index order rather than
+walking the tree, so the rebuild streams through memory; released nodes have height 0.
+If memory runs out the filter stays disabled until the next explicit rebuild.
+*/
+static void rebuildVoterFilter(AVLTree *tree) {
+    voterPool *pool = &tree->pool;
+
+    if (resetVoterFilter(&tree->filter, 2UL * pool->used) != 0) {
+        tree->filter.capacity = (unsigned long)-1;
+        return;
+    }
+    for (uint32_t index = 1; index < pool->used; index++) {
+        VoterNode *node = voterNodeAt(pool, index);
+        if (node->height > 0) {
+            voterFilterAdd(&tree->filter, voterKeyValue(node->voterID));
+        }
+    }
+}
+
+// Records a key just linked into the tree, rebuilding the filter once it is full
+static void filterVoterKey(AVLTree *tree, uint64_t value) {
+    if (tree->filter.count >= tree->filter.capacity) {
+        rebuildVoterFilter(tree);
+    } else if (tree->filter.blocks != NULL) {
+        voterFilterAdd(&tree->filter, value);
+    }
+}
+
+// Precinct bucket of a voter: the first character of its ID
+int voterPrecinct(const char *voterID) {
+    return (unsigned char)voterID[0];
+}
+
+// Counts node as registered (and as voted if its flag is set).
+void recordVoterStats(registryStats *stats, VoterNode *node) {
+    int precinct = voterPrecinct(node->voterID);
+    stats->registered++;
+    stats->precinctRegistered[precinct]++;
+    if (node->voted) {
+        stats->voted++;
+        stats->precinctVoted[precinct]++;
+    }
+}
+// Reverses recordVoterStats for a node leaving the registry.
+void removeVoterStats(registryStats *stats, VoterNode *node) {
+    int precinct = voterPrecinct(node->voterID);
+    stats->registered--;
+    stats->precinctRegistered[precinct]--;
+    if (node->voted) {
+        stats->voted--;
+        stats->precinctVoted[precinct]--;
+    }
+}
+
+// Moves a node's voted flag to voted, keeping the counters in step.
+static void setVoterVoted(registryStats *stats, VoterNode *node, int voted) {
+    int precinct = voterPrecinct(node->voterID);
+    voted = voted != 0;
+    if (node->voted == voted) {
+        return;
+    }
+    node->voted = voted;
+    stats->voted += voted ? 1 : -1;
+    stats->precinctVoted[precinct] += voted ? 1 : -1;
+}
 /* 
-Creates a new voter node and initializes it with the given voterID.
+Creates a new voter node in the pool and initializes it with the given voterID.
 The voted status is set to 0 (not voted), and height is initialized to 1.
-Returns a pointer to the newly created node.
+Returns the index of the newly created node, or 0 if the ID is too long or the pool could not grow.
 */
-VoterNode *createVoterNode(char *voterID) {
-    VoterNode *newNode = (VoterNode *)malloc(sizeof(VoterNode));
-    strcpy(newNode->voterID, voterID);
+uint32_t createVoterNode(voterPool *pool, const char *voterID) {
+    char key[VOTER_KEY_SIZE];
+    if (voterKey(voterID, key) != 0) {
+        return 0;
+    }
+    uint32_t index = pool->freeList;
+    if (index != 0) {
+        pool->freeList = voterNodeAt(pool, index)->left;
+    } else {
+        if ((pool->used >> VOTER_POOL_CHUNK_SHIFT) >= pool->chunkCount || pool->used == 0) {
+            if (reserveVoterNodes(pool, 1) != 0) {
+                return 0;
+            }
+        }
+        index = pool->used++;
+    }
+    VoterNode *newNode = voterNodeAt(pool, index);
+    memcpy(newNode->voterID, key, VOTER_KEY_SIZE);
     newNode->voted = 0;
-    newNode->left = newNode->right = NULL;
+    newNode->left = newNode->right = 0;
     newNode->height = 1; //height is updated;
-    return newNode;
+    return index;
+}
+
+// Puts a node unlinked from the tree on the free list; the free list is chained through left
+void releaseVoterNode(voterPool *pool, uint32_t index) {
+    VoterNode *node = voterNodeAt(pool, index);
+    node->left = pool->freeList;
+    node->right = 0;
+    node->height = 0;
+    pool->freeList = index;
 }
 
 int max(int a, int b) {
@@ -30,10 +247,14 @@ int max(int a, int b) {
 }
 /*the below function calculates the height of tree
 and return it.*/
-int calculateNodeHeight(VoterNode *node) {
-    if (node == NULL)
+int calculateNodeHeight(const voterPool *pool, uint32_t node) {
+    if (node == 0)
         return 0;
-    return node->height;
+    return voterNodeAt(pool, node)->height;
+}
+
+static void updateNodeHeight(const voterPool *pool, VoterNode *node) {
+    node->height = max(calculateNodeHeight(pool, node->left), calculateNodeHeight(pool, node->right)) + 1;
 }
 // Rotations are used to restore balance in the AVL tree when it becomes unbalanced.
 // These operations ensure that the tree remains balanced, keeping insertions, deletions,
@@ -43,15 +264,16 @@ Performs a right rotation on an unbalanced node to restore balance in the AVL tr
 It rotates the left subtree upwards, making it the new root. 
 Returns the new root after rotation.
 */
-VoterNode *performRightRotation(VoterNode *unbalancedNode) {
-    VoterNode *newRoot = unbalancedNode->left;
-    VoterNode *rightSubtree = newRoot->right;
+uint32_t performRightRotation(voterPool *pool, uint32_t unbalancedNode) {
+    VoterNode *unbalanced = voterNodeAt(pool, unbalancedNode);
+    uint32_t newRoot = unbalanced->left;
+    VoterNode *rotated = voterNodeAt(pool, newRoot);
 
-    newRoot->right = unbalancedNode;
-    unbalancedNode->left = rightSubtree;
+    unbalanced->left = rotated->right;
+    rotated->right = unbalancedNode;
 // Update heights after rotation
-    unbalancedNode->height = max(calculateNodeHeight(unbalancedNode->left), calculateNodeHeight(unbalancedNode->right)) + 1;
-    newRoot->height = max(calculateNodeHeight(newRoot->left), calculateNodeHeight(newRoot->right)) + 1;
+    updateNodeHeight(pool, unbalanced);
+    updateNodeHeight(pool, rotated);
 
     return newRoot;
 }
@@ -59,139 +281,396 @@ VoterNode *performRightRotation(VoterNode *unbalancedNode) {
 Performs a left rotation on an unbalanced node to balance the AVL tree.
 Returns the new root after rotation.
 */
-VoterNode *performLeftRotation(VoterNode *unbalancedNode) {
-    VoterNode *newRoot = unbalancedNode->right;
-    VoterNode *leftSubtree = newRoot->left;
+uint32_t performLeftRotation(voterPool *pool, uint32_t unbalancedNode) {
+    VoterNode *unbalanced = voterNodeAt(pool, unbalancedNode);
+    uint32_t newRoot = unbalanced->right;
+    VoterNode *rotated = voterNodeAt(pool, newRoot);
 
-    newRoot->left = unbalancedNode;
-    unbalancedNode->right = leftSubtree;
+    unbalanced->right = rotated->left;
+    rotated->left = unbalancedNode;
 
-    unbalancedNode->height = max(calculateNodeHeight(unbalancedNode->left), calculateNodeHeight(unbalancedNode->right)) + 1;
-    newRoot->height = max(calculateNodeHeight(newRoot->left), calculateNodeHeight(newRoot->right)) + 1;
+    updateNodeHeight(pool, unbalanced);
+    updateNodeHeight(pool, rotated);
 
     return newRoot;
 }
 // The balance factor helps determine if a node is balanced.
 // A balance factor between -1 and 1 means the node is balanced,
 // while values outside this range trigger a rotation to rebalance the tree.
-int getNodeBalance(VoterNode *node) {
-    if (node == NULL)
+int getNodeBalance(const voterPool *pool, uint32_t node) {
+    if (node == 0)
         return 0;
-    return calculateNodeHeight(node->left) - calculateNodeHeight(node->right);
+    VoterNode *current = voterNodeAt(pool, node);
+    return calculateNodeHeight(pool, current->left) - calculateNodeHeight(pool, current->right);
 }
-/* 
+/*
 Inserts a new voter node into the AVL tree, balancing it as necessary.
-Returns the new root after insertion and balancing.
+The descent records each link it follows and the key comparison made there, so the
+walk back up fixes heights and picks the rotation case without comparing again.
+It stops at the first node whose height did not change, or after one rotation.
+Returns 1 if the voter was added, 0 if already present and -1 if the ID is too long or
+the pool could not grow.
+The index of the voter's node, new or existing, is stored in *index if index is not NULL.
 */
-VoterNode *insertVoterNode(VoterNode *node, char *voterID) {
-    if (node == NULL)
-        return createVoterNode(voterID);
+static int insertVoterKey(AVLTree *tree, const char *voterID, uint32_t *index) {
+    voterPool *pool = &tree->pool;
+    uint32_t *path[AVL_MAX_HEIGHT];
+    int cmps[AVL_MAX_HEIGHT];
+    char key[VOTER_KEY_SIZE];
+    uint32_t *link = &tree->root;
+    int depth = 0;
 
-    if (strcmp(voterID, node->voterID) < 0)
-        node->left = insertVoterNode(node->left, voterID);
-    else if (strcmp(voterID, node->voterID) > 0)
-        node->right = insertVoterNode(node->right, voterID);
-    else
-        return node;
+    if (voterKey(voterID, key) != 0) {
+        return -1;
+    }
+    uint64_t value = voterKeyValue(key);
+    while (*link != 0) {
+        VoterNode *node = voterNodeAt(pool, *link);
+        uint64_t nodeValue = voterKeyValue(node->voterID);
+        if (value == nodeValue) {
+            if (index) *index = *link;
+            return 0;
+        }
+        if (depth == AVL_MAX_HEIGHT) {
+            return -1;
+        }
+        int cmp = value < nodeValue ? -1 : 1;
+        path[depth] = link;
+        cmps[depth++] = cmp;
+        link = cmp < 0 ? &node->left : &node->right;
+    }
 
-    node->height = 1 + max(calculateNodeHeight(node->left), calculateNodeHeight(node->right));
+    // Links point into chunks or at tree->root, so growing the pool leaves them valid
+    uint32_t created = createVoterNode(pool, key);
+    if (created == 0) {
+        return -1;
+    }
+    *link = created;
+    if (index) *index = created;
+    filterVoterKey(tree, value);
 
-    int balance = getNodeBalance(node);
-    // Perform rotations to balance the tree
-    if (balance > 1 && strcmp(voterID, node->left->voterID) < 0)
-        return performRightRotation(node);
+    while (depth-- > 0) {
+        uint32_t at = *path[depth];
+        VoterNode *current = voterNodeAt(pool, at);
+        int oldHeight = current->height;
+        updateNodeHeight(pool, current);
 
-    if (balance < -1 && strcmp(voterID, node->right->voterID) > 0)
-        return performLeftRotation(node);
+        int balance = getNodeBalance(pool, at);
+        // An unbalanced node is at least two levels above the new leaf,
+        // so cmps[depth + 1] is the comparison made at its child on the path
+        if (balance > 1) {
+            if (cmps[depth + 1] > 0)
+                current->left = performLeftRotation(pool, current->left);
+            *path[depth] = performRightRotation(pool, at);
+            break;
+        }
+        if (balance < -1) {
+            if (cmps[depth + 1] < 0)
+                current->right = performRightRotation(pool, current->right);
+            *path[depth] = performLeftRotation(pool, at);
+            break;
+        }
+        if (current->height == oldHeight) {
+            break;
+        }
+    }
+    return 1;
+}
+
+int insertVoterNode(AVLTree *tree, char *voterID) {
+    return insertVoterKey(tree, voterID, NULL);
+}
+
+/*
+Removes a voter from the AVL tree in O(log n) and returns its node to the pool.
+A node with two children is replaced by its in-order successor, which is relinked
+rather than copied so every other voter keeps its node. Heights are fixed from the
+deepest changed level upwards, rotating where needed, until a subtree's height is
+unchanged. If removed is not NULL it receives a copy of the deleted node.
+Returns 1 if the voter was removed, 0 if it was not registered.
+*/
+int deleteVoterNode(AVLTree *tree, const char *voterID, VoterNode *removed) {
+    voterPool *pool = &tree->pool;
+    uint32_t *path[AVL_MAX_HEIGHT];
+    char key[VOTER_KEY_SIZE];
+    uint32_t *link = &tree->root;
+    int depth = 0;
 
-    if (balance > 1 && strcmp(voterID, node->left->voterID) > 0) {
-        node->left = performLeftRotation(node->left);
-        return performRightRotation(node);
+    if (voterKey(voterID, key) != 0) {
+        return 0;
     }
+    uint64_t value = voterKeyValue(key);
+    for (;;) {
+        if (*link == 0 || depth == AVL_MAX_HEIGHT) {
+            return 0;
+        }
+        VoterNode *node = voterNodeAt(pool, *link);
+        uint64_t nodeValue = voterKeyValue(node->voterID);
+        path[depth++] = link;
+        if (value == nodeValue) {
+            break;
+        }
+        link = value < nodeValue ? &node->left : &node->right;
+    }
+
+    int targetDepth = depth - 1;
+    uint32_t target = *link;
+    VoterNode *node = voterNodeAt(pool, target);
+    if (removed) *removed = *node;
+
+    if (node->left == 0 || node->right == 0) {
+        *link = node->left ? node->left : node->right;
+        depth = targetDepth;  // levels above the target need fixing
+    } else {
+        uint32_t *successorLink = &node->right;
+        while (voterNodeAt(pool, *successorLink)->left != 0) {
+            if (depth == AVL_MAX_HEIGHT) {
+                return 0;
+            }
+            path[depth++] = successorLink;
+            successorLink = &voterNodeAt(pool, *successorLink)->left;
+        }
+        uint32_t successor = *successorLink;
+        VoterNode *moved = voterNodeAt(pool, successor);
+
+        *successorLink = moved->right;
+        moved->left = node->left;
+        moved->right = node->right;
+        moved->height = node->height;
+        *link = successor;
+        // The target's right link is now the successor's
+        if (depth > targetDepth + 1) {
+            path[targetDepth + 1] = &moved->right;
+        }
+    }
+    releaseVoterNode(pool, target);
 
-    if (balance < -1 && strcmp(voterID, node->right->voterID) < 0) {
-        node->right = performRightRotation(node->right);
-        return performLeftRotation(node);
+    while (depth-- > 0) {
+        uint32_t at = *path[depth];
+        VoterNode *current = voterNodeAt(pool, at);
+        int oldHeight = current->height;
+        updateNodeHeight(pool, current);
+
+        int balance = getNodeBalance(pool, at);
+        if (balance > 1) {
+            if (getNodeBalance(pool, current->left) < 0)
+                current->left = performLeftRotation(pool, current->left);
+            at = *path[depth] = performRightRotation(pool, at);
+        } else if (balance < -1) {
+            if (getNodeBalance(pool, current->right) > 0)
+                current->right = performRightRotation(pool, current->right);
+            at = *path[depth] = performLeftRotation(pool, at);
+        }
+        if (voterNodeAt(pool, at)->height == oldHeight) {
+            break;
+        }
     }
+    return 1;
+}
 
-    return node;
+/*
+Inserts a voter and updates the counters without touching the registry file, so bulk
+imports can save once per batch. Returns 1 if the voter was added, 0 if already present
+and -1 if the ID is too long or memory ran out.
+*/
+int registerVoter(AVLTree *tree, char *voterID) {
+    int status = insertVoterNode(tree, voterID);
+    if (status == 1) {
+        tree->stats.registered++;
+        tree->stats.precinctRegistered[voterPrecinct(voterID)]++;
+    }
+    return status;
 }
 
 void insertVoter(AVLTree *tree, char *voterID) {
-    tree->root = insertVoterNode(tree->root, voterID);
+    registerVoter(tree, voterID);
     saveTreeToBinaryFile(tree, "voter_data.bin");
     return;
 }
-/* 
-Updates the voting status of a voter.
-If the voter has already voted, it returns 1. If not, it marks the voter as voted and returns 0.
+
+/*
+Deletes a voter and updates the counters without touching the registry file.
+Votes already on the chain are not affected. Returns 1 if removed, 0 if not registered.
 */
-int updateVotingStatus(VoterNode *node, char *voterID) {
-    if (node == NULL) {
+int unregisterVoter(AVLTree *tree, const char *voterID) {
+    VoterNode removed;
+    if (!deleteVoterNode(tree, voterID, &removed)) {
+        return 0;
+    }
+    removeVoterStats(&tree->stats, &removed);
+    return 1;
+}
+
+/*
+Moves a voter to a new ID, keeping its voted flag.
+Returns 0 on success, -1 if oldID is not registered or newID is too long, and 1 if
+newID already is registered.
+*/
+int rekeyVoter(AVLTree *tree, const char *oldID, const char *newID) {
+    uint32_t index;
+    VoterNode removed;
+
+    if (voterIDKey(newID) == VOTER_KEY_INVALID) {
         return -1;
     }
+    if (findVoterNode(tree, newID) != NULL) {
+        return 1;
+    }
+    if (!deleteVoterNode(tree, oldID, &removed)) {
+        return -1;
+    }
+    removeVoterStats(&tree->stats, &removed);
 
-    if (strcmp(voterID, node->voterID) == 0) {
-        if (node->voted == 1) {
-            return 1;
-        } else {
-            node->voted = 1;
-    
-            return 0;
+    // The deleted node is on the free list, so this insert cannot run out of memory
+    insertVoterKey(tree, newID, &index);
+    VoterNode *node = voterNodeAt(&tree->pool, index);
+    node->voted = removed.voted;
+    recordVoterStats(&tree->stats, node);
+    return 0;
+}
+static VoterNode *findVoterNode(const AVLTree *tree, const char *voterID) {
+    char key[VOTER_KEY_SIZE];
+    if (voterKey(voterID, key) != 0) {
+        return NULL;
+    }
+    uint64_t value = voterKeyValue(key);
+    uint32_t index = tree->root;
+
+    // A filter miss is exact: the ID was never registered
+    if (tree->filter.blocks != NULL && !voterFilterMayContain(&tree->filter, value)) {
+        METRIC_ADD(COUNTER_FILTER_REJECTS, 1);
+        return NULL;
+    }
+
+    while (index != 0) {
+        VoterNode *node = voterNodeAt(&tree->pool, index);
+        uint64_t nodeValue = voterKeyValue(node->voterID);
+        if (value == nodeValue) {
+            return node;  // Voter found
         }
+        index = value < nodeValue ? node->left : node->right;
     }
+    return NULL;
+}
 
-    if (strcmp(voterID, node->voterID) < 0)
-        return updateVotingStatus(node->left, voterID);
-    else
-        return updateVotingStatus(node->right, voterID);
+/* 
+Updates the voting status of a voter.
+If the voter has already voted, it returns 1. If not, it marks the voter as voted and returns 0.
+Returns -1 if the voter is not registered.
+*/
+int updateVotingStatus(AVLTree *tree, char *voterID) {
+    VoterNode *voter = findVoterNode(tree, voterID);
+    if (voter == NULL) {
+        return -1;
+    }
+    if (voter->voted == 1) {
+        return 1;
+    }
+    voter->voted = 1;
+    return 0;
 }
 int updateVoting(AVLTree *tree, char *voterID){
-return updateVotingStatus(tree->root, voterID);
+    int status = updateVotingStatus(tree, voterID);
+    if (status == 0) {
+        tree->stats.voted++;
+        tree->stats.precinctVoted[voterPrecinct(voterID)]++;
+    }
+    return status;
 }
 
-// Function to search for a voter in the AVL tree by voterID
-VoterNode *findVoter(VoterNode *node, char *voterID) {
-    if (node == NULL) {
-        return NULL;
+// Undoes a successful updateVoting whose ballot could not be recorded
+void undoVoting(AVLTree *tree, char *voterID) {
+    VoterNode *voter = findVoterNode(tree, voterID);
+    if (voter != NULL) {
+        setVoterVoted(&tree->stats, voter, 0);
     }
+}
 
-    int cmp = strcmp(voterID, node->voterID);
-    if (cmp == 0) {
-        return node;  // Voter found
-    } else if (cmp < 0) {
-        return findVoter(node->left, voterID);
-    } else {
-        return findVoter(node->right, voterID);
+// Returns 0 if voterID is certainly not registered, 1 if it may be (always 1 without a filter)
+int voterMayBeRegistered(const AVLTree *tree, const char *voterID) {
+    uint64_t key = voterIDKey(voterID);
+    if (key == VOTER_KEY_INVALID) {
+        return 0;
+    }
+    return tree->filter.blocks == NULL || voterFilterMayContain(&tree->filter, key);
+}
+
+// Function to search for a voter in the AVL tree by voterID
+VoterNode *findVoter(AVLTree *tree, char *voterID) {
+    METRIC_TIMER_START(findStart);
+    VoterNode *found = findVoterNode(tree, voterID);
+    METRIC_TIMER_STOP(METRIC_FIND_VOTER, findStart);
+    if (found == NULL) {
+        METRIC_ADD(COUNTER_VOTER_MISSES, 1);
     }
+    return found;
 }
 
 /* 
-Displays the voter ID and voting status (whether voted or not) for each voter in the AVL tree (in-order traversal).
+Displays the voter ID and voting status (whether voted or not) for each voter in the subtree (in-order traversal).
 */
-void displayVoterStatus(VoterNode *root) {
-    if (root != NULL) {
-        displayVoterStatus(root->left);
-        printf("Voter ID: %s, Voted: %d\n", root->voterID, root->voted);
-        displayVoterStatus(root->right);
+void displayVoterStatus(const AVLTree *tree, uint32_t root) {
+    uint32_t stack[AVL_MAX_HEIGHT];
+    int top = 0;
+
+    while (root != 0 || top > 0) {
+        while (root != 0 && top < AVL_MAX_HEIGHT) {
+            stack[top++] = root;
+            root = voterNodeAt(&tree->pool, root)->left;
+        }
+        VoterNode *node = voterNodeAt(&tree->pool, stack[--top]);
+        printf("Voter ID: %s, Voted: %d\n", node->voterID, node->voted);
+        root = node->right;
     }
 }
 
 void displayTree(AVLTree *tree) {
-    displayVoterStatus(tree->root);
+    displayVoterStatus(tree, tree->root);
 }
 
 
-// Function to write a single node to a binary file
-void saveNodeToBinaryFile(FILE *file, VoterNode *node) {
-    if (node == NULL) {
+static void fillVoterRecord(voterRecord *record, const VoterNode *node) {
+    memcpy(record->voterID, node->voterID, VOTER_KEY_SIZE);
+    record->voted = node->voted;
+    record->left = node->left != 0;
+    record->right = node->right != 0;
+    record->height = node->height;
+}
+
+// Writes node and its subtrees to a binary file in pre-order, VOTER_RECORD_BATCH records per write
+void saveNodeToBinaryFile(FILE *file, const AVLTree *tree, uint32_t node) {
+    // Right children still to be written; at most one per level above the current node
+    uint32_t pending[AVL_MAX_HEIGHT];
+    int top = 0;
+    size_t count = 0;
+
+    // calloc keeps the padding bytes in every record zero
+    voterRecord *batch = calloc(VOTER_RECORD_BATCH, sizeof(voterRecord));
+    if (batch == NULL) {
+        LOG_ERROR("registry", "Memory allocation failed");
         return;
     }
 
-    fwrite(node, sizeof(VoterNode), 1, file);
+    while (node != 0 || top > 0) {
+        if (node == 0) {
+            node = pending[--top];
+        }
+        const VoterNode *current = voterNodeAt(&tree->pool, node);
+        fillVoterRecord(&batch[count++], current);
+        if (count == VOTER_RECORD_BATCH) {
+            fwrite(batch, sizeof(voterRecord), count, file);
+            count = 0;
+        }
 
-    saveNodeToBinaryFile(file, node->left);
-    saveNodeToBinaryFile(file, node->right);
+        if (current->right != 0 && top < AVL_MAX_HEIGHT) {
+            pending[top++] = current->right;
+        }
+        node = current->left;
+    }
+    if (count > 0) {
+        fwrite(batch, sizeof(voterRecord), count, file);
+    }
+    free(batch);
 }
 
 // Function to save the entire AVL tree to a binary file
@@ -199,62 +678,242 @@ void saveNodeToBinaryFile(FILE *file, VoterNode *node) {
 // It will recursively save the entire AVL tree by traversing in-order (left subtree, root, right subtree)
 // and writing each node's data to the file.
 void saveTreeToBinaryFile(AVLTree *tree, const char *filename) {
+    METRIC_TIMER_START(persistStart);
     FILE *file = fopen(filename, "wb");  // Open file in write-binary mode
     if (file == NULL) {
-        printf("Unable to open file %s for writing.\n", filename);
+        LOG_ERROR("registry", "Unable to open file %s for writing", filename);
         return;
     }
 
-    saveNodeToBinaryFile(file, tree->root);
+    saveNodeToBinaryFile(file, tree, tree->root);
 
     fclose(file);  // Close the file
-    printf("Tree saved to %s successfully.\n", filename);
+    saveRegistryStats(&tree->stats, filename);
+    METRIC_TIMER_STOP(METRIC_REGISTRY_PERSIST, persistStart);
+    METRIC_ADD(COUNTER_VOTERS_WRITTEN, tree->stats.registered);
+    LOG_DEBUG("registry", "Tree saved to %s successfully", filename);
 }
-// Function to read a single node from a binary file
-VoterNode *loadNodeFromBinaryFile(FILE *file) {
-    VoterNode tempNode;
-    if (fread(&tempNode, sizeof(VoterNode), 1, file) != 1) {
-        return NULL;  // Return NULL if there are no more nodes
+
+/*
+Copies the registry file contents (pre-order records and counters) into image.
+Returns 0 on success, -1 if memory runs out.
+*/
+int captureRegistryImage(const AVLTree *tree, registryImage *image) {
+    uint32_t pending[AVL_MAX_HEIGHT];
+    uint32_t node = tree->root;
+    int top = 0;
+
+    image->count = 0;
+    image->stats = tree->stats;
+    // calloc keeps the padding bytes in every record zero
+    image->records = calloc(tree->stats.registered ? tree->stats.registered : 1, sizeof(voterRecord));
+    if (image->records == NULL) {
+        LOG_ERROR("registry", "Memory allocation failed");
+        return -1;
+    }
+    while ((node != 0 || top > 0) && image->count < tree->stats.registered) {
+        if (node == 0) {
+            node = pending[--top];
+        }
+        const VoterNode *current = voterNodeAt(&tree->pool, node);
+        fillVoterRecord(&image->records[image->count++], current);
+        if (current->right != 0 && top < AVL_MAX_HEIGHT) {
+            pending[top++] = current->right;
+        }
+        node = current->left;
+    }
+    return 0;
+}
+
+// Writes a captured registry the way saveTreeToBinaryFile would; returns 0 or -1 on error
+int writeRegistryImage(registryImage *image, const char *filename) {
+    METRIC_TIMER_START(persistStart);
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        LOG_ERROR("registry", "Unable to open file %s for writing", filename);
+        return -1;
+    }
+    size_t written = fwrite(image->records, sizeof(voterRecord), image->count, file);
+    if (fclose(file) != 0 || written != image->count) {
+        LOG_ERROR("registry", "Failed to write %s", filename);
+        return -1;
+    }
+    int status = saveRegistryStats(&image->stats, filename);
+    METRIC_TIMER_STOP(METRIC_REGISTRY_PERSIST, persistStart);
+    METRIC_ADD(COUNTER_VOTERS_WRITTEN, image->count);
+    return status;
+}
+
+void freeRegistryImage(registryImage *image) {
+    free(image->records);
+    image->records = NULL;
+    image->count = 0;
+}
+
+/*
+Reads one node and its subtrees (pre-order) into the tree's pool and counts them into
+stats if not NULL. Returns the index of the subtree root (0 if the file held none).
+Links still to be filled are kept on an explicit stack; a file that would overflow it
+is not a valid AVL tree, and loading stops there.
+A record whose ID does not fit a key (older files allowed a full VOTER_KEY_SIZE ID
+with no terminator) is skipped and counted in skipped. Its subtrees are still read
+into the pool but left unlinked; loadTreeFromBinaryFile relinks them.
+*/
+static uint32_t loadNodeCounted(FILE *file, AVLTree *tree, registryStats *stats,
+                                unsigned long *skipped) {
+    uint32_t *pending[2 * AVL_MAX_HEIGHT];
+    uint32_t root = 0, unlinked = 0;
+    int top = 0;
+    size_t count = 0, next = 0;
+    unsigned long position = 0;
+
+    voterRecord *batch = malloc(VOTER_RECORD_BATCH * sizeof(voterRecord));
+    if (batch == NULL) {
+        LOG_ERROR("registry", "Memory allocation failed");
+        return 0;
+    }
+
+    pending[top++] = &root;
+    while (top > 0) {
+        if (next == count) {
+            count = fread(batch, sizeof(voterRecord), VOTER_RECORD_BATCH, file);
+            next = 0;
+            if (count == 0) {
+                break;  // Truncated file: the remaining links stay 0
+            }
+        }
+        const voterRecord *record = &batch[next++];
+        position++;
+
+        if (strnlen(record->voterID, VOTER_KEY_SIZE) == VOTER_KEY_SIZE) {
+            LOG_WARN("registry", "Skipping record %lu: voter ID %.*s is longer than %d characters",
+                     position, VOTER_KEY_SIZE, record->voterID, VOTER_KEY_SIZE - 1);
+            if (skipped) (*skipped)++;
+            top--;
+            if (top + 2 > 2 * AVL_MAX_HEIGHT) {
+                LOG_ERROR("registry", "Registry file is deeper than any AVL tree; stopped loading");
+                break;
+            }
+            // Its subtrees are still read, so the records after them stay in place
+            if (record->right) pending[top++] = &unlinked;
+            if (record->left) pending[top++] = &unlinked;
+            continue;
+        }
+
+        // Older files may hold bytes after the terminator; createVoterNode zero-pads the key
+        uint32_t index = createVoterNode(&tree->pool, record->voterID);
+        if (index == 0) {
+            LOG_ERROR("registry", "Memory allocation failed");
+            break;
+        }
+        VoterNode *newNode = voterNodeAt(&tree->pool, index);
+        newNode->voted = record->voted;
+        newNode->height = record->height;
+        if (stats) recordVoterStats(stats, newNode);
+        *pending[--top] = index;
+
+        if (top + 2 > 2 * AVL_MAX_HEIGHT) {
+            LOG_ERROR("registry", "Registry file is deeper than any AVL tree; stopped loading");
+            break;
+        }
+        // The left subtree comes first in the file, so it is pushed last
+        if (record->right) pending[top++] = &newNode->right;
+        if (record->left) pending[top++] = &newNode->left;
     }
+    free(batch);
+    return root;
+}
+
+// Function to read a single node from a binary file
+uint32_t loadNodeFromBinaryFile(FILE *file, AVLTree *tree) {
+    return loadNodeCounted(file, tree, NULL, NULL);
+}
 
+typedef struct loadedKey {
+    uint64_t value;
+    uint32_t index;
+} loadedKey;
 
-    VoterNode *newNode = (VoterNode *)malloc(sizeof(VoterNode));
-    *newNode = tempNode;
-    newNode->left = loadNodeFromBinaryFile(file);  // Load left child
-    newNode->right = loadNodeFromBinaryFile(file);  // Load right child
-    return newNode;
+static int compareLoadedKeys(const void *a, const void *b) {
+    const loadedKey *left = a, *right = b;
+    return (left->value > right->value) - (left->value < right->value);
 }
 
-// Function to load the entire AVL tree from a binary file
+static uint32_t buildBalancedTree(voterPool *pool, const uint32_t *order, size_t count);
+
+/*
+After skipped records the loaded links no longer form one tree. The pool then holds
+exactly the loaded nodes, so they are sorted by key and relinked as a balanced tree.
+Returns the new root, or root unchanged if memory runs out.
+*/
+static uint32_t relinkLoadedNodes(voterPool *pool, uint32_t root) {
+    if (pool->used <= 1) {
+        return 0;  // every record was skipped
+    }
+    size_t count = pool->used - 1;
+    loadedKey *keys = malloc(count * sizeof(loadedKey));
+    uint32_t *order = malloc(count * sizeof(uint32_t));
+    if (keys == NULL || order == NULL) {
+        free(keys);
+        free(order);
+        LOG_ERROR("registry", "Memory allocation failed; voters below skipped records are not reachable");
+        return root;
+    }
+    for (size_t i = 0; i < count; i++) {
+        keys[i].index = (uint32_t)(i + 1);
+        keys[i].value = voterKeyValue(voterNodeAt(pool, keys[i].index)->voterID);
+    }
+    qsort(keys, count, sizeof(loadedKey), compareLoadedKeys);
+    for (size_t i = 0; i < count; i++) {
+        order[i] = keys[i].index;
+    }
+    root = buildBalancedTree(pool, order, count);
+    free(keys);
+    free(order);
+    return root;
+}
+
+// Function to load the entire AVL tree from a binary file, replacing what the tree held
 void loadTreeFromBinaryFile(AVLTree *tree, const char *filename) {
     FILE *file = fopen(filename, "rb");  // Open file in read-binary mode
     if (file == NULL) {
-        printf("Unable to open file %s for reading.\n", filename);
+        LOG_WARN("registry", "Unable to open file %s for reading", filename);
         return;
     }
 
+    destroyAVLTree(tree);
+    // Every record becomes one node, so the pool is sized once from the file length
+    struct stat info;
+    if (fstat(fileno(file), &info) == 0 && info.st_size > 0) {
+        uint64_t records = (uint64_t)info.st_size / sizeof(voterRecord);
+        if (records < VOTER_POOL_MAX_NODES) {
+            reserveVoterNodes(&tree->pool, (uint32_t)records);
+        }
+    }
    
-    tree->root = loadNodeFromBinaryFile(file);
+    // Counters are rebuilt from the nodes as they are read, so they always match the file
+    unsigned long skipped = 0;
+    tree->root = loadNodeCounted(file, tree, &tree->stats, &skipped);
+    if (skipped > 0) {
+        LOG_WARN("registry", "%lu records in %s had invalid voter IDs and were skipped", skipped, filename);
+        tree->root = relinkLoadedNodes(&tree->pool, tree->root);
+    }
+    rebuildVoterFilter(tree);
 
     fclose(file);  // Close the file
-    printf("Tree loaded from %s successfully.\n", filename);
+    LOG_INFO("registry", "Tree loaded from %s successfully", filename);
 }
-// Function to save the blockchain to a binary file
-void saveBlockchainToFile(blockchain *bc, const char *filename) {
-    FILE *file = fopen(filename, "wb");
-    if (!file) {
-        perror("Failed to open file for saving blockchain");
-        return;
-    }
-
-    // Iterate over each block in the blockchain
-    block *current = bc->head;
+// Writes the blocks from current to the tail in the chain file format
+static void writeBlocks(FILE *file, block *current) {
+    METRIC_TIMER_START(persistStart);
     while (current != NULL) {
         // Write the length of voterID and candID strings
         size_t voterID_len = strlen(current->voterID) + 1;
         size_t candID_len = strlen(current->candID) + 1;
         fwrite(&voterID_len, sizeof(size_t), 1, file);
         fwrite(&candID_len, sizeof(size_t), 1, file);
+        fwrite(&current->seq, sizeof(uint64_t), 1, file);
+        fwrite(&current->timestamp, sizeof(int64_t), 1, file);
 
         // Write the voterID and candID strings
         fwrite(current->voterID, sizeof(char), voterID_len, file);
@@ -265,27 +924,219 @@ void saveBlockchainToFile(blockchain *bc, const char *filename) {
 
         // Move to the next block
         current = current->next;
+        METRIC_ADD(COUNTER_BLOCKS_WRITTEN, 1);
     }
+    METRIC_TIMER_STOP(METRIC_CHAIN_PERSIST, persistStart);
+}
 
-    fclose(file);
-    printf("Blockchain saved successfully to %s.\n", filename);
+static void writeChainFileHeader(FILE *file) {
+    chainFileHeader header;
+    memcpy(header.magic, CHAIN_FILE_MAGIC, 4);
+    header.version = CHAIN_FILE_VERSION;
+    fwrite(&header, sizeof(header), 1, file);
 }
-void loadBlockchainFromFile(blockchain *bc, const char *filename) {
+
+/*
+Reads the chain file header and leaves file at the first record.
+Returns the format version (CHAIN_FILE_LEGACY for a headerless file), 0 for an empty
+file and -1 for a version this build cannot read.
+*/
+int readChainFileHeader(FILE *file) {
+    chainFileHeader header;
+    size_t got = fread(&header, 1, sizeof(header), file);
+
+    if (got == sizeof(header) && memcmp(header.magic, CHAIN_FILE_MAGIC, 4) == 0) {
+        if (header.version != CHAIN_FILE_VERSION) {
+            LOG_ERROR("chain", "Unsupported chain file version %u", header.version);
+            return -1;
+        }
+        return CHAIN_FILE_VERSION;
+    }
+    // A legacy file starts with a voterID length, whose low bytes never spell the magic
+    rewind(file);
+    return got == 0 ? 0 : CHAIN_FILE_LEGACY;
+}
+
+// Writes every block from first into a new file; returns 0 on success, -1 on error
+int writeChainFile(block *first, const char *filename) {
+    FILE *file = fopen(filename, "wb");
+    if (!file) {
+        perror("Failed to open file for saving blockchain");
+        return -1;
+    }
+
+    writeChainFileHeader(file);
+    writeBlocks(file, first);
+
+    if (ferror(file)) {
+        perror("Failed to save blockchain");
+        fclose(file);
+        return -1;
+    }
+    return fclose(file) == 0 ? 0 : -1;
+}
+
+// Function to save the blockchain to a binary file; sealed blocks stay in their segments
+void saveBlockchainToFile(blockchain *bc, const char *filename) {
+    if (writeChainFile(firstUnsealedBlock(bc), filename) == 0) {
+        LOG_DEBUG("chain", "Blockchain saved successfully to %s", filename);
+    }
+}
+
+/*
+Appends the blocks from first to the tail to an existing chain file, which must already
+hold every unsealed block of bc before first. A missing file is created; a file in the
+legacy format is rewritten once from the unsealed blocks in the current format.
+Returns 0 on success, -1 on a write error; the file is then cut back to its old length,
+so the same blocks can be appended again later.
+*/
+int appendBlocksToFile(blockchain *bc, block *first, const char *filename) {
     FILE *file = fopen(filename, "rb");
+    int version = 0;
+    if (file) {
+        version = readChainFileHeader(file);
+        fclose(file);
+    }
+    if (version < 0) {
+        return -1;
+    }
+    if (version == CHAIN_FILE_LEGACY) {
+        LOG_INFO("chain", "Upgrading %s to chain file version %d", filename, CHAIN_FILE_VERSION);
+        return writeChainFile(firstUnsealedBlock(bc), filename);
+    }
+
+    file = fopen(filename, "ab");
     if (!file) {
-        perror("Failed to open file for loading blockchain");
-        return;
+        perror("Failed to open file for appending blocks");
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long start = ftell(file);
+
+    if (version == 0) {
+        writeChainFileHeader(file);
+    }
+    writeBlocks(file, first);
+
+    int failed = ferror(file);
+    if (failed) {
+        perror("Failed to append blocks");
+    }
+    if (fclose(file) != 0 || failed) {
+        if (start >= 0 && truncate(filename, start) != 0) {
+            perror("Failed to drop a partial append");
+        }
+        return -1;
+    }
+    return 0;
+}
+/*
+Links the sealed blocks into the empty chain bc, each allocated on its own like the
+blocks read from the chain file. Returns 0 on success; on failure bc is left empty.
+*/
+static int loadSealedBlocks(blockchain *bc, segmentStore *store) {
+    uint64_t count = sealedBlockCount(store);
+    if (count == 0) {
+        return 0;
+    }
+    block *blocks = malloc(count * sizeof(block));
+    char *strings = malloc(sealedStringBytes(store));
+    int status = -1;
+    if (!blocks || !strings) {
+        printf("Memory allocation failed\n");
+    } else if (decodeSegmentBlocks(store, blocks, strings) == 0) {
+        status = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            block *newBlock = malloc(sizeof(block));
+            if (newBlock) {
+                *newBlock = blocks[i];
+                newBlock->next = NULL;
+                newBlock->voterID = strdup(blocks[i].voterID);
+                newBlock->candID = strdup(blocks[i].candID);
+            }
+            if (!newBlock || !newBlock->voterID || !newBlock->candID) {
+                perror("Failed to allocate memory for a sealed block");
+                if (newBlock) {
+                    free(newBlock->voterID);
+                    free(newBlock->candID);
+                    free(newBlock);
+                }
+                status = -1;
+                break;
+            }
+            if (bc->head == NULL) {
+                bc->head = bc->tail = newBlock;
+            } else {
+                bc->tail->next = newBlock;
+                bc->tail = newBlock;
+            }
+        }
     }
+    free(blocks);
+    free(strings);
+
+    if (status != 0) {
+        while (bc->head != NULL) {
+            block *next = bc->head->next;
+            free(bc->head->voterID);
+            free(bc->head->candID);
+            free(bc->head);
+            bc->head = next;
+        }
+        bc->tail = NULL;
+        return -1;
+    }
+    bc->sealed = count;
+    return 0;
+}
+
+void loadBlockchainFromFile(blockchain *bc, const char *filename) {
+    segmentStore store;
 
     // Initialize the blockchain as empty
     bc->head = bc->tail = NULL;
+    bc->sealed = 0;
+
+    // Blocks sealed into cold segments come first
+    if (openSegmentStore(&store, filename) != 0) {
+        return;
+    }
+    int loaded = loadSealedBlocks(bc, &store);
+    closeSegmentStore(&store);
+    if (loaded != 0) {
+        return;
+    }
 
-    while (1) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) {
+        if (bc->head != NULL) {
+            // Everything is sealed and the chain file is gone
+            rebuildChainState(bc);
+            return;
+        }
+        perror("Failed to open file for loading blockchain");
+        return;
+    }
+
+    int version = readChainFileHeader(file);
+    if (version < 0) {
+        fclose(file);
+        return;
+    }
+    int skipping = bc->sealed > 0;
+    for (uint64_t position = 0; ; position++) {
         size_t voterID_len, candID_len;
+        uint64_t seq = position;
+        int64_t timestamp = 0;
 
         // Read the lengths of the voterID and candID strings
         if (fread(&voterID_len, sizeof(size_t), 1, file) != 1) break;
         if (fread(&candID_len, sizeof(size_t), 1, file) != 1) break;
+        if (version == CHAIN_FILE_VERSION &&
+            (fread(&seq, sizeof(uint64_t), 1, file) != 1 ||
+             fread(&timestamp, sizeof(int64_t), 1, file) != 1)) {
+            break;
+        }
 
         // Allocate memory for voterID and candID strings
         char *voterID = malloc(voterID_len);
@@ -316,6 +1167,14 @@ void loadBlockchainFromFile(blockchain *bc, const char *filename) {
             break;
         }
 
+        // An interrupted seal leaves the sealed blocks at the front of the file
+        if (skipping && seq < bc->sealed) {
+            free(voterID);
+            free(candID);
+            continue;
+        }
+        skipping = 0;
+
         // Create a new block and add it to the blockchain
         block *newBlock = (block *)malloc(sizeof(block));
         if (!newBlock) {
@@ -328,6 +1187,8 @@ void loadBlockchainFromFile(blockchain *bc, const char *filename) {
 
         newBlock->voterID = voterID;
         newBlock->candID = candID;
+        newBlock->seq = seq;
+        newBlock->timestamp = timestamp;
         memcpy(newBlock->prevhash, prevhash, SHA256_DIGEST_LENGTH);
         newBlock->next = NULL;
 
@@ -340,7 +1201,8 @@ void loadBlockchainFromFile(blockchain *bc, const char *filename) {
     }
 
     fclose(file);
-    printf("Blockchain loaded successfully from %s.\n", filename);
+    rebuildChainState(bc);
+    LOG_INFO("chain", "Blockchain loaded successfully from %s", filename);
 }
 
 void displayVoterDataFromBinaryFile(const char *filename) {
@@ -350,13 +1212,209 @@ void displayVoterDataFromBinaryFile(const char *filename) {
         return;
     }
 
-    VoterNode voter;
+    voterRecord voter;
     printf("Voter Data:\n");
-    while (fread(&voter, sizeof(VoterNode), 1, file) == 1) {
+    while (fread(&voter, sizeof(voterRecord), 1, file) == 1) {
         printf("Voter ID: %s, Voted: %d\n", voter.voterID, voter.voted);
     }
 
     fclose(file);
 }
 
+/*
+Writes the turnout counters next to the registry (<filename>.stats) so tools can
+report turnout without loading the tree. Returns 0 on success, -1 on failure.
+*/
+int saveRegistryStats(registryStats *stats, const char *filename) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s%s", filename, REGISTRY_STATS_SUFFIX);
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        LOG_ERROR("registry", "Unable to open file %s for writing", path);
+        return -1;
+    }
+    fwrite("VSTA", 1, 4, file);
+    fwrite(stats, sizeof(registryStats), 1, file);
+    fclose(file);
+    return 0;
+}
+
+// Reads the counters saved by saveRegistryStats for the registry in filename.
+int loadRegistryStats(const char *filename, registryStats *stats) {
+    char path[512], magic[4];
+    snprintf(path, sizeof(path), "%s%s", filename, REGISTRY_STATS_SUFFIX);
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+    int ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "VSTA", 4) == 0 &&
+             fread(stats, sizeof(registryStats), 1, file) == 1;
+    fclose(file);
+    return ok ? 0 : -1;
+}
+
+static int compareRegistryChanges(const void *a, const void *b) {
+    uint64_t left = voterKeyValue(((const registryChange *)a)->voterID);
+    uint64_t right = voterKeyValue(((const registryChange *)b)->voterID);
+    return (left > right) - (left < right);
+}
+
+/*
+Zero-pads every ID and sorts the list into the order applyRegistryChanges expects.
+An ID that fills voterID with no terminator is left as it is; applyRegistryChanges rejects it.
+*/
+void sortRegistryChanges(registryChange *changes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        char key[VOTER_KEY_SIZE];
+        if (voterKey(changes[i].voterID, key) == 0) {
+            memcpy(changes[i].voterID, key, VOTER_KEY_SIZE);
+        }
+    }
+    qsort(changes, count, sizeof(registryChange), compareRegistryChanges);
+}
+
+// Applies one change through the per-key operations; returns 1 if the registry changed
+static int applyRegistryChange(AVLTree *tree, const registryChange *change) {
+    uint32_t index;
+    VoterNode *node;
+
+    switch (change->op) {
+        case REGISTRY_ADD:
+            if (insertVoterKey(tree, change->voterID, &index) != 1) {
+                return 0;
+            }
+            node = voterNodeAt(&tree->pool, index);
+            node->voted = change->voted != 0;
+            recordVoterStats(&tree->stats, node);
+            return 1;
+        case REGISTRY_REMOVE:
+            return unregisterVoter(tree, change->voterID);
+        case REGISTRY_SET_VOTED:
+            node = findVoterNode(tree, change->voterID);
+            if (node == NULL || node->voted == (change->voted != 0)) {
+                return 0;
+            }
+            setVoterVoted(&tree->stats, node, change->voted);
+            return 1;
+    }
+    return 0;
+}
+
+// Links order[0..count) into a perfectly balanced subtree and returns its root
+static uint32_t buildBalancedTree(voterPool *pool, const uint32_t *order, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t middle = count / 2;
+    VoterNode *node = voterNodeAt(pool, order[middle]);
+    node->left = buildBalancedTree(pool, order, middle);
+    node->right = buildBalancedTree(pool, order + middle + 1, count - middle - 1);
+    updateNodeHeight(pool, node);
+    return order[middle];
+}
 
+/*
+Merges the sorted change list with an in-order walk of the tree, collecting the
+surviving and new nodes in key order, then relinks them as a balanced tree.
+*/
+static long mergeRegistryChanges(AVLTree *tree, const registryChange *changes, size_t count,
+                                 size_t adds) {
+    voterPool *pool = &tree->pool;
+    uint32_t stack[AVL_MAX_HEIGHT];
+    uint32_t node = tree->root;
+    size_t kept = 0, next = 0;
+    long applied = 0;
+    int top = 0;
+
+    // Every allocation happens before the tree is touched, so the merge cannot fail halfway
+    uint32_t *order = malloc(((size_t)pool->used + count) * sizeof(uint32_t));
+    if (order == NULL || (adds > 0 && reserveVoterNodes(pool, (uint32_t)adds) != 0)) {
+        free(order);
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+
+    for (;;) {
+        while (node != 0 && top < AVL_MAX_HEIGHT) {
+            stack[top++] = node;
+            node = voterNodeAt(pool, node)->left;
+        }
+        uint32_t current = top > 0 ? stack[--top] : 0;
+        uint64_t currentValue = current ? voterKeyValue(voterNodeAt(pool, current)->voterID) : UINT64_MAX;
+
+        // Changes for IDs that sort before the current node are not in the tree
+        for (; next < count && voterKeyValue(changes[next].voterID) < currentValue; next++) {
+            if (changes[next].op == REGISTRY_ADD) {
+                uint32_t index = createVoterNode(pool, changes[next].voterID);
+                VoterNode *created = voterNodeAt(pool, index);
+                created->voted = changes[next].voted != 0;
+                recordVoterStats(&tree->stats, created);
+                order[kept++] = index;
+                applied++;
+            }
+        }
+        if (current == 0) {
+            break;
+        }
+
+        VoterNode *visited = voterNodeAt(pool, current);
+        node = visited->right;
+        if (next < count && voterKeyValue(changes[next].voterID) == currentValue) {
+            const registryChange *change = &changes[next++];
+            if (change->op == REGISTRY_REMOVE) {
+                removeVoterStats(&tree->stats, visited);
+                releaseVoterNode(pool, current);
+                applied++;
+                continue;
+            }
+            if (change->op == REGISTRY_SET_VOTED && visited->voted != (change->voted != 0)) {
+                setVoterVoted(&tree->stats, visited, change->voted);
+                applied++;
+            }
+        }
+        order[kept++] = current;
+    }
+
+    tree->root = buildBalancedTree(pool, order, kept);
+    free(order);
+    rebuildVoterFilter(tree);
+    return applied;
+}
+
+/*
+Applies a change list sorted by sortRegistryChanges without touching the registry file.
+Returns the number of changes that altered the registry, or -1 if the list is not
+strictly sorted (or repeats an ID), holds an unterminated ID or memory ran out; the
+tree is unchanged on -1.
+*/
+long applyRegistryChanges(AVLTree *tree, registryChange *changes, size_t count) {
+    size_t adds = 0;
+    long applied = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (changes[i].voterID[VOTER_KEY_SIZE - 1] != '\0') {
+            printf("Registry change IDs must be shorter than %d characters\n", VOTER_KEY_SIZE);
+            return -1;
+        }
+        if (i > 0 && voterKeyValue(changes[i - 1].voterID) >= voterKeyValue(changes[i].voterID)) {
+            printf("Registry changes must be sorted with unique voter IDs\n");
+            return -1;
+        }
+        adds += changes[i].op == REGISTRY_ADD;
+    }
+
+    if (count * REGISTRY_MERGE_RATIO >= tree->stats.registered) {
+        return mergeRegistryChanges(tree, changes, count, adds);
+    }
+    // The free list and a reservation cover every add, so no key below can fail halfway
+    if (adds > 0 && reserveVoterNodes(&tree->pool, (uint32_t)adds) != 0) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        applied += applyRegistryChange(tree, &changes[i]);
+    }
+    return applied;
+}
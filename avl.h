@@ -1,39 +1,154 @@
+#ifndef AVL_H
+#define AVL_H
+
+#include <stdint.h>
+#include "blockchain.h"
+#include "voterfilter.h"
 
 /* 
 Structure to represent a voter in the AVL tree. 
 It contains voterID, whether the voter has voted, 
-left and right child pointers, and height of the node.
+left and right children as pool indices (0 for none), and height of the node.
 */
 
+#define VOTER_KEY_SIZE 8  // IDs are up to 7 characters, stored zero-padded
+#define VOTER_KEY_INVALID UINT64_MAX  // voterIDKey of a longer ID; no padded key has a nonzero last byte
+#define AVL_MAX_HEIGHT 96  // exceeds 1.44 * log2(n) for any addressable n
+
 typedef struct VoterNode {
-    char voterID[8]; 
+    char voterID[VOTER_KEY_SIZE]; 
+    uint32_t left;
+    uint32_t right;
     int voted;
-    struct VoterNode *left;
-    struct VoterNode *right;
     int height;
 } VoterNode;
 
+/*
+Nodes live in fixed-size, cache-line-aligned chunks and are addressed by 32-bit index,
+so a node is 24 bytes instead of a 40-byte malloc block plus allocator overhead.
+Chunks never move once allocated, so VoterNode pointers stay valid until their voter
+is deleted or the pool is freed. Deleted nodes are reused by later inserts. Index 0 is never handed out and stands for "no node". Freeing the pool releases
+the whole registry with one free per chunk.
+*/
+#define VOTER_POOL_CHUNK_SHIFT 16
+#define VOTER_POOL_CHUNK_NODES (1u << VOTER_POOL_CHUNK_SHIFT)
+#define VOTER_POOL_ALIGN 64
+#define VOTER_POOL_MAX_NODES 0xffffffffu
+
+typedef struct voterPool {
+    VoterNode **chunks;
+    uint32_t chunkCount;
+    uint32_t chunkCapacity;
+    uint32_t used;  // next never-used index
+    uint32_t freeList;  // deleted nodes, chained through left; 0 if empty
+} voterPool;
+
+static inline VoterNode *voterNodeAt(const voterPool *pool, uint32_t index) {
+    return &pool->chunks[index >> VOTER_POOL_CHUNK_SHIFT][index & (VOTER_POOL_CHUNK_NODES - 1)];
+}
+
+/*
+Aggregate turnout counters, kept current on every insert and voted-flag flip so
+turnout queries never walk the tree. The precinct of a voter is the first character
+of its ID; each precinct has its own bucket.
+*/
+#define REGISTRY_PRECINCT_BUCKETS 256
+#define REGISTRY_STATS_SUFFIX ".stats"
+
+typedef struct registryStats {
+    unsigned long registered;
+    unsigned long voted;
+    unsigned long precinctRegistered[REGISTRY_PRECINCT_BUCKETS];
+    unsigned long precinctVoted[REGISTRY_PRECINCT_BUCKETS];
+} registryStats;
+
+/*
+The registry file contents (pre-order records and counters) copied out of a tree, so
+the file can be written after the lock guarding the tree is released.
+*/
+typedef struct registryImage {
+    struct voterRecord *records;
+    size_t count;
+    registryStats stats;
+} registryImage;
+
+/*
+A zero-initialized AVLTree is a valid empty tree. The filter holds every registered key
+so lookups of unregistered IDs usually stop before the tree; it is created on the first
+insert and rebuilt at twice the registry size whenever it fills up.
+*/
 typedef struct AVLTree {
-    VoterNode *root;
+    uint32_t root;
+    voterPool pool;
+    voterFilter filter;
+    registryStats stats;
 } AVLTree;
 void initializeTree(AVLTree *tree);
-VoterNode *createVoterNode(char *voterID);
+void destroyAVLTree(AVLTree *tree);
+void initVoterPool(voterPool *pool);
+void freeVoterPool(voterPool *pool);
+int reserveVoterNodes(voterPool *pool, uint32_t count);
+uint32_t createVoterNode(voterPool *pool, const char *voterID);
+void releaseVoterNode(voterPool *pool, uint32_t index);
 int max(int a, int b) ;
-int calculateNodeHeight(VoterNode *node);
-VoterNode *performRightRotation(VoterNode *unbalancedNode);
-VoterNode *performLeftRotation(VoterNode *unbalancedNode) ;
-int getNodeBalance(VoterNode *node) ;
-VoterNode *insertVoterNode(VoterNode *node, char *voterID); 
+int calculateNodeHeight(const voterPool *pool, uint32_t node);
+uint32_t performRightRotation(voterPool *pool, uint32_t unbalancedNode);
+uint32_t performLeftRotation(voterPool *pool, uint32_t unbalancedNode) ;
+int getNodeBalance(const voterPool *pool, uint32_t node) ;
+int insertVoterNode(AVLTree *tree, char *voterID); 
+int deleteVoterNode(AVLTree *tree, const char *voterID, VoterNode *removed);
+int registerVoter(AVLTree *tree, char *voterID);
+int unregisterVoter(AVLTree *tree, const char *voterID);
+int rekeyVoter(AVLTree *tree, const char *oldID, const char *newID);
 void insertVoter(AVLTree *tree, char *voterID);
-int updateVotingStatus(VoterNode *node, char *voterID);
+int updateVotingStatus(AVLTree *tree, char *voterID);
 int updateVoting(AVLTree *voterTree, char *voterID);
-void displayVoterStatus(VoterNode *root);
+void undoVoting(AVLTree *tree, char *voterID);
+void displayVoterStatus(const AVLTree *tree, uint32_t root);
 void displayTree(AVLTree *tree);
-void saveNodeToBinaryFile(FILE *file, VoterNode *node) ;
+void saveNodeToBinaryFile(FILE *file, const AVLTree *tree, uint32_t node) ;
 void saveTreeToBinaryFile(AVLTree *tree, const char *filename);
-VoterNode *loadNodeFromBinaryFile(FILE *file);
+int captureRegistryImage(const AVLTree *tree, registryImage *image);
+int writeRegistryImage(registryImage *image, const char *filename);
+void freeRegistryImage(registryImage *image);
+uint32_t loadNodeFromBinaryFile(FILE *file, AVLTree *tree);
 void loadTreeFromBinaryFile(AVLTree *tree, const char *filename);
 void saveBlockchainToFile(blockchain *bc, const char *filename);
+int writeChainFile(block *first, const char *filename);
+int appendBlocksToFile(blockchain *bc, block *first, const char *filename);
+int readChainFileHeader(FILE *file);
 void loadBlockchainFromFile(blockchain *bc, const char *filename);
-VoterNode *findVoter(VoterNode *node, char *voterID);
+VoterNode *findVoter(AVLTree *tree, char *voterID);
+uint64_t voterIDKey(const char *voterID);
+int voterMayBeRegistered(const AVLTree *tree, const char *voterID);
 void displayVoterDataFromBinaryFile(const char *filename);
+int voterPrecinct(const char *voterID);
+void recordVoterStats(registryStats *stats, VoterNode *node);
+void removeVoterStats(registryStats *stats, VoterNode *node);
+int saveRegistryStats(registryStats *stats, const char *filename);
+int loadRegistryStats(const char *filename, registryStats *stats);
+
+/*
+Batched registry maintenance. A change list sorted by voter ID (see sortRegistryChanges),
+with each ID at most once, is applied in one pass: small lists key by key, lists larger
+than 1/REGISTRY_MERGE_RATIO of the registry by merging them with an in-order walk of
+the tree and rebuilding it perfectly balanced in O(N + M).
+*/
+#define REGISTRY_MERGE_RATIO 16
+
+enum {
+    REGISTRY_ADD,        // register with the given voted flag; no-op if present
+    REGISTRY_REMOVE,     // delete; no-op if absent
+    REGISTRY_SET_VOTED   // overwrite the voted flag; no-op if absent
+};
+
+typedef struct registryChange {
+    char voterID[VOTER_KEY_SIZE];
+    int op;
+    int voted;
+} registryChange;
+
+void sortRegistryChanges(registryChange *changes, size_t count);
+long applyRegistryChanges(AVLTree *tree, registryChange *changes, size_t count);
+
+#endif
@@ -0,0 +1,570 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "loader.h"
+#include "sharedregistry.h"
+#include "logging.h"
+
+#define BENCH_DEFAULT_OUT "bench_results.json"
+#define BENCH_DEFAULT_DIR "bench_data"
+#define BENCH_MAX_RESULTS 256
+#define BENCH_LOOKUPS 1000000UL     // findVoter lookups per size
+#define BENCH_CAST_CALLS 8          // castVote rewrites the whole chain file, so only a few
+#define BENCH_PASS_BUDGET 1000000UL // elements per size for full-pass benchmarks
+#define BENCH_ID_STRIDE 2654435761ULL
+#define BENCH_REGISTRY_BATCH 1000   // registrations per published version
+
+/*
+Core benchmarks at sizes 10^min-exp .. 10^max-exp (default 10^3 .. 10^6):
+
+    per call:  insertVoterNode, findVoter, findVoterMiss (unregistered IDs),
+               appendBlock, castVote
+    per pass:  calculateMerkleRoot, verifyBlocks, tallyBlocks,
+               saveBlockchainToFile, loadBlockchainFromFile, loadBlockchainParallel,
+               saveTreeToBinaryFile, loadTreeFromBinaryFile
+    shared:    sharedRegistryLookup (one thread), sharedRegistryParallel (one reader per
+               core, while the writer publishes batches of BENCH_REGISTRY_BATCH voters)
+
+Each result has throughput (elements per second) and p50/p99 latency of one call or one
+pass. Results are written as JSON, one benchmark object per line, and --compare
+checks them against an earlier file. It exits with status 2 if any throughput dropped
+by more than --threshold percent. Files are written under --dir because the core uses
+fixed file names.
+*/
+typedef struct benchResult {
+    char name[64];
+    unsigned long n;
+    unsigned long ops;
+    double seconds;
+    double throughput;
+    double p50;
+    double p99;
+} benchResult;
+
+typedef struct latencySet {
+    uint32_t *ns;
+    unsigned long count;
+} latencySet;
+
+static benchResult results[BENCH_MAX_RESULTS];
+static int resultCount;
+
+static const char *benchCandidates[] = {
+    "3VWWF-Q7FZ5", "ZC24N-OSY76", "ALUAX-MIZUB", "K2P9D-0QWEA",
+    "M7TTR-4LZ0C", "B1XVN-88HJE", "Q0PLS-W3RT6", "J5DMC-1YHUG"
+};
+#define BENCH_CANDIDATE_COUNT 8
+
+static uint64_t nowNs(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+static int compareLatency(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void record(latencySet *set, uint64_t ns) {
+    set->ns[set->count++] = ns > UINT32_MAX ? UINT32_MAX : (uint32_t)ns;
+}
+
+/*
+Stores one result. elements is the work done per op (1 for per-call benchmarks, n for
+full passes), so throughput is always in elements per second.
+*/
+static void finishResult(const char *name, unsigned long n, unsigned long elements,
+                         uint64_t totalNs, latencySet *set) {
+    if (resultCount == BENCH_MAX_RESULTS) {
+        return;
+    }
+    benchResult *r = &results[resultCount++];
+
+    qsort(set->ns, set->count, sizeof(uint32_t), compareLatency);
+    snprintf(r->name, sizeof(r->name), "%s", name);
+    r->n = n;
+    r->ops = set->count;
+    r->seconds = totalNs / 1e9;
+    r->throughput = r->seconds > 0 ? set->count * (double)elements / r->seconds : 0;
+    r->p50 = set->count ? set->ns[(set->count - 1) / 2] : 0;
+    r->p99 = set->count ? set->ns[(unsigned long)((set->count - 1) * 0.99)] : 0;
+    set->count = 0;
+
+    fprintf(stderr, "%-24s n=%-9lu %12.0f /s   p50 %10.0f ns   p99 %10.0f ns\n",
+            r->name, r->n, r->throughput, r->p50, r->p99);
+}
+
+// k -> precinct character + 6 digits; miss selects the odd digit values, which are never registered
+static void formatBenchID(unsigned long k, int miss, char *out) {
+    snprintf(out, 16, "%c%06u", "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"[k % 36],
+             (unsigned)((2 * (k / 36) + miss) % 1000000));
+}
+
+// Voter index i -> unique 7-character ID in a scattered order
+static void benchVoterID(unsigned long i, unsigned long n, char *out) {
+    formatBenchID((unsigned long)((i * BENCH_ID_STRIDE) % n), 0, out);
+}
+
+// Index i -> an unregistered ID that sorts between registered ones
+static void benchMissID(unsigned long i, unsigned long n, char *out) {
+    formatBenchID((unsigned long)((i * BENCH_ID_STRIDE) % n), 1, out);
+}
+
+// Frees a chain built by appendBlock or loadBlockchainFromFile
+static void freeChain(blockchain *bc) {
+    block *current = bc->head;
+    while (current) {
+        block *next = current->next;
+        free(current->voterID);
+        free(current->candID);
+        free(current);
+        current = next;
+    }
+    resetBlockchain(bc);
+}
+
+typedef struct benchReader {
+    sharedRegistry *registry;
+    unsigned long n;
+    unsigned long first;
+    unsigned long count;
+    unsigned long missed;
+    int *finished;
+} benchReader;
+
+static void *benchReaderThread(void *arg) {
+    benchReader *reader = arg;
+    char id[16];
+    for (unsigned long i = reader->first; i < reader->first + reader->count; i++) {
+        benchVoterID((i * 7919) % reader->n, reader->n, id);
+        reader->missed += sharedRegistryLookup(reader->registry, id) < 0;
+    }
+    __atomic_add_fetch(reader->finished, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Lookups of registered voters on every core while unregistered IDs are added in batches
+static void benchSharedRegistry(sharedRegistry *registry, unsigned long n, unsigned long lookups,
+                                latencySet *set) {
+    benchReader readers[64];
+    pthread_t threads[64];
+    registryChange batch[BENCH_REGISTRY_BATCH];
+    int threadCount = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int started = 0, finished = 0;
+    unsigned long added = 0, missed = 0;
+    unsigned long firstVersion = sharedRegistryVersion(registry);
+    char id[16];
+    uint64_t t0, t1, total = 0;
+
+    for (unsigned long i = 0; i < lookups; i++) {
+        benchVoterID((i * 7919) % n, n, id);
+        t0 = nowNs();
+        int status = sharedRegistryLookup(registry, id);
+        t1 = nowNs();
+        if (status < 0) {
+            printf("sharedRegistryLookup missed %s\n", id);
+        }
+        record(set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("sharedRegistryLookup", n, 1, total, set);
+
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > 64) threadCount = 64;
+    t0 = nowNs();
+    for (int t = 0; t < threadCount; t++) {
+        readers[t] = (benchReader){ registry, n, lookups * t, lookups, 0, &finished };
+        if (pthread_create(&threads[t], NULL, benchReaderThread, &readers[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+    while (__atomic_load_n(&finished, __ATOMIC_ACQUIRE) < started && added < n) {
+        size_t count = 0;
+        for (; count < BENCH_REGISTRY_BATCH && added < n; count++, added++) {
+            char missID[16];
+            benchMissID(added, n, missID);
+            memcpy(batch[count].voterID, missID, VOTER_KEY_SIZE);
+            batch[count].op = REGISTRY_ADD;
+            batch[count].voted = 0;
+        }
+        sortRegistryChanges(batch, count);
+        sharedRegistryApplyChanges(registry, batch, count);
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+        missed += readers[t].missed;
+    }
+    t1 = nowNs();
+    if (missed > 0) {
+        printf("sharedRegistryParallel missed %lu registered voters\n", missed);
+    }
+    record(set, t1 - t0);
+    finishResult("sharedRegistryParallel", n, lookups * started, t1 - t0, set);
+    fprintf(stderr, "%-24s n=%-9lu %d readers, %lu versions published meanwhile\n",
+            "sharedRegistry", n, started, sharedRegistryVersion(registry) - firstVersion);
+}
+
+static void benchSize(unsigned long n) {
+    latencySet set;
+    unsigned long lookups = BENCH_LOOKUPS;
+    unsigned long passes = BENCH_PASS_BUDGET / n;
+    char id[16];
+    uint64_t t0, t1, total;
+
+    if (passes < 3) passes = 3;
+    if (passes > 50) passes = 50;
+    set.ns = malloc((n > lookups ? n : lookups) * sizeof(uint32_t));
+    set.count = 0;
+    if (!set.ns) {
+        printf("Memory allocation failed\n");
+        return;
+    }
+
+    // Registry
+    AVLTree tree = {0};
+    total = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        benchVoterID(i, n, id);
+        t0 = nowNs();
+        insertVoterNode(&tree, id);
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("insertVoterNode", n, 1, total, &set);
+
+    total = 0;
+    for (unsigned long i = 0; i < lookups; i++) {
+        benchVoterID((i * 7919) % n, n, id);
+        t0 = nowNs();
+        VoterNode *found = findVoter(&tree, id);
+        t1 = nowNs();
+        if (found == NULL) {
+            printf("findVoter missed %s\n", id);
+        }
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("findVoter", n, 1, total, &set);
+
+    total = 0;
+    for (unsigned long i = 0; i < lookups; i++) {
+        benchMissID((i * 7919) % n, n, id);
+        t0 = nowNs();
+        VoterNode *found = findVoter(&tree, id);
+        t1 = nowNs();
+        if (found != NULL) {
+            printf("findVoter found unregistered %s\n", id);
+        }
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("findVoterMiss", n, 1, total, &set);
+
+    // Misses that got past the membership filter and walked the tree
+    unsigned long passed = 0;
+    for (unsigned long i = 0; i < lookups; i++) {
+        benchMissID((i * 7919) % n, n, id);
+        passed += voterMayBeRegistered(&tree, id);
+    }
+    fprintf(stderr, "%-24s n=%-9lu %11.3f %% of misses reach the tree\n", "voterFilter", n,
+            100.0 * passed / lookups);
+
+    // Chain
+    blockchain bc;
+    resetBlockchain(&bc);
+    total = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        benchVoterID(i, n, id);
+        t0 = nowNs();
+        appendBlock(&bc, id, benchCandidates[i % BENCH_CANDIDATE_COUNT]);
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    merkleAccumulatorRoot(&bc.merkle_acc, bc.merkle_root);
+    finishResult("appendBlock", n, 1, total, &set);
+
+    total = 0;
+    for (int i = 0; i < BENCH_CAST_CALLS; i++) {
+        char voter[16], cand[16];
+        snprintf(voter, sizeof(voter), "z%06d", i);
+        snprintf(cand, sizeof(cand), "%s", benchCandidates[i % BENCH_CANDIDATE_COUNT]);
+        t0 = nowNs();
+        castVote(voter, cand, &bc);
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("castVote", n, 1, total, &set);
+
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        t0 = nowNs();
+        unsigned char *root = calculateMerkleRoot(&bc);
+        t1 = nowNs();
+        free(root);
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("calculateMerkleRoot", n, bc.length, total, &set);
+
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        t0 = nowNs();
+        verifyBlocks(&bc, 0);
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("verifyBlocks", n, bc.length, total, &set);
+
+    Candidate candidates[BENCH_CANDIDATE_COUNT];
+    int votes[BENCH_CANDIDATE_COUNT];
+    for (int i = 0; i < BENCH_CANDIDATE_COUNT; i++) {
+        candidates[i].id = (char *)benchCandidates[i];
+        snprintf(candidates[i].name, sizeof(candidates[i].name), "Candidate %d", i + 1);
+    }
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        memset(votes, 0, sizeof(votes));
+        t0 = nowNs();
+        tallyBlocks(&bc, candidates, BENCH_CANDIDATE_COUNT, votes);
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("tallyBlocks", n, bc.length, total, &set);
+
+    // Persistence
+    unsigned long blocks = bc.length;
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        t0 = nowNs();
+        saveBlockchainToFile(&bc, "blockchain_data.bin");
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("saveBlockchainToFile", n, blocks, total, &set);
+    freeChain(&bc);
+
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        blockchain loaded;
+        resetBlockchain(&loaded);
+        t0 = nowNs();
+        loadBlockchainFromFile(&loaded, "blockchain_data.bin");
+        t1 = nowNs();
+        freeChain(&loaded);
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("loadBlockchainFromFile", n, blocks, total, &set);
+
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        blockchain loaded;
+        int verified;
+        resetBlockchain(&loaded);
+        t0 = nowNs();
+        loadBlockchainParallel(&loaded, "blockchain_data.bin", 0, &verified);
+        t1 = nowNs();
+        freeLoadedBlockchain(&loaded);
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("loadBlockchainParallel", n, blocks, total, &set);
+
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        t0 = nowNs();
+        saveTreeToBinaryFile(&tree, "voter_data.bin");
+        t1 = nowNs();
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("saveTreeToBinaryFile", n, n, total, &set);
+    destroyAVLTree(&tree);
+
+    total = 0;
+    for (unsigned long p = 0; p < passes; p++) {
+        AVLTree loaded = {0};
+        t0 = nowNs();
+        loadTreeFromBinaryFile(&loaded, "voter_data.bin");
+        t1 = nowNs();
+        destroyAVLTree(&loaded);
+        record(&set, t1 - t0);
+        total += t1 - t0;
+    }
+    finishResult("loadTreeFromBinaryFile", n, n, total, &set);
+
+    AVLTree loaded = {0};
+    sharedRegistry registry;
+    loadTreeFromBinaryFile(&loaded, "voter_data.bin");
+    if (initSharedRegistry(&registry, &loaded) == 0) {
+        benchSharedRegistry(&registry, n, lookups, &set);
+        destroySharedRegistry(&registry);
+    }
+    destroyAVLTree(&loaded);
+
+    free(set.ns);
+}
+
+static int writeResults(const char *filename) {
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        perror("Error opening results file");
+        return -1;
+    }
+    fprintf(file, "{\"benchmarks\": [\n");
+    for (int i = 0; i < resultCount; i++) {
+        benchResult *r = &results[i];
+        fprintf(file, "{\"name\": \"%s\", \"n\": %lu, \"ops\": %lu, \"seconds\": %.6f, "
+                      "\"throughput\": %.1f, \"p50_ns\": %.0f, \"p99_ns\": %.0f}%s\n",
+                r->name, r->n, r->ops, r->seconds, r->throughput, r->p50, r->p99,
+                i + 1 < resultCount ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+    return 0;
+}
+
+// Reads a file written by writeResults; returns the number of results or -1
+static int readResults(const char *filename, benchResult *out, int max) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        perror("Error opening results file");
+        return -1;
+    }
+    char line[512];
+    int count = 0;
+    while (count < max && fgets(line, sizeof(line), file)) {
+        benchResult *r = &out[count];
+        if (sscanf(line, "{\"name\": \"%63[^\"]\", \"n\": %lu, \"ops\": %lu, \"seconds\": %lf, "
+                         "\"throughput\": %lf, \"p50_ns\": %lf, \"p99_ns\": %lf",
+                   r->name, &r->n, &r->ops, &r->seconds, &r->throughput, &r->p50, &r->p99) == 7) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+/*
+Prints old vs new throughput and p99 for every benchmark present in both sets.
+Returns the number of benchmarks whose throughput fell by more than threshold percent.
+*/
+static int compareResults(benchResult *old, int oldCount, benchResult *cur, int curCount,
+                          double threshold) {
+    int regressions = 0;
+
+    printf("%-24s %9s %14s %14s %8s %12s %12s\n", "benchmark", "n", "old /s", "new /s",
+           "change", "old p99 ns", "new p99 ns");
+    for (int i = 0; i < curCount; i++) {
+        for (int j = 0; j < oldCount; j++) {
+            if (strcmp(cur[i].name, old[j].name) != 0 || cur[i].n != old[j].n) {
+                continue;
+            }
+            double change = old[j].throughput > 0 ?
+                            100.0 * (cur[i].throughput - old[j].throughput) / old[j].throughput : 0;
+            int regressed = change < -threshold;
+            regressions += regressed;
+            printf("%-24s %9lu %14.0f %14.0f %+7.1f%% %12.0f %12.0f%s\n", cur[i].name, cur[i].n,
+                   old[j].throughput, cur[i].throughput, change, old[j].p99, cur[i].p99,
+                   regressed ? "  REGRESSION" : "");
+            break;
+        }
+    }
+    return regressions;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [--min-exp A] [--max-exp B] [--out FILE] [--dir DIR]\n", prog);
+    printf("          [--compare OLD.json [--against NEW.json]] [--threshold PCT]\n");
+    printf("  Sizes run from 10^A to 10^B (default 3..6, up to 7).\n");
+    printf("  --against compares two result files without running anything.\n");
+}
+
+int main(int argc, char *argv[]) {
+    int minExp = 3, maxExp = 6;
+    const char *outFile = BENCH_DEFAULT_OUT, *dir = BENCH_DEFAULT_DIR;
+    const char *compareFile = NULL, *againstFile = NULL;
+    double threshold = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--min-exp") == 0) minExp = atoi(value);
+        else if (strcmp(argv[i], "--max-exp") == 0) maxExp = atoi(value);
+        else if (strcmp(argv[i], "--out") == 0) outFile = value;
+        else if (strcmp(argv[i], "--dir") == 0) dir = value;
+        else if (strcmp(argv[i], "--compare") == 0) compareFile = value;
+        else if (strcmp(argv[i], "--against") == 0) againstFile = value;
+        else if (strcmp(argv[i], "--threshold") == 0) threshold = atof(value);
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+    if (minExp < 1 || maxExp > 7 || minExp > maxExp || (againstFile && !compareFile)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    static benchResult old[BENCH_MAX_RESULTS];
+    int oldCount = 0;
+    if (compareFile && (oldCount = readResults(compareFile, old, BENCH_MAX_RESULTS)) < 0) {
+        return 1;
+    }
+
+    if (againstFile) {
+        resultCount = readResults(againstFile, results, BENCH_MAX_RESULTS);
+        if (resultCount < 0) {
+            return 1;
+        }
+    } else {
+        char cwd[4096];
+        if (getcwd(cwd, sizeof(cwd)) == NULL) {
+            perror("Error reading working directory");
+            return 1;
+        }
+        mkdir(dir, 0755);
+        if (chdir(dir) != 0) {
+            perror("Error entering benchmark directory");
+            return 1;
+        }
+        // Per-call INFO records (file loaded, tree saved) would be formatted inside the timed
+        // intervals; only warnings and errors are kept unless VOTING_LOG_LEVEL says otherwise
+        logSetLevel(LOG_LEVEL_WARN);
+        logStart();
+        unsigned long n = 1;
+        for (int e = 0; e < minExp; e++) n *= 10;
+        for (int e = minExp; e <= maxExp; e++, n *= 10) {
+            benchSize(n);
+        }
+        logStop();
+        if (chdir(cwd) != 0 || writeResults(outFile) != 0) {
+            return 1;
+        }
+        fprintf(stderr, "Results written to %s\n", outFile);
+    }
+
+    if (compareFile) {
+        return compareResults(old, oldCount, results, resultCount, threshold) > 0 ? 2 : 0;
+    }
+    return 0;
+}
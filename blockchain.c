@@ -3,106 +3,201 @@
 #include <string.h>
 #include "blockchain.h"
 #include "avl.h"
+#include "loader.h"
+#include "chainsnapshot.h"
+#include "segment.h"
+#include "metrics.h"
+#include "logging.h"
 #include <time.h>
 
-#define CANDIDATES_FILE "candidates.txt"
 #define MAX_CANDIDATES 8  // Adjust as needed
 
 void initializeBlockchain(blockchain *bc) {
+    int verified = 1;
+
+    resetBlockchain(bc);
+    // Load from file if it exists; decoding and hash checks run on all cores
+    loadBlockchainParallel(bc, "blockchain_data.bin", 0, &verified);
+    if (!verified) {
+        LOG_WARN("chain", "blockchain_data.bin failed verification while loading");
+    }
+}
+
+// Puts the chain in the empty state; blocks already linked are not freed.
+void resetBlockchain(blockchain *bc) {
     bc->head = NULL;
     bc->tail = NULL;
-    bc->merkle_count = 0;
-    loadBlockchainFromFile(bc, "blockchain_data.bin"); 
-    // Load from file if it exists
+    bc->length = 0;
+    bc->sealed = 0;
+    merkleAccumulatorInit(&bc->merkle_acc);
+    merkleAccumulatorRoot(&bc->merkle_acc, bc->merkle_root);
+    SHA256((unsigned char *)"", 0, bc->tail_hash);
 }
 
-void castVote(char *voterID, char *candID, blockchain *bc) {
-    printf("Casting vote for Voter ID: %s, Candidate ID: %s\n", voterID, candID);
+// The first block the chain file holds; the ones before it live in cold segments
+block *firstUnsealedBlock(blockchain *bc) {
+    block *current = bc->head;
+    for (unsigned long i = 0; i < bc->sealed && current != NULL; i++) {
+        current = current->next;
+    }
+    return current;
+}
 
+/*
+Links a new block at the tail and folds its hash into the Merkle accumulator.
+The new block's prevhash is the cached hash of the old tail, so each append costs
+one block hash plus O(1) amortized Merkle hashes. Nothing is written to disk.
+The block gets the next sequence number and the current time, clamped so timestamps
+never decrease along the chain. Returns the new block, or NULL if allocation failed.
+*/
+block *appendBlock(blockchain *bc, const char *voterID, const char *candID) {
     block *newBlock = (block *)malloc(sizeof(block));
     
     if (newBlock == NULL) {
         printf("Memory allocation failed\n");
-        return;
+        return NULL;
     }
 
     newBlock->voterID = strdup(voterID);
     newBlock->candID = strdup(candID);
     newBlock->next = NULL;
+    newBlock->seq = bc->tail ? bc->tail->seq + 1 : 0;
+    newBlock->timestamp = (int64_t)time(NULL);
+    if (bc->tail && newBlock->timestamp < bc->tail->timestamp) {
+        newBlock->timestamp = bc->tail->timestamp;
+    }
+    // tail_hash is SHA256("") for an empty chain, which is the genesis prevhash
+    memcpy(newBlock->prevhash, bc->tail_hash, SHA256_DIGEST_LENGTH);
 
     if (bc->head == NULL) {
-        SHA256((unsigned char *)"", 0, newBlock->prevhash);
         bc->head = newBlock;
         bc->tail = newBlock;
     } else {
-        unsigned char *prevBlockString = toString(bc->tail);
-        SHA256(prevBlockString, strlen((char *)prevBlockString), newBlock->prevhash);
-        free(prevBlockString);
-
         bc->tail->next = newBlock;
         bc->tail = newBlock;
     }
 
-    addToMerkleTree(bc, newBlock->prevhash);
+    hashBlock(newBlock, bc->tail_hash);
+    METRIC_TIMER_START(merkleStart);
+    addToMerkleTree(bc, bc->tail_hash);
+    METRIC_TIMER_STOP(METRIC_MERKLE_UPDATE, merkleStart);
+    bc->length++;
+    METRIC_ADD(COUNTER_BLOCKS_APPENDED, 1);
+    return newBlock;
+}
 
-    // Update the saved Merkle root after casting a vote
-    unsigned char *new_merkle_root = calculateMerkleRoot(bc);
-    if (new_merkle_root) {
-        memcpy(bc->merkle_root, new_merkle_root, SHA256_DIGEST_LENGTH);
-        free(new_merkle_root);
+void castVote(char *voterID, char *candID, blockchain *bc) {
+    METRIC_TIMER_START(castStart);
+    LOG_DEBUG("chain", "Casting vote for Voter ID: %s, Candidate ID: %s", voterID, candID);
+
+    if (appendBlock(bc, voterID, candID) == NULL) {
+        return;
     }
-    printf("Vote casted successfully and Merkle root updated.\n");
+
+    // Update the saved Merkle root after casting a vote
+    merkleAccumulatorRoot(&bc->merkle_acc, bc->merkle_root);
+    LOG_DEBUG("chain", "Vote casted successfully and Merkle root updated");
      saveBlockchainToFile(bc, "blockchain_data.bin");
+    METRIC_TIMER_STOP(METRIC_CAST_VOTE, castStart);
 }
 
+// Adds the full hash of a block as the next Merkle leaf.
 void addToMerkleTree(blockchain *bc, unsigned char *newHash) {
-    if (bc->merkle_count >= MAX_MERKLE_TREE_SIZE) {
-        printf("Merkle Tree is full, cannot add more blocks\n");
-        return;
-    }
+    merkleAccumulatorAdd(&bc->merkle_acc, newHash);
+}
 
-    bc->merkle_tree[bc->merkle_count] = (unsigned char *)malloc(SHA256_DIGEST_LENGTH);
-    memcpy(bc->merkle_tree[bc->merkle_count], newHash, SHA256_DIGEST_LENGTH);
-    bc->merkle_count++;
+void merkleAccumulatorInit(merkleAccumulator *acc) {
+    acc->count = 0;
 }
 
-unsigned char* calculateMerkleRoot(blockchain *bc) {
-    int count = 0;
-    block *current = bc->head;
+static void hashPair(const unsigned char *left, const unsigned char *right, unsigned char *out) {
+    unsigned char data[SHA256_DIGEST_LENGTH * 2];
+    memcpy(data, left, SHA256_DIGEST_LENGTH);
+    memcpy(data + SHA256_DIGEST_LENGTH, right, SHA256_DIGEST_LENGTH);
+    SHA256(data, SHA256_DIGEST_LENGTH * 2, out);
+}
 
-    // Calculate the full hash of each block and store it in temp_tree
-    unsigned char temp_tree[MAX_MERKLE_TREE_SIZE][SHA256_DIGEST_LENGTH];
-    while (current != NULL) {
-        unsigned char fullBlockHash[SHA256_DIGEST_LENGTH];
-        unsigned char *blockString = toString(current);  // Generate full block string for hashing
-        SHA256((unsigned char *)blockString, strlen((char *)blockString), fullBlockHash);
-        free(blockString);
+/*
+Appends a leaf: like a binary counter increment, every complete subtree of equal size
+to the left is merged into the carry before it is parked in the frontier.
+*/
+void merkleAccumulatorAdd(merkleAccumulator *acc, const unsigned char *leaf) {
+    unsigned char node[SHA256_DIGEST_LENGTH];
+    unsigned long n = acc->count;
+    int level = 0;
+
+    memcpy(node, leaf, SHA256_DIGEST_LENGTH);
+    while (n & 1) {
+        hashPair(acc->frontier[level], node, node);
+        n >>= 1;
+        level++;
+    }
+    memcpy(acc->frontier[level], node, SHA256_DIGEST_LENGTH);
+    acc->count++;
+}
 
-        memcpy(temp_tree[count], fullBlockHash, SHA256_DIGEST_LENGTH);
-        count++;
-        current = current->next;
+/*
+Appends a complete subtree of 2^level leaves whose root was computed elsewhere
+(e.g. by another thread). acc->count must be a multiple of 2^level.
+*/
+void merkleAccumulatorAddSubtree(merkleAccumulator *acc, const unsigned char *root, int level) {
+    unsigned char node[SHA256_DIGEST_LENGTH];
+    unsigned long n = acc->count >> level;
+    int l = level;
+
+    memcpy(node, root, SHA256_DIGEST_LENGTH);
+    while (n & 1) {
+        hashPair(acc->frontier[l], node, node);
+        n >>= 1;
+        l++;
     }
+    memcpy(acc->frontier[l], node, SHA256_DIGEST_LENGTH);
+    acc->count += 1UL << level;
+}
 
-    // Build the Merkle root from the full block hashes
-    while (count > 1) {
-        int i = 0, j = 0;
+/*
+Produces the same root as hashing the tree level by level with the last node
+duplicated on odd levels. Walking up, the rightmost (partial) node of each level
+is either paired with the complete subtree in the frontier or duplicated.
+The root of an empty tree is SHA256 of the empty string.
+*/
+void merkleAccumulatorRoot(const merkleAccumulator *acc, unsigned char *out) {
+    unsigned long count = acc->count;
+    unsigned char partial[SHA256_DIGEST_LENGTH];
+    int havePartial = 0;
 
-        while (i < count) {
-            unsigned char data[SHA256_DIGEST_LENGTH * 2];
-            memcpy(data, temp_tree[i], SHA256_DIGEST_LENGTH);
+    if (count == 0) {
+        SHA256((unsigned char *)"", 0, out);
+        return;
+    }
 
-            if (i + 1 < count) {
-                memcpy(data + SHA256_DIGEST_LENGTH, temp_tree[i + 1], SHA256_DIGEST_LENGTH);
-            } else {
-                memcpy(data + SHA256_DIGEST_LENGTH, temp_tree[i], SHA256_DIGEST_LENGTH); // Duplicate last if odd number
-            }
+    for (int level = 0; level < MAX_MERKLE_TREE_SIZE; level++) {
+        unsigned long nodes = (count >> level) + ((count & ((1UL << level) - 1)) != 0);
+        if (nodes == 1) {
+            memcpy(out, havePartial ? partial : acc->frontier[level], SHA256_DIGEST_LENGTH);
+            return;
+        }
 
-            // Hash the concatenated data to form the next level of the Merkle tree
-            SHA256(data, SHA256_DIGEST_LENGTH * 2, temp_tree[j]);
-            i += 2;
-            j++;
+        if ((count >> level) & 1) {
+            hashPair(acc->frontier[level], havePartial ? partial : acc->frontier[level], partial);
+            havePartial = 1;
+        } else if (havePartial) {
+            hashPair(partial, partial, partial);
         }
-        count = j;
+    }
+}
+
+// Recomputes the Merkle root from the blocks themselves, independent of the stored accumulator.
+unsigned char* calculateMerkleRoot(blockchain *bc) {
+    merkleAccumulator acc;
+    block *current = bc->head;
+
+    merkleAccumulatorInit(&acc);
+    while (current != NULL) {
+        unsigned char fullBlockHash[SHA256_DIGEST_LENGTH];
+        hashBlock(current, fullBlockHash);
+        merkleAccumulatorAdd(&acc, fullBlockHash);
+        current = current->next;
     }
 
     // Final root hash at the top of the tree
@@ -111,16 +206,48 @@ unsigned char* calculateMerkleRoot(blockchain *bc) {
         printf("Memory allocation failed\n");
         return NULL;
     }
-    memcpy(root_hash, temp_tree[0], SHA256_DIGEST_LENGTH);
+    merkleAccumulatorRoot(&acc, root_hash);
     return root_hash;
 }
 
+/*
+Rebuilds the cached tail hash, length, accumulator and Merkle root after the
+block list has been populated from somewhere other than appendBlock (e.g. a file).
+*/
+void rebuildChainState(blockchain *bc) {
+    merkleAccumulatorInit(&bc->merkle_acc);
+    SHA256((unsigned char *)"", 0, bc->tail_hash);
+    bc->length = 0;
+
+    for (block *current = bc->head; current != NULL; current = current->next) {
+        hashBlock(current, bc->tail_hash);
+        merkleAccumulatorAdd(&bc->merkle_acc, bc->tail_hash);
+        bc->length++;
+    }
+    merkleAccumulatorRoot(&bc->merkle_acc, bc->merkle_root);
+}
+
 int verifyChain(blockchain *bc) {
+    LOG_INFO("chain", "Starting blockchain verification");
+    int check = verifyBlocks(bc, 1);
+    if (check == -1) {
+        LOG_INFO("chain", "Blockchain is empty");
+    } else {
+        LOG_INFO("chain", "Blockchain verification complete: %s", check ? "intact" : "altered");
+    }
+    return check;
+}
+
+/*
+Checks every prevhash link, and that sequence numbers run consecutively and
+timestamps never decrease. Returns 1 if intact, 0 if an alteration was found
+and -1 for an empty chain. verbose logs every link at debug level and every
+broken link as a warning.
+*/
+int verifyBlocks(blockchain *bc, int verbose) {
 	int check = 1;
-    printf("Starting blockchain verification...\n");
 
     if (bc->head == NULL) {
-        printf("Blockchain is empty.\n");
         return -1;
     }
 
@@ -129,37 +256,43 @@ int verifyChain(blockchain *bc) {
     int count = 1;
 
     while (curr) {
-        printf("%d\t[%s]-[%s]\t", count++, curr->voterID, curr->candID);
-
         unsigned char calculatedHash[SHA256_DIGEST_LENGTH];
-        unsigned char *prevBlockString = toString(prev);
-        SHA256(prevBlockString, strlen((char *)prevBlockString), calculatedHash);
-        free(prevBlockString);
-
-        hashPrinter(calculatedHash, SHA256_DIGEST_LENGTH);
-        printf(" - ");
-        hashPrinter(curr->prevhash, SHA256_DIGEST_LENGTH);
-
-        if (hashCompare(calculatedHash, curr->prevhash)) {
-            printf(" Verified\n");
-        } else {
-            printf(" Alteration detected\n");
+        hashBlock(prev, calculatedHash);
+
+        int intact = hashCompare(calculatedHash, curr->prevhash) &&
+                     curr->seq == prev->seq + 1 && curr->timestamp >= prev->timestamp;
+        // Hex encoding is skipped entirely unless the line will be written
+        if (verbose && (!intact || LOG_ENABLED(LOG_LEVEL_DEBUG))) {
+            char calculatedHex[2 * SHA256_DIGEST_LENGTH + 1];
+            char storedHex[2 * SHA256_DIGEST_LENGTH + 1];
+            hashToHex(calculatedHash, SHA256_DIGEST_LENGTH, calculatedHex);
+            hashToHex(curr->prevhash, SHA256_DIGEST_LENGTH, storedHex);
+            LOG_AT(intact ? LOG_LEVEL_DEBUG : LOG_LEVEL_WARN, "chain", "%d [%s]-[%s] %s - %s %s",
+                   count, curr->voterID, curr->candID, calculatedHex, storedHex,
+                   intact ? "Verified" : "Alteration detected");
+        }
+        count++;
+        if (!intact) {
             check = 0;
         }
 
         prev = curr;
         curr = curr->next;
     }
-    printf("Blockchain verification complete.\n");
     return check;
 }
 
+/*
+Serializes a block as voterID || candID || prevhash, NUL-terminated.
+Legacy block hashes cover the string up to its first NUL (see hashBlock), which keeps
+existing chain files verifiable.
+*/
 unsigned char *toString(block *b) {
     int voterID_len = strlen(b->voterID);
     int candID_len = strlen(b->candID);
     int len = voterID_len + candID_len + SHA256_DIGEST_LENGTH;
 
-    unsigned char *str = (unsigned char *)malloc(len);
+    unsigned char *str = (unsigned char *)malloc(len + 1);
     if (!str) {
         printf("Memory allocation failed\n");
         return NULL;
@@ -168,10 +301,72 @@ unsigned char *toString(block *b) {
     strcpy((char *)str, b->voterID);
     strcat((char *)str, b->candID);
     memcpy(str + voterID_len + candID_len, b->prevhash, SHA256_DIGEST_LENGTH);
+    str[len] = '\0';
 
     return str;
 }
 
+static unsigned char *putLittleEndian(unsigned char *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        *out++ = (unsigned char)(value >> (8 * i));
+    }
+    return out;
+}
+
+/*
+Full hash of a block; this is the prevhash of its successor and its Merkle leaf.
+Blocks from the legacy format (timestamp 0) keep the original hash of toString(). Every
+other block hashes voterID NUL candID NUL prevhash seq timestamp, with both integers
+little-endian, so its sequence number and time are covered by the chain and the root.
+*/
+void hashBlock(block *b, unsigned char *out) {
+    if (b->timestamp == 0) {
+        unsigned char *blockString = toString(b);
+        if (blockString == NULL) {
+            memset(out, 0, SHA256_DIGEST_LENGTH);
+            return;
+        }
+        SHA256(blockString, strlen((char *)blockString), out);
+        free(blockString);
+        return;
+    }
+
+    size_t voterLength = strlen(b->voterID) + 1;
+    size_t candLength = strlen(b->candID) + 1;
+    size_t length = voterLength + candLength + SHA256_DIGEST_LENGTH + 2 * sizeof(uint64_t);
+    unsigned char stackBuffer[256];
+    unsigned char *buffer = length <= sizeof(stackBuffer) ? stackBuffer : malloc(length);
+    if (buffer == NULL) {
+        printf("Memory allocation failed\n");
+        memset(out, 0, SHA256_DIGEST_LENGTH);
+        return;
+    }
+
+    unsigned char *cursor = buffer;
+    memcpy(cursor, b->voterID, voterLength);
+    cursor += voterLength;
+    memcpy(cursor, b->candID, candLength);
+    cursor += candLength;
+    memcpy(cursor, b->prevhash, SHA256_DIGEST_LENGTH);
+    cursor += SHA256_DIGEST_LENGTH;
+    cursor = putLittleEndian(cursor, b->seq);
+    putLittleEndian(cursor, (uint64_t)b->timestamp);
+    SHA256(buffer, length, out);
+    if (buffer != stackBuffer) {
+        free(buffer);
+    }
+}
+
+// out must hold 2 * length + 1 characters
+void hashToHex(const unsigned char hash[], int length, char *out) {
+    static const char digits[] = "0123456789abcdef";
+    for (int i = 0; i < length; i++) {
+        out[2 * i] = digits[hash[i] >> 4];
+        out[2 * i + 1] = digits[hash[i] & 0x0f];
+    }
+    out[2 * length] = '\0';
+}
+
 void hashPrinter(unsigned char hash[], int length) {
     for (int i = 0; i < length; i++) {
         printf("%02x", hash[i]);
@@ -183,48 +378,59 @@ int hashCompare(unsigned char *str1, unsigned char *str2) {
     return memcmp(str1, str2, SHA256_DIGEST_LENGTH) == 0;
 }
 void countVotes(blockchain *bc, Candidate *candidates, int numCandidates) {
-    unsigned char *current_merkle_root = calculateMerkleRoot(bc);
-    if (current_merkle_root == NULL) {
-        printf("Error calculating Merkle root.\n");
+    chainSnapshot snapshot;
+    captureChainSnapshot(bc, &snapshot);
+
+    // Create an array to count votes for each candidate
+    int *candidate_votes = calloc(numCandidates > 0 ? numCandidates : 1, sizeof(int));
+    if (candidate_votes == NULL) {
+        printf("Memory allocation failed\n");
         return;
     }
 
-    // Check if the calculated Merkle root matches the stored Merkle root
-    if (!hashCompare(current_merkle_root, bc->merkle_root)) {
+    // Counting and re-hashing the captured blocks happen in one parallel pass
+    int intact = tallyChainSnapshot(&snapshot, candidates, numCandidates, candidate_votes, 0);
+    if (intact < 0) {
+        free(candidate_votes);
+        return;
+    }
+    if (!intact) {
         printf("Integrity disrupted; Merkle root does not match.\n");
-        free(current_merkle_root);
+        free(candidate_votes);
         return;
     }
 
     printf("Integrity verified.\n");
 
-    // Create an array to count votes for each candidate
-    int candidate_votes[MAX_CANDIDATES] = {0};
+    // Print the vote counts for each candidate
+    printf("Vote counts per candidate (%lu blocks, Merkle root ", snapshot.length);
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) printf("%02x", snapshot.root[i]);
+    printf("):\n");
+    for (int i = 0; i < numCandidates; i++) {
+        printf("Candidate %d (%s): %d votes\n", i + 1, candidates[i].id, candidate_votes[i]);
+    }
 
+    free(candidate_votes);
+}
+
+// Adds the votes of every block in bc to votes[], indexed like candidates[].
+void tallyBlocks(blockchain *bc, Candidate *candidates, int numCandidates, int *votes) {
+    METRIC_TIMER_START(tallyStart);
     // Traverse the blockchain and count the votes for each candidate
     block *current = bc->head;
     while (current) {
         for (int i = 0; i < numCandidates; i++) {
             // Compare the candID from the blockchain with the candidate's id
             if (strcmp(current->candID, candidates[i].id) == 0) {
-                candidate_votes[i]++;  // Increment vote count for the candidate
+                votes[i]++;  // Increment vote count for the candidate
                 break;
             }
         }
         current = current->next;
     }
-
-    // Print the vote counts for each candidate
-    printf("Vote counts per candidate:\n");
-    for (int i = 0; i < numCandidates; i++) {
-        printf("Candidate %d (%s): %d votes\n", i + 1, candidates[i].id, candidate_votes[i]);
-    }
-
-    free(current_merkle_root);
+    METRIC_TIMER_STOP(METRIC_TALLY, tallyStart);
 }
 
-
-
 void printMerkleRoot(blockchain *bc) {
     printf("Current Merkle Root: ");
     hashPrinter(bc->merkle_root, SHA256_DIGEST_LENGTH);
@@ -269,6 +475,8 @@ void destroyAndExit() {
         return;
     }
     fclose(blockchainFile);  // Close the file to effectively empty it
+    remove("blockchain_data.bin" SEGMENT_FILE_SUFFIX);
+    remove("blockchain_data.bin" SEGMENT_INDEX_SUFFIX);
 
     // Open the voter data file in write mode to clear its contents
     FILE *voterFile = fopen("voter_data.bin", "wb");
@@ -277,6 +485,7 @@ void destroyAndExit() {
         return;
     }
     fclose(voterFile);  // Close the file to effectively empty it
+    remove("voter_data.bin" REGISTRY_STATS_SUFFIX);
 
     printf("Data destroyed. Both blockchain and voter data have been cleared.\n");
 }
@@ -401,18 +610,81 @@ void loadCandidatesFromFile(Candidate *candidates, int *numCandidates) {
     }
 
     fclose(file);
-    printf("Candidates loaded successfully. Total candidates: %d\n", *numCandidates);
+    LOG_INFO("chain", "Candidates loaded successfully. Total candidates: %d", *numCandidates);
 }
 
-int hasTimePassed(const char *filename) {
+/*
+Loads every candidate in filename into table, growing it as needed.
+Returns the number of candidates loaded, or -1 if the file cannot be opened.
+*/
+int loadCandidateTable(CandidateTable *table, const char *filename) {
+    table->items = NULL;
+    table->count = table->capacity = 0;
+
     FILE *file = fopen(filename, "r");
     if (file == NULL) {
-        return 0;
+        printf("Error: Could not open %s\n", filename);
+        return -1;
+    }
+
+    char line[256];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        line[strcspn(line, "\n")] = '\0';
+
+        char *id = strtok(line, ",");  // First token: Candidate ID
+        char *name = strtok(NULL, ""); // Remaining part: Candidate Name
+        if (!id || !name) {
+            continue;
+        }
+
+        if (table->count == table->capacity) {
+            int capacity = table->capacity ? table->capacity * 2 : 16;
+            Candidate *items = realloc(table->items, capacity * sizeof(Candidate));
+            if (items == NULL) {
+                printf("Memory allocation failed\n");
+                break;
+            }
+            table->items = items;
+            table->capacity = capacity;
+        }
+
+        Candidate *candidate = &table->items[table->count++];
+        candidate->id = strdup(id);
+        strncpy(candidate->name, name, sizeof(candidate->name) - 1);
+        candidate->name[sizeof(candidate->name) - 1] = '\0';
     }
 
-    long file_time;
-    fscanf(file, "%ld", &file_time);
     fclose(file);
+    LOG_INFO("chain", "Candidates loaded successfully. Total candidates: %d", table->count);
+    return table->count;
+}
+
+void freeCandidateTable(CandidateTable *table) {
+    for (int i = 0; i < table->count; i++) {
+        free(table->items[i].id);
+    }
+    free(table->items);
+    table->items = NULL;
+    table->count = table->capacity = 0;
+}
+
+// Reads the voting deadline (a Unix timestamp) from filename. Returns 0 on success, -1 otherwise.
+int loadVotingDeadline(const char *filename, long *deadline) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return -1;
+    }
+
+    int ok = fscanf(file, "%ld", deadline) == 1;
+    fclose(file);
+    return ok ? 0 : -1;
+}
+
+int hasTimePassed(const char *filename) {
+    long file_time;
+    if (loadVotingDeadline(filename, &file_time) != 0) {
+        return 0;
+    }
 
     time_t current_time = time(NULL);
     if (current_time >= file_time) {
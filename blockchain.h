@@ -1,24 +1,69 @@
+#ifndef BLOCKCHAIN_H
+#define BLOCKCHAIN_H
+
 #include "openssl/sha.h"
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #define MAX_MERKLE_TREE_SIZE 64
 #define MAX_CANDIDATES 8
+#define CANDIDATES_FILE "candidates.txt"
 
+/*
+seq numbers the blocks of a chain from 0 and timestamp is the unix time the ballot was
+appended, never earlier than its predecessor's; verifyBlocks checks both. They are part
+of the block hash (see hashBlock), except in blocks from legacy files, which have
+timestamp 0 and keep the original hash so those chains still verify.
+*/
 typedef struct block {
     char *voterID;
     char *candID;
     struct block *next;
+    uint64_t seq;
+    int64_t timestamp;
     unsigned char prevhash[SHA256_DIGEST_LENGTH];
 } block;
 
+/*
+Chain file: a chainFileHeader, then one record per block:
+
+    size_t voterID length, size_t candID length (both counting the NUL),
+    u64 seq, i64 timestamp, voterID, candID, 32-byte prevhash
+
+Files without the header are the original format, whose records lack seq and timestamp;
+they still load (seq = position, timestamp = 0) and are rewritten in the current format
+on the next save or append.
+*/
+#define CHAIN_FILE_MAGIC "VCHN"
+#define CHAIN_FILE_VERSION 2
+#define CHAIN_FILE_LEGACY 1
+
+typedef struct chainFileHeader {
+    char magic[4];
+    uint32_t version;
+} chainFileHeader;
+
+/*
+Incremental Merkle accumulator.
+frontier[i] holds the root of a complete subtree of 2^i leaves whenever bit i of count is set,
+so appending a leaf costs O(1) amortized hashes and the root can be produced in O(log n)
+without keeping every leaf around. MAX_MERKLE_TREE_SIZE levels covers any chain length.
+*/
+typedef struct merkleAccumulator {
+    unsigned char frontier[MAX_MERKLE_TREE_SIZE][SHA256_DIGEST_LENGTH];
+    unsigned long count;
+} merkleAccumulator;
+
 typedef struct blockchain {
     block *head;
     block *tail;
     unsigned char merkle_root[SHA256_DIGEST_LENGTH];
-    unsigned char *merkle_tree[MAX_MERKLE_TREE_SIZE];
-    int merkle_count;
+    unsigned char tail_hash[SHA256_DIGEST_LENGTH];  // full hash of tail, i.e. the next block's prevhash
+    merkleAccumulator merkle_acc;
+    unsigned long length;
+    unsigned long sealed;  // leading blocks stored in cold segments (segment.h), not in the chain file
 } blockchain;
 
 typedef struct {
@@ -26,22 +71,46 @@ typedef struct {
     char name[50];  // Candidate Name
 } Candidate;
 
+// All candidates from candidates.txt, loaded once; not limited to MAX_CANDIDATES
+typedef struct CandidateTable {
+    Candidate *items;
+    int count;
+    int capacity;
+} CandidateTable;
+
 void initializeBlockchain(blockchain *bc);
+void resetBlockchain(blockchain *bc);
+block *appendBlock(blockchain *bc, const char *voterID, const char *candID);
+block *firstUnsealedBlock(blockchain *bc);
 void castVote(char *voterID, char *candID, blockchain *bc);
 int verifyChain(blockchain *bc);
+int verifyBlocks(blockchain *bc, int verbose);
 unsigned char *toString(block *b);
+void hashBlock(block *b, unsigned char *out);
+void hashToHex(const unsigned char hash[], int length, char *out);
 void hashPrinter(unsigned char hash[], int length);
 int hashCompare(unsigned char *str1, unsigned char *str2);
 void countVotes(blockchain *bc, Candidate *candidates, int numCandidates);
+void tallyBlocks(blockchain *bc, Candidate *candidates, int numCandidates, int *votes);
 void addToMerkleTree(blockchain *bc, unsigned char *newHash);
 unsigned char* calculateMerkleRoot(blockchain *bc);
+void merkleAccumulatorInit(merkleAccumulator *acc);
+void merkleAccumulatorAdd(merkleAccumulator *acc, const unsigned char *leaf);
+void merkleAccumulatorAddSubtree(merkleAccumulator *acc, const unsigned char *root, int level);
+void merkleAccumulatorRoot(const merkleAccumulator *acc, unsigned char *out);
+void rebuildChainState(blockchain *bc);
 void displayCandidates();
 void printMerkleRoot(blockchain *bc);
 void addCandidate();
 void displayCandidates();
 void clearAllCandidates();
 void loadCandidatesFromFile(Candidate *candidates, int *numCandidates);
+int loadCandidateTable(CandidateTable *table, const char *filename);
+void freeCandidateTable(CandidateTable *table);
 int hasTimePassed(const char *filename);
+int loadVotingDeadline(const char *filename, long *deadline);
 void destroyAndExit();
 // void manageCandidatesMenu() 
 //void alterVote(blockchain *bc, char *voterID, char *newCandID);
+
+#endif
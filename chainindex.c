@@ -0,0 +1,412 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "chainindex.h"
+#include "segment.h"
+#include "avl.h"
+#include "logging.h"
+
+typedef struct chainIndexFileHeader {
+    char magic[4];
+    uint32_t interval;
+    uint32_t version;      // format of the chain file the entries were taken from
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t blocks;
+    uint64_t endOffset;
+} chainIndexFileHeader;
+
+static uint64_t dataStart(const chainIndex *index) {
+    return index->version == CHAIN_FILE_VERSION ? sizeof(chainFileHeader) : 0;
+}
+
+// Reads a string field of length bytes (NUL included), truncating it to fit out
+static int readField(FILE *file, size_t length, char *out) {
+    size_t keep = length < CHAIN_RECORD_ID_MAX ? length : CHAIN_RECORD_ID_MAX - 1;
+    if (fread(out, 1, keep, file) != keep) {
+        return -1;
+    }
+    out[keep < length ? keep : length - 1] = '\0';
+    if (keep < length && fseek(file, (long)(length - keep), SEEK_CUR) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+Reads the record at the current position of file, which is block number position of the
+chain (the seq of legacy records). Unless full is set the strings and the hash are
+skipped. Returns the length of the record in bytes, or 0 if none could be read; a
+skipped record can extend past the end of the file, so callers check the length.
+*/
+static uint64_t readRecord(FILE *file, int version, uint64_t position, chainRecord *record, int full) {
+    size_t lengths[2];
+
+    if (fread(lengths, sizeof(size_t), 2, file) != 2 || lengths[0] == 0 || lengths[1] == 0) {
+        return 0;
+    }
+    uint64_t size = 2 * sizeof(size_t) + (uint64_t)lengths[0] + lengths[1] + SHA256_DIGEST_LENGTH;
+    record->seq = position;
+    record->timestamp = 0;
+    if (version == CHAIN_FILE_VERSION) {
+        if (fread(&record->seq, sizeof(uint64_t), 1, file) != 1 ||
+            fread(&record->timestamp, sizeof(int64_t), 1, file) != 1) {
+            return 0;
+        }
+        size += sizeof(uint64_t) + sizeof(int64_t);
+    }
+    if (!full) {
+        long skip = (long)(lengths[0] + lengths[1] + SHA256_DIGEST_LENGTH);
+        return fseek(file, skip, SEEK_CUR) == 0 ? size : 0;
+    }
+    if (readField(file, lengths[0], record->voterID) != 0 ||
+        readField(file, lengths[1], record->candID) != 0 ||
+        fread(record->prevhash, 1, SHA256_DIGEST_LENGTH, file) != SHA256_DIGEST_LENGTH) {
+        return 0;
+    }
+    return size;
+}
+
+static int addEntry(chainIndex *index, const chainRecord *record, uint64_t offset) {
+    if (index->count == index->capacity) {
+        unsigned long capacity = index->capacity ? index->capacity * 2 : 64;
+        chainIndexEntry *entries = realloc(index->entries, capacity * sizeof(chainIndexEntry));
+        if (!entries) {
+            printf("Memory allocation failed\n");
+            return -1;
+        }
+        index->entries = entries;
+        index->capacity = capacity;
+    }
+    chainIndexEntry *entry = &index->entries[index->count++];
+    entry->seq = record->seq;
+    entry->timestamp = record->timestamp;
+    entry->offset = offset;
+    return 0;
+}
+
+static void indexFilePath(const chainIndex *index, char *path, size_t size) {
+    snprintf(path, size, "%s%s", index->chainPath, CHAIN_INDEX_SUFFIX);
+}
+
+// Loads the saved entries; returns 0 if the file exists and matches this chain format
+static int loadIndexFile(chainIndex *index) {
+    char path[300];
+    chainIndexFileHeader header;
+
+    indexFilePath(index, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+    int ok = fread(&header, sizeof(header), 1, file) == 1 &&
+             memcmp(header.magic, CHAIN_INDEX_MAGIC, 4) == 0 &&
+             header.interval == CHAIN_INDEX_INTERVAL && header.version == (uint32_t)index->version;
+    if (ok && header.count > 0) {
+        index->entries = malloc(header.count * sizeof(chainIndexEntry));
+        ok = index->entries != NULL &&
+             fread(index->entries, sizeof(chainIndexEntry), header.count, file) == header.count;
+    }
+    fclose(file);
+    if (!ok) {
+        free(index->entries);
+        index->entries = NULL;
+        return -1;
+    }
+    index->count = index->capacity = header.count;
+    index->blocks = header.blocks;
+    index->endOffset = header.endOffset;
+    return 0;
+}
+
+// Replaces the index file atomically so a crash never leaves a partial one
+static int saveIndexFile(const chainIndex *index) {
+    char path[300], tmpPath[310];
+    chainIndexFileHeader header;
+
+    indexFilePath(index, path, sizeof(path));
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", path);
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file) {
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHAIN_INDEX_MAGIC, 4);
+    header.interval = CHAIN_INDEX_INTERVAL;
+    header.version = (uint32_t)index->version;
+    header.count = index->count;
+    header.blocks = index->blocks;
+    header.endOffset = index->endOffset;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(index->entries, sizeof(chainIndexEntry), index->count, file) == index->count;
+    if (fclose(file) != 0 || !ok || rename(tmpPath, path) != 0) {
+        remove(tmpPath);
+        return -1;
+    }
+    return 0;
+}
+
+// The saved entries are usable if the file still reaches endOffset and the last entry still matches
+static int indexStillValid(chainIndex *index, FILE *file, uint64_t size) {
+    chainRecord record;
+
+    if (index->endOffset < dataStart(index) || index->endOffset > size) {
+        return 0;
+    }
+    if (index->count == 0) {
+        return index->blocks == 0 && index->endOffset == dataStart(index);
+    }
+    chainIndexEntry *last = &index->entries[index->count - 1];
+    uint64_t position = (uint64_t)(index->count - 1) * CHAIN_INDEX_INTERVAL;
+    uint64_t length;
+    return fseek(file, (long)last->offset, SEEK_SET) == 0 &&
+           (length = readRecord(file, index->version, position, &record, 0)) != 0 &&
+           last->offset + length <= size &&
+           record.seq == last->seq && record.timestamp == last->timestamp;
+}
+
+/*
+Opens the index of the chain file at chainPath, bringing it up to date with the file.
+Returns 0 on success and -1 if the chain file cannot be read or memory ran out.
+*/
+int openChainIndex(chainIndex *index, const char *chainPath) {
+    struct stat st;
+
+    memset(index, 0, sizeof(*index));
+    snprintf(index->chainPath, sizeof(index->chainPath), "%s", chainPath);
+    index->segments = malloc(sizeof(segmentStore));
+    if (index->segments == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    if (openSegmentStore(index->segments, chainPath) != 0) {
+        free(index->segments);
+        index->segments = NULL;
+        return -1;
+    }
+    FILE *file = fopen(chainPath, "rb");
+    if (!file && sealedBlockCount(index->segments) > 0) {
+        return 0;  // every block is sealed
+    }
+    if (!file) {
+        perror("Failed to open chain file");
+        closeChainIndex(index);
+        return -1;
+    }
+    if (fstat(fileno(file), &st) != 0) {
+        perror("Failed to stat chain file");
+        fclose(file);
+        closeChainIndex(index);
+        return -1;
+    }
+    uint64_t size = (uint64_t)st.st_size;
+    index->version = readChainFileHeader(file);
+    if (index->version < 0) {
+        fclose(file);
+        closeChainIndex(index);
+        return -1;
+    }
+
+    int reused = loadIndexFile(index) == 0 && indexStillValid(index, file, size);
+    if (!reused) {
+        free(index->entries);
+        index->entries = NULL;
+        index->count = index->capacity = 0;
+        index->blocks = 0;
+        index->endOffset = dataStart(index);
+    }
+
+    // Only records past the saved end are read, and only their fixed fields
+    uint64_t covered = index->blocks;
+    chainRecord record;
+    uint64_t length;
+    fseek(file, (long)index->endOffset, SEEK_SET);
+    while ((length = readRecord(file, index->version, index->blocks, &record, 0)) != 0 &&
+           index->endOffset + length <= size) {
+        if (index->blocks % CHAIN_INDEX_INTERVAL == 0 && addEntry(index, &record, index->endOffset) != 0) {
+            fclose(file);
+            closeChainIndex(index);
+            return -1;
+        }
+        index->endOffset += length;
+        index->blocks++;
+    }
+    fclose(file);
+
+    if ((!reused || index->blocks != covered) && saveIndexFile(index) != 0) {
+        LOG_WARN("chain", "Unable to write the index of %s", chainPath);
+    }
+    return 0;
+}
+
+void closeChainIndex(chainIndex *index) {
+    free(index->entries);
+    index->entries = NULL;
+    index->count = index->capacity = 0;
+    if (index->segments != NULL) {
+        closeSegmentStore(index->segments);
+        free(index->segments);
+        index->segments = NULL;
+    }
+}
+
+static uint64_t sealedBlocks(const chainIndex *index) {
+    return index->segments != NULL ? sealedBlockCount(index->segments) : 0;
+}
+
+// Number of entries with seq <= target; the last of them is where a seek starts
+static unsigned long entriesUpToSeq(const chainIndex *index, uint64_t seq) {
+    unsigned long low = 0, high = index->count;
+    while (low < high) {
+        unsigned long mid = low + (high - low) / 2;
+        if (index->entries[mid].seq <= seq) low = mid + 1; else high = mid;
+    }
+    return low;
+}
+
+// Number of entries with timestamp < from; no record before the last of them is in range
+static unsigned long entriesBeforeTime(const chainIndex *index, int64_t from) {
+    unsigned long low = 0, high = index->count;
+    while (low < high) {
+        unsigned long mid = low + (high - low) / 2;
+        if (index->entries[mid].timestamp < from) low = mid + 1; else high = mid;
+    }
+    return low;
+}
+
+// Opens the chain file positioned at entry (or at the first record for entry 0 of none)
+static FILE *seekEntry(const chainIndex *index, unsigned long entry, uint64_t *position) {
+    FILE *file = fopen(index->chainPath, "rb");
+    if (!file) {
+        perror("Failed to open chain file");
+        return NULL;
+    }
+    uint64_t offset = dataStart(index);
+    *position = 0;
+    if (entry < index->count) {
+        offset = index->entries[entry].offset;
+        *position = (uint64_t)entry * CHAIN_INDEX_INTERVAL;
+    }
+    if (fseek(file, (long)offset, SEEK_SET) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+/*
+Reads block number seq into record without loading the chain.
+Returns 0 if found and -1 if the chain has no such block or cannot be read.
+*/
+int readChainBlock(chainIndex *index, uint64_t seq, chainRecord *record) {
+    unsigned long entries = entriesUpToSeq(index, seq);
+    uint64_t position;
+    int status = -1;
+
+    if (seq < sealedBlocks(index)) {
+        return readSegmentBlock(index->segments, seq, record);
+    }
+    if (index->version == 0) {
+        return -1;  // the chain file was empty or missing when the index was opened
+    }
+    FILE *file = seekEntry(index, entries ? entries - 1 : 0, &position);
+    if (!file) {
+        return -1;
+    }
+    while (readRecord(file, index->version, position++, record, 1) != 0 && record->seq <= seq) {
+        if (record->seq == seq) {
+            status = 0;
+            break;
+        }
+    }
+    fclose(file);
+    return status;
+}
+
+// Visits the blocks of [from, to) that are in the chain file and not sealed
+static long scanHotRange(chainIndex *index, int64_t from, int64_t to,
+                         chainRecordVisitor visit, void *context) {
+    unsigned long entries = entriesBeforeTime(index, from);
+    uint64_t sealed = sealedBlocks(index);
+    chainRecord record;
+    uint64_t position;
+    long visited = 0;
+
+    if (index->version == 0) {
+        return 0;
+    }
+    FILE *file = seekEntry(index, entries ? entries - 1 : 0, &position);
+    if (!file) {
+        return -1;
+    }
+    while (readRecord(file, index->version, position++, &record, 1) != 0 && record.timestamp < to) {
+        if (record.timestamp < from || record.seq < sealed) {
+            continue;
+        }
+        visited++;
+        if (visit(&record, context) != 0) {
+            break;
+        }
+    }
+    fclose(file);
+    return visited;
+}
+
+/*
+Calls visit for every block with from <= timestamp < to, in chain order: first the sealed
+segments whose time bounds overlap the window, then the chain file from the last index
+entry before from up to the first block at or after to.
+Returns the number of blocks visited, or -1 if the chain or a segment cannot be read.
+*/
+long scanChainTimeRange(chainIndex *index, int64_t from, int64_t to,
+                        chainRecordVisitor visit, void *context) {
+    long visited = 0;
+    int stopped = 0;
+
+    if (sealedBlocks(index) > 0) {
+        visited = scanSegmentTimeRange(index->segments, from, to, visit, context, &stopped);
+        if (visited < 0 || stopped) {
+            return visited;
+        }
+    }
+    long hot = scanHotRange(index, from, to, visit, context);
+    return hot < 0 ? -1 : visited + hot;
+}
+
+typedef struct tallyContext {
+    Candidate *candidates;
+    int numCandidates;
+    int *votes;
+} tallyContext;
+
+static int tallyRecord(const chainRecord *record, void *context) {
+    tallyContext *tally = context;
+    for (int i = 0; i < tally->numCandidates; i++) {
+        if (strcmp(record->candID, tally->candidates[i].id) == 0) {
+            tally->votes[i]++;
+            break;
+        }
+    }
+    return 0;
+}
+
+/*
+Adds the ballots cast in [from, to) to votes, like tallyBlocks does for a whole chain.
+Returns the number of ballots in the window (including unknown candidates), or -1.
+*/
+long tallyChainTimeRange(chainIndex *index, int64_t from, int64_t to,
+                         Candidate *candidates, int numCandidates, int *votes) {
+    tallyContext tally = { candidates, numCandidates, votes };
+    long counted = 0;
+
+    // Sealed ballots are counted from the candidate column without decoding whole rows
+    if (sealedBlocks(index) > 0) {
+        counted = tallySegmentTimeRange(index->segments, from, to, candidates, numCandidates, votes);
+        if (counted < 0) {
+            return -1;
+        }
+    }
+    long hot = scanHotRange(index, from, to, tallyRecord, &tally);
+    return hot < 0 ? -1 : counted + hot;
+}
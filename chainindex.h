@@ -0,0 +1,66 @@
+#ifndef CHAININDEX_H
+#define CHAININDEX_H
+
+#include <stdint.h>
+#include "blockchain.h"
+
+#define CHAIN_INDEX_SUFFIX ".tidx"
+#define CHAIN_INDEX_MAGIC "VTIX"
+#define CHAIN_INDEX_INTERVAL 1024  // blocks between index entries
+#define CHAIN_RECORD_ID_MAX 64     // longer IDs are truncated when records are read back
+
+/*
+Sparse seq/time -> file offset index over a chain file.
+
+Every CHAIN_INDEX_INTERVAL-th record gets an entry. Since sequence numbers and timestamps
+never decrease along a chain, a binary search over the entries finds where a block
+number or a time window starts, and a query reads at most CHAIN_INDEX_INTERVAL records
+it does not need instead of walking the chain from the head.
+
+The index is kept next to the chain as <chain>.tidx. openChainIndex checks that its
+last entry still describes the record at that offset, scans only the records appended
+since (or the whole file if the check fails) and writes the index back.
+
+Blocks sealed out of the chain file (segment.h) are answered from their segments: a seq
+below the sealed count goes to its segment, and time-window queries read the segments
+first and then the chain file, skipping sealed blocks an interrupted seal left in it.
+*/
+struct segmentStore;
+
+typedef struct chainIndexEntry {
+    uint64_t seq;
+    int64_t timestamp;
+    uint64_t offset;
+} chainIndexEntry;
+
+typedef struct chainIndex {
+    char chainPath[256];
+    int version;           // format of the chain file
+    chainIndexEntry *entries;
+    unsigned long count;
+    unsigned long capacity;
+    uint64_t blocks;       // records covered
+    uint64_t endOffset;    // just past the last covered record
+    struct segmentStore *segments;  // sealed blocks, which come before the chain file
+} chainIndex;
+
+typedef struct chainRecord {
+    uint64_t seq;
+    int64_t timestamp;
+    char voterID[CHAIN_RECORD_ID_MAX];
+    char candID[CHAIN_RECORD_ID_MAX];
+    unsigned char prevhash[SHA256_DIGEST_LENGTH];
+} chainRecord;
+
+// Returns 0 to keep scanning, anything else to stop
+typedef int (*chainRecordVisitor)(const chainRecord *record, void *context);
+
+int openChainIndex(chainIndex *index, const char *chainPath);
+void closeChainIndex(chainIndex *index);
+int readChainBlock(chainIndex *index, uint64_t seq, chainRecord *record);
+long scanChainTimeRange(chainIndex *index, int64_t from, int64_t to,
+                        chainRecordVisitor visit, void *context);
+long tallyChainTimeRange(chainIndex *index, int64_t from, int64_t to,
+                         Candidate *candidates, int numCandidates, int *votes);
+
+#endif
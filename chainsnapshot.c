@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "chainsnapshot.h"
+#include "metrics.h"
+
+#define SNAPSHOT_CHUNK_BLOCKS (1UL << SNAPSHOT_CHUNK_LEVEL)
+
+typedef struct tallyJob {
+    const chainSnapshot *snapshot;
+    Candidate *candidates;
+    int numCandidates;
+    block **chunkStarts;
+    unsigned char (*chunkRoots)[SHA256_DIGEST_LENGTH];
+    merkleAccumulator partial;  // accumulator of the trailing chunk when it is not full
+    unsigned long chunks;
+    unsigned long nextChunk;
+} tallyJob;
+
+typedef struct tallyWorker {
+    tallyJob *job;
+    int *votes;
+} tallyWorker;
+
+// Counts and hashes one chunk, reducing it to a Merkle subtree root
+static void tallyChunk(tallyJob *job, unsigned long chunk, int *votes) {
+    unsigned long start = chunk * SNAPSHOT_CHUNK_BLOCKS;
+    unsigned long end = start + SNAPSHOT_CHUNK_BLOCKS;
+    merkleAccumulator acc;
+    unsigned char leaf[SHA256_DIGEST_LENGTH];
+    block *current = job->chunkStarts[chunk];
+
+    if (end > job->snapshot->length) end = job->snapshot->length;
+    merkleAccumulatorInit(&acc);
+    for (unsigned long i = start; i < end; i++) {
+        for (int c = 0; c < job->numCandidates; c++) {
+            if (strcmp(current->candID, job->candidates[c].id) == 0) {
+                votes[c]++;
+                break;
+            }
+        }
+        hashBlock(current, leaf);
+        merkleAccumulatorAdd(&acc, leaf);
+        // The captured tail's next pointer may be changing; it is never read
+        if (i + 1 < end) current = current->next;
+    }
+    if (end - start == SNAPSHOT_CHUNK_BLOCKS) {
+        memcpy(job->chunkRoots[chunk], acc.frontier[SNAPSHOT_CHUNK_LEVEL], SHA256_DIGEST_LENGTH);
+    } else {
+        job->partial = acc;
+    }
+}
+
+static void *tallyThread(void *arg) {
+    tallyWorker *worker = arg;
+    tallyJob *job = worker->job;
+
+    for (;;) {
+        unsigned long chunk = __atomic_fetch_add(&job->nextChunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= job->chunks) break;
+        tallyChunk(job, chunk, worker->votes);
+    }
+    return NULL;
+}
+
+// Call with appends to bc excluded
+void captureChainSnapshot(blockchain *bc, chainSnapshot *snapshot) {
+    snapshot->head = bc->head;
+    snapshot->tail = bc->tail;
+    snapshot->length = bc->length;
+    merkleAccumulatorRoot(&bc->merkle_acc, snapshot->root);
+}
+
+/*
+Adds the votes of every captured block to votes[], indexed like candidates[], using
+numThreads threads (0 = one per online CPU).
+Returns 1 if the blocks hash to the captured root, 0 if they do not (votes are still
+counted) and -1 if memory ran out (votes untouched).
+*/
+int tallyChainSnapshot(const chainSnapshot *snapshot, Candidate *candidates, int numCandidates,
+                       int *votes, int numThreads) {
+    unsigned long chunks = (snapshot->length + SNAPSHOT_CHUNK_BLOCKS - 1) / SNAPSHOT_CHUNK_BLOCKS;
+    tallyJob job;
+    int status = -1;
+
+    METRIC_TIMER_START(tallyStart);
+    if (numThreads <= 0) numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads <= 0) numThreads = 1;
+    if ((unsigned long)numThreads > chunks) numThreads = chunks ? (int)chunks : 1;
+
+    memset(&job, 0, sizeof(job));
+    job.snapshot = snapshot;
+    job.candidates = candidates;
+    job.numCandidates = numCandidates;
+    job.chunks = chunks;
+    job.chunkStarts = malloc((chunks ? chunks : 1) * sizeof(block *));
+    job.chunkRoots = malloc((chunks ? chunks : 1) * SHA256_DIGEST_LENGTH);
+    int *threadVotes = calloc((size_t)numThreads * (numCandidates > 0 ? numCandidates : 1), sizeof(int));
+    tallyWorker *workers = malloc(numThreads * sizeof(tallyWorker));
+    pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+    if (!job.chunkStarts || !job.chunkRoots || !threadVotes || !workers || !threads) {
+        printf("Memory allocation failed\n");
+        goto done;
+    }
+
+    // Only the chunk starts are found sequentially; counting and hashing run in parallel
+    block *current = snapshot->head;
+    for (unsigned long i = 0; i < snapshot->length; i++) {
+        if ((i & (SNAPSHOT_CHUNK_BLOCKS - 1)) == 0) {
+            job.chunkStarts[i >> SNAPSHOT_CHUNK_LEVEL] = current;
+        }
+        if (i + 1 < snapshot->length) current = current->next;
+    }
+
+    int started = 0;
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].job = &job;
+        workers[t].votes = threadVotes + (size_t)t * (numCandidates > 0 ? numCandidates : 1);
+    }
+    while (started + 1 < numThreads &&
+           pthread_create(&threads[started], NULL, tallyThread, &workers[started + 1]) == 0) {
+        started++;
+    }
+    tallyThread(&workers[0]);  // the calling thread works too
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+
+    for (int t = 0; t < numThreads; t++) {
+        for (int c = 0; c < numCandidates; c++) {
+            votes[c] += workers[t].votes[c];
+        }
+    }
+
+    // Full chunks are subtrees of SNAPSHOT_CHUNK_LEVEL; the trailing one adds its frontier
+    merkleAccumulator acc;
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    merkleAccumulatorInit(&acc);
+    for (unsigned long c = 0; c < snapshot->length / SNAPSHOT_CHUNK_BLOCKS; c++) {
+        merkleAccumulatorAddSubtree(&acc, job.chunkRoots[c], SNAPSHOT_CHUNK_LEVEL);
+    }
+    for (int level = SNAPSHOT_CHUNK_LEVEL - 1; level >= 0; level--) {
+        if ((job.partial.count >> level) & 1) {
+            merkleAccumulatorAddSubtree(&acc, job.partial.frontier[level], level);
+        }
+    }
+    merkleAccumulatorRoot(&acc, root);
+    status = hashCompare(root, (unsigned char *)snapshot->root) ? 1 : 0;
+
+done:
+    free(job.chunkStarts);
+    free(job.chunkRoots);
+    free(threadVotes);
+    free(workers);
+    free(threads);
+    METRIC_TIMER_STOP(METRIC_TALLY, tallyStart);
+    return status;
+}
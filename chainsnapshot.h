@@ -0,0 +1,31 @@
+#ifndef CHAINSNAPSHOT_H
+#define CHAINSNAPSHOT_H
+
+#include "blockchain.h"
+
+#define SNAPSHOT_CHUNK_LEVEL 12  // blocks are tallied in aligned chunks of 2^12
+
+/*
+Consistent view of a chain prefix for tallying while ballots keep arriving.
+
+captureChainSnapshot records the head, the tail, the block count and the Merkle root
+over exactly those blocks. It costs O(log n) hashes and must run while appends are
+excluded (under the lock that guards the chain); the tally that follows needs no lock,
+because linked blocks never change and it never reads past the captured tail.
+
+tallyChainSnapshot counts the captured blocks on several threads. Each thread also
+re-hashes its chunks into a Merkle subtree, so the tally comes back together with a
+check that the blocks it counted are exactly the ones the captured root commits to.
+*/
+typedef struct chainSnapshot {
+    block *head;
+    block *tail;
+    unsigned long length;
+    unsigned char root[SHA256_DIGEST_LENGTH];
+} chainSnapshot;
+
+void captureChainSnapshot(blockchain *bc, chainSnapshot *snapshot);
+int tallyChainSnapshot(const chainSnapshot *snapshot, Candidate *candidates, int numCandidates,
+                       int *votes, int numThreads);
+
+#endif
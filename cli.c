@@ -0,0 +1,818 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "export.h"
+#include "chainindex.h"
+#include "chainsnapshot.h"
+#include "segment.h"
+#include "prefixindex.h"
+#include "shard.h"
+#include "sharedregistry.h"
+#include "metrics.h"
+#include "logging.h"
+
+#define CHAIN_FILE "blockchain_data.bin"
+#define REGISTRY_FILE "voter_data.bin"
+#define DEADLINE_FILE "voting_time.txt"
+#define CLI_DEFAULT_BATCH 65536
+#define CLI_LINE_MAX 256
+#define CLI_INPUT_BUFFER (1 << 20)
+#define CLI_MAX_THREADS 64
+
+/*
+Headless front-end over the same core as the GUI, for scripted bulk operations:
+
+    voting-cli [--batch N] import-voters [file|-]   one voter ID per line
+    voting-cli [--batch N] remove-voters [file|-]   one voter ID per line
+    voting-cli [--batch N] [--shards N [--precinct-prefix N]] [--threads N] cast [file|-]
+                                                    voterID,candidateID per line
+    voting-cli [--shards N [--precinct-prefix N]] verify
+    voting-cli [--shards N [--precinct-prefix N]] tally
+    voting-cli [--shards N [--precinct-prefix N]] stats
+    voting-cli tally-window <from> <to>             ballots with from <= time < to
+    voting-cli block <seq>
+    voting-cli export <dir>
+    voting-cli seal [rows]                          move closed ranges into cold segments
+
+Input is streamed line by line. Changes are committed every N lines (default 65536):
+new blocks are appended to the chain file and the registry is rewritten once per batch,
+instead of once per record as in the GUI. cast skips ballots for candidates missing from
+candidates.txt without marking the voter.
+
+tally-window and block read the chain file through its sparse index (chainindex.h)
+instead of loading the whole chain; times are unix seconds.
+
+seal moves every complete range of rows blocks (default 65536, a multiple of 4096) out of
+the chain file into columnar segments (segment.h) once voting has closed. The chain file
+keeps only the remaining blocks; every command still sees the whole chain.
+
+--shards N switches the chain commands to sharded mode (shard.h): ballots go to one of
+N chain files by voter ID and verify/tally/stats work across all of them. With
+--precinct-prefix N only the first N characters of the ID (the precinct) pick the
+shard, so each precinct's ballots stay on one chain. The same options must be given to
+every command of an election; tally-window, block, export and seal only work on the
+single chain file.
+
+--threads N casts each batch from N threads. Eligibility is checked against the shared
+registry (sharedregistry.h) without locking and only eligible voters take its writer
+lock; with --shards, ballots for different shards also append in parallel. When one
+voter has two ballots in a batch, which of them counts depends on thread timing.
+*/
+
+static void usage(const char *prog) {
+    printf("Usage: %s [--batch N] [--shards N [--precinct-prefix N]] [--threads N] <command> [args]\n", prog);
+    printf("  import-voters [file|-]  register one voter ID per line\n");
+    printf("  remove-voters [file|-]  unregister one voter ID per line\n");
+    printf("  cast [file|-]           cast one voterID,candidateID ballot per line\n");
+    printf("  verify                  check every block link\n");
+    printf("  tally                   count votes per candidate\n");
+    printf("  tally-window <from> <to> count votes cast in [from, to), unix seconds\n");
+    printf("  block <seq>             print one block by sequence number\n");
+    printf("  export <dir>            write the chain as column files\n");
+    printf("  stats                   print registry and chain statistics\n");
+    printf("  seal [rows]             move complete ranges of blocks into cold segments\n");
+    printf("  --shards N              cast, verify, tally and stats on N shard chains\n");
+    printf("  --precinct-prefix N     route shards by the first N ID characters (default: whole ID)\n");
+    printf("  --threads N             cast each batch from N threads\n");
+}
+
+static FILE *openInput(const char *path) {
+    if (path == NULL || strcmp(path, "-") == 0) {
+        return stdin;
+    }
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        perror("Error opening input file");
+    }
+    return file;
+}
+
+static void closeInput(FILE *file) {
+    if (file != stdin) {
+        fclose(file);
+    }
+}
+
+static double elapsedSince(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Strips the line ending; returns 0 for blank lines and comments
+static int trimLine(char *line) {
+    line[strcspn(line, "\r\n")] = '\0';
+    return line[0] != '\0' && line[0] != '#';
+}
+
+static int importVoters(AVLTree *tree, const char *path, long batchSize) {
+    FILE *input = openInput(path);
+    if (!input) {
+        return 1;
+    }
+    setvbuf(input, NULL, _IOFBF, CLI_INPUT_BUFFER);
+
+    char line[CLI_LINE_MAX];
+    unsigned long added = 0, duplicates = 0, invalid = 0;
+    long pending = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (fgets(line, sizeof(line), input)) {
+        if (!trimLine(line)) {
+            continue;
+        }
+        // IDs must fit VoterNode.voterID with its terminator
+        if (strlen(line) >= sizeof(((VoterNode *)0)->voterID)) {
+            invalid++;
+            continue;
+        }
+        int status = registerVoter(tree, line);
+        if (status < 0) {
+            printf("Memory allocation failed\n");
+            break;
+        }
+        if (status == 1) {
+            added++;
+            pending++;
+        } else {
+            duplicates++;
+        }
+        if (pending >= batchSize) {
+            saveTreeToBinaryFile(tree, REGISTRY_FILE);
+            pending = 0;
+        }
+    }
+    if (pending > 0) {
+        saveTreeToBinaryFile(tree, REGISTRY_FILE);
+    }
+    closeInput(input);
+
+    double seconds = elapsedSince(&start);
+    printf("Imported %lu voters (%lu duplicates, %lu invalid) in %.2f s (%.0f/s)\n",
+           added, duplicates, invalid, seconds, seconds > 0 ? added / seconds : 0.0);
+    return 0;
+}
+
+// Sorts and applies one batch of removals; returns the number removed or -1
+static long removeBatch(AVLTree *tree, registryChange *changes, size_t count) {
+    size_t unique = 0;
+
+    sortRegistryChanges(changes, count);
+    // A repeated ID in the input is removed once
+    for (size_t i = 0; i < count; i++) {
+        if (unique == 0 || memcmp(changes[unique - 1].voterID, changes[i].voterID, VOTER_KEY_SIZE) != 0) {
+            changes[unique++] = changes[i];
+        }
+    }
+    long removed = applyRegistryChanges(tree, changes, unique);
+    if (removed > 0) {
+        saveTreeToBinaryFile(tree, REGISTRY_FILE);
+    }
+    return removed;
+}
+
+/*
+Purges voters from the registry, N IDs per batch. Each batch is applied as one sorted
+change list, so large purges merge with the tree in a single pass. Blocks already on
+the chain are kept.
+*/
+static int removeVoters(AVLTree *tree, const char *path, long batchSize) {
+    FILE *input = openInput(path);
+    if (!input) {
+        return 1;
+    }
+    setvbuf(input, NULL, _IOFBF, CLI_INPUT_BUFFER);
+
+    registryChange *changes = calloc(batchSize, sizeof(registryChange));
+    if (!changes) {
+        printf("Memory allocation failed\n");
+        closeInput(input);
+        return 1;
+    }
+
+    char line[CLI_LINE_MAX];
+    unsigned long requested = 0, removed = 0, invalid = 0;
+    size_t pending = 0;
+    int status = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (fgets(line, sizeof(line), input)) {
+        if (!trimLine(line)) {
+            continue;
+        }
+        if (strlen(line) >= VOTER_KEY_SIZE) {
+            invalid++;
+            continue;
+        }
+        memcpy(changes[pending].voterID, line, strlen(line) + 1);
+        changes[pending].op = REGISTRY_REMOVE;
+        requested++;
+        if (++pending == (size_t)batchSize) {
+            long count = removeBatch(tree, changes, pending);
+            if (count < 0) {
+                status = 1;
+                break;
+            }
+            removed += count;
+            pending = 0;
+        }
+    }
+    if (status == 0 && pending > 0) {
+        long count = removeBatch(tree, changes, pending);
+        if (count < 0) {
+            status = 1;
+        } else {
+            removed += count;
+        }
+    }
+    closeInput(input);
+    free(changes);
+
+    double seconds = elapsedSince(&start);
+    printf("Removed %lu voters (%lu not registered, %lu invalid) in %.2f s\n",
+           removed, requested - removed, invalid, seconds);
+    return status;
+}
+
+// Appends the blocks cast since the last commit and rewrites the registry once
+static int commitBatch(blockchain *bc, AVLTree *tree, block *lastCommitted) {
+    block *first = lastCommitted ? lastCommitted->next : bc->head;
+    if (first == NULL) {
+        return 0;
+    }
+    merkleAccumulatorRoot(&bc->merkle_acc, bc->merkle_root);
+    if (appendBlocksToFile(bc, first, CHAIN_FILE) != 0) {
+        return -1;
+    }
+    saveTreeToBinaryFile(tree, REGISTRY_FILE);
+    return 0;
+}
+
+// Sharded counterpart of commitBatch: each shard appends its own new blocks
+static int commitShardedBatch(shardedChain *sc, AVLTree *tree) {
+    if (persistShardedChain(sc) != 0) {
+        return -1;
+    }
+    saveTreeToBinaryFile(tree, REGISTRY_FILE);
+    return 0;
+}
+
+/*
+Casts one voterID,candidateID ballot per line. Lines with a missing field, a voter ID
+too long to be registered or a candidate not in candidates.txt are counted as invalid
+and skipped before the voter is marked, so they never use up the voter's ballot.
+With sc set the ballots go to its shards instead of bc.
+*/
+static int castBallots(blockchain *bc, shardedChain *sc, AVLTree *tree, const char *path, long batchSize) {
+    CandidateTable table;
+    prefixIndex candidates;
+    if (loadCandidateTable(&table, CANDIDATES_FILE) < 0) {
+        return 1;
+    }
+    if (buildCandidatePrefixIndex(&candidates, &table) != 0) {
+        freeCandidateTable(&table);
+        return 1;
+    }
+    FILE *input = openInput(path);
+    if (!input) {
+        freePrefixIndex(&candidates);
+        freeCandidateTable(&table);
+        return 1;
+    }
+    setvbuf(input, NULL, _IOFBF, CLI_INPUT_BUFFER);
+
+    char line[CLI_LINE_MAX];
+    unsigned long cast = 0, notRegistered = 0, alreadyVoted = 0, invalid = 0;
+    long pending = 0;
+    block *lastCommitted = sc ? NULL : bc->tail;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while (fgets(line, sizeof(line), input)) {
+        if (!trimLine(line)) {
+            continue;
+        }
+        char *voterID = strtok(line, ",");
+        char *candID = strtok(NULL, ",");
+        if (!voterID || !candID || strlen(voterID) >= VOTER_KEY_SIZE ||
+            !prefixIndexContains(&candidates, candID)) {
+            invalid++;
+            continue;
+        }
+
+        int status = updateVoting(tree, voterID);
+        if (status == -1) {
+            notRegistered++;
+            continue;
+        }
+        if (status == 1) {
+            alreadyVoted++;
+            continue;
+        }
+        block *appended = sc ? appendShardedBlock(sc, voterID, candID)
+                             : appendBlock(bc, voterID, candID);
+        if (appended == NULL) {
+            undoVoting(tree, voterID);  // the ballot never reached the chain
+            break;
+        }
+        cast++;
+
+        if (++pending >= batchSize) {
+            int committed = sc ? commitShardedBatch(sc, tree) : commitBatch(bc, tree, lastCommitted);
+            if (committed != 0) {
+                closeInput(input);
+                freePrefixIndex(&candidates);
+                freeCandidateTable(&table);
+                return 1;
+            }
+            lastCommitted = sc ? NULL : bc->tail;
+            pending = 0;
+        }
+    }
+    closeInput(input);
+    freePrefixIndex(&candidates);
+    freeCandidateTable(&table);
+
+    if ((sc ? commitShardedBatch(sc, tree) : commitBatch(bc, tree, lastCommitted)) != 0) {
+        return 1;
+    }
+
+    double seconds = elapsedSince(&start);
+    printf("Cast %lu votes (%lu not registered, %lu already voted, %lu invalid) in %.2f s (%.0f/s)\n",
+           cast, notRegistered, alreadyVoted, invalid, seconds, seconds > 0 ? cast / seconds : 0.0);
+    return 0;
+}
+
+// One cast thread's slice of a batch of ballot lines, and what became of them
+typedef struct castWorker {
+    sharedRegistry *registry;
+    blockchain *bc;
+    shardedChain *sc;
+    pthread_mutex_t *chainLock;  // guards bc; unused with sc
+    prefixIndex *candidates;
+    char (*lines)[CLI_LINE_MAX];
+    long count;
+    unsigned long cast, notRegistered, alreadyVoted, invalid;
+    int failed;
+} castWorker;
+
+static void *castWorkerThread(void *arg) {
+    castWorker *worker = (castWorker *)arg;
+
+    for (long i = 0; i < worker->count; i++) {
+        char *line = worker->lines[i];
+        char *save;
+        if (!trimLine(line)) {
+            continue;
+        }
+        char *voterID = strtok_r(line, ",", &save);
+        char *candID = strtok_r(NULL, ",", &save);
+        if (!voterID || !candID || strlen(voterID) >= VOTER_KEY_SIZE ||
+            !prefixIndexContains(worker->candidates, candID)) {
+            worker->invalid++;
+            continue;
+        }
+
+        // Lock-free check first; only a voter who looks eligible takes the writer lock
+        int status = sharedRegistryLookup(worker->registry, voterID);
+        if (status == 0) {
+            status = sharedRegistryMarkVoted(worker->registry, voterID);
+        }
+        if (status == -1) {
+            worker->notRegistered++;
+            continue;
+        }
+        if (status == 1) {
+            worker->alreadyVoted++;
+            continue;
+        }
+
+        block *appended;
+        if (worker->sc) {
+            appended = appendShardedBlock(worker->sc, voterID, candID);
+        } else {
+            pthread_mutex_lock(worker->chainLock);
+            appended = appendBlock(worker->bc, voterID, candID);
+            pthread_mutex_unlock(worker->chainLock);
+        }
+        if (appended == NULL) {
+            sharedRegistryUndoVoted(worker->registry, voterID);
+            worker->failed = 1;
+            break;
+        }
+        worker->cast++;
+    }
+    return NULL;
+}
+
+// Splits lines[0..count) into contiguous slices, one per thread, and waits for all of them
+static int castLinesParallel(castWorker *workers, int numThreads, char (*lines)[CLI_LINE_MAX], long count) {
+    pthread_t threads[CLI_MAX_THREADS];
+    int started[CLI_MAX_THREADS];
+    long slice = (count + numThreads - 1) / numThreads;
+    int failed = 0;
+
+    for (int t = 0; t < numThreads; t++) {
+        long first = slice * t < count ? slice * t : count;
+        workers[t].lines = lines + first;
+        workers[t].count = first + slice < count ? slice : count - first;
+        started[t] = pthread_create(&threads[t], NULL, castWorkerThread, &workers[t]) == 0;
+        if (!started[t]) {
+            castWorkerThread(&workers[t]);  // fall back to running it inline
+        }
+    }
+    for (int t = 0; t < numThreads; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+        failed |= workers[t].failed;
+    }
+    return failed ? -1 : 0;
+}
+
+/*
+castBallots with numThreads threads per batch; see --threads above. The registry is
+handed to a sharedRegistry for the run, and between batches, with every thread joined,
+the commit reads its tree directly.
+*/
+static int castBallotsParallel(blockchain *bc, shardedChain *sc, AVLTree *tree, const char *path,
+                               long batchSize, int numThreads) {
+    CandidateTable table;
+    prefixIndex candidates;
+    sharedRegistry registry;
+    pthread_mutex_t chainLock = PTHREAD_MUTEX_INITIALIZER;
+    castWorker workers[CLI_MAX_THREADS];
+    int status = 1;
+
+    if (loadCandidateTable(&table, CANDIDATES_FILE) < 0) {
+        return 1;
+    }
+    if (buildCandidatePrefixIndex(&candidates, &table) != 0) {
+        freeCandidateTable(&table);
+        return 1;
+    }
+    char (*lines)[CLI_LINE_MAX] = malloc((size_t)batchSize * CLI_LINE_MAX);
+    FILE *input = lines ? openInput(path) : NULL;
+    if (!lines || !input || initSharedRegistry(&registry, tree) != 0) {
+        if (!lines) printf("Memory allocation failed for %ld ballot lines\n", batchSize);
+        if (input) closeInput(input);
+        free(lines);
+        freePrefixIndex(&candidates);
+        freeCandidateTable(&table);
+        return 1;
+    }
+    setvbuf(input, NULL, _IOFBF, CLI_INPUT_BUFFER);
+
+    memset(workers, 0, sizeof(workers));
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].registry = &registry;
+        workers[t].bc = bc;
+        workers[t].sc = sc;
+        workers[t].chainLock = &chainLock;
+        workers[t].candidates = &candidates;
+    }
+
+    block *lastCommitted = sc ? NULL : bc->tail;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;) {
+        long count = 0;
+        while (count < batchSize && fgets(lines[count], CLI_LINE_MAX, input)) {
+            count++;
+        }
+        if (count == 0) {
+            status = 0;
+            break;
+        }
+        int cast = castLinesParallel(workers, numThreads, lines, count);
+        int committed = sc ? commitShardedBatch(sc, &registry.tree)
+                           : commitBatch(bc, &registry.tree, lastCommitted);
+        if (cast != 0 || committed != 0) {
+            break;
+        }
+        lastCommitted = sc ? NULL : bc->tail;
+    }
+    closeInput(input);
+
+    unsigned long cast = 0, notRegistered = 0, alreadyVoted = 0, invalid = 0;
+    for (int t = 0; t < numThreads; t++) {
+        cast += workers[t].cast;
+        notRegistered += workers[t].notRegistered;
+        alreadyVoted += workers[t].alreadyVoted;
+        invalid += workers[t].invalid;
+    }
+    if (status == 0) {
+        double seconds = elapsedSince(&start);
+        printf("Cast %lu votes (%lu not registered, %lu already voted, %lu invalid) in %.2f s (%.0f/s, %d threads)\n",
+               cast, notRegistered, alreadyVoted, invalid, seconds, seconds > 0 ? cast / seconds : 0.0,
+               numThreads);
+    }
+
+    destroySharedRegistry(&registry);
+    pthread_mutex_destroy(&chainLock);
+    free(lines);
+    freePrefixIndex(&candidates);
+    freeCandidateTable(&table);
+    return status;
+}
+
+static int verify(blockchain *bc) {
+    int check = verifyBlocks(bc, 0);
+    if (check == -1) {
+        printf("Blockchain is empty.\n");
+        return 0;
+    }
+    printf(check ? "Blockchain verified: %lu blocks intact.\n"
+                 : "Blockchain verification FAILED (%lu blocks).\n", bc->length);
+    return check ? 0 : 1;
+}
+
+static int tally(blockchain *bc) {
+    CandidateTable table;
+    if (loadCandidateTable(&table, CANDIDATES_FILE) < 0) {
+        return 1;
+    }
+    int *votes = calloc(table.count > 0 ? table.count : 1, sizeof(int));
+    if (!votes) {
+        printf("Memory allocation failed\n");
+        freeCandidateTable(&table);
+        return 1;
+    }
+    chainSnapshot snapshot;
+    captureChainSnapshot(bc, &snapshot);
+    int intact = tallyChainSnapshot(&snapshot, table.items, table.count, votes, 0);
+    if (intact < 0) {
+        free(votes);
+        freeCandidateTable(&table);
+        return 1;
+    }
+
+    unsigned long counted = 0;
+    for (int i = 0; i < table.count; i++) {
+        printf("%s,%s,%d\n", table.items[i].id, table.items[i].name, votes[i]);
+        counted += votes[i];
+    }
+    printf("Total: %lu votes, %lu for unknown candidates\n", snapshot.length, snapshot.length - counted);
+    printf("Merkle root: ");
+    hashPrinter(snapshot.root, SHA256_DIGEST_LENGTH);
+    if (!intact) {
+        printf("Integrity disrupted; Merkle root does not match.\n");
+    }
+
+    free(votes);
+    freeCandidateTable(&table);
+    return intact ? 0 : 1;
+}
+
+static int tallyShards(shardedChain *sc) {
+    CandidateTable table;
+    if (loadCandidateTable(&table, CANDIDATES_FILE) < 0) {
+        return 1;
+    }
+    int intact = countShardedVotes(sc, table.items, table.count);
+    freeCandidateTable(&table);
+    return intact == 1 ? 0 : 1;
+}
+
+static int tallyWindow(const char *fromArg, const char *toArg) {
+    CandidateTable table;
+    chainIndex index;
+    char *end;
+    long long from = fromArg ? strtoll(fromArg, &end, 10) : 0;
+    int fromValid = fromArg && *end == '\0';
+    long long to = toArg ? strtoll(toArg, &end, 10) : 0;
+    if (!fromValid || !toArg || *end != '\0') {
+        printf("tally-window needs two unix times\n");
+        return 1;
+    }
+    if (loadCandidateTable(&table, CANDIDATES_FILE) < 0) {
+        return 1;
+    }
+    int *votes = calloc(table.count > 0 ? table.count : 1, sizeof(int));
+    if (!votes || openChainIndex(&index, CHAIN_FILE) != 0) {
+        if (!votes) printf("Memory allocation failed\n");
+        free(votes);
+        freeCandidateTable(&table);
+        return 1;
+    }
+    long inWindow = tallyChainTimeRange(&index, from, to, table.items, table.count, votes);
+    closeChainIndex(&index);
+
+    long counted = 0;
+    for (int i = 0; inWindow >= 0 && i < table.count; i++) {
+        printf("%s,%s,%d\n", table.items[i].id, table.items[i].name, votes[i]);
+        counted += votes[i];
+    }
+    if (inWindow >= 0) {
+        printf("Total: %ld votes in [%lld, %lld), %ld for unknown candidates\n",
+               inWindow, from, to, inWindow - counted);
+    }
+    free(votes);
+    freeCandidateTable(&table);
+    return inWindow >= 0 ? 0 : 1;
+}
+
+static int showBlock(const char *seqArg) {
+    chainIndex index;
+    chainRecord record;
+    char *end;
+    unsigned long long seq = seqArg ? strtoull(seqArg, &end, 10) : 0;
+    if (!seqArg || *end != '\0') {
+        printf("block needs a sequence number\n");
+        return 1;
+    }
+    if (openChainIndex(&index, CHAIN_FILE) != 0) {
+        return 1;
+    }
+    int found = readChainBlock(&index, seq, &record) == 0;
+    closeChainIndex(&index);
+    if (!found) {
+        printf("No block %llu\n", seq);
+        return 1;
+    }
+    char hex[2 * SHA256_DIGEST_LENGTH + 1];
+    hashToHex(record.prevhash, SHA256_DIGEST_LENGTH, hex);
+    printf("Block %llu\n", (unsigned long long)record.seq);
+    printf("Time:      %lld\n", (long long)record.timestamp);
+    printf("Voter:     %s\n", record.voterID);
+    printf("Candidate: %s\n", record.candID);
+    printf("Prevhash:  %s\n", hex);
+    return 0;
+}
+
+static int seal(blockchain *bc, const char *rowsArg) {
+    long deadline;
+    char *end;
+    unsigned long rows = rowsArg ? strtoul(rowsArg, &end, 10) : SEGMENT_ROWS;
+    if (rowsArg && (*end != '\0' || rows == 0 || rows > UINT32_MAX)) {
+        printf("seal needs a number of rows per segment\n");
+        return 1;
+    }
+    // The GUI keeps appending to the chain file until the deadline
+    if (loadVotingDeadline(DEADLINE_FILE, &deadline) == 0 && time(NULL) < deadline) {
+        printf("Voting is still open; seal after the deadline\n");
+        return 1;
+    }
+    initializeBlockchain(bc);
+    long sealed = sealChain(bc, CHAIN_FILE, (uint32_t)rows);
+    if (sealed < 0) {
+        return 1;
+    }
+    printf("Sealed %ld blocks, %lu of %lu blocks are in segments\n", sealed, bc->sealed, bc->length);
+    return 0;
+}
+
+static void stats(blockchain *bc, shardedChain *sc, AVLTree *tree) {
+    registryStats *s = &tree->stats;
+    printf("Registered voters: %lu\n", s->registered);
+    printf("Voted:             %lu (%.1f%%)\n", s->voted,
+           s->registered ? 100.0 * s->voted / s->registered : 0.0);
+    if (sc) {
+        unsigned long length = 0;
+        unsigned char root[SHA256_DIGEST_LENGTH];
+        for (int i = 0; i < sc->numShards; i++) {
+            length += sc->shards[i].length;
+        }
+        calculateShardedRoot(sc, root);
+        printf("Chain length:      %lu blocks in %d shards\n", length, sc->numShards);
+        printf("Top-level root:    ");
+        hashPrinter(root, SHA256_DIGEST_LENGTH);
+        return;
+    }
+    printf("Chain length:      %lu blocks (%lu sealed)\n", bc->length, bc->sealed);
+    printf("Merkle root:       ");
+    hashPrinter(bc->merkle_root, SHA256_DIGEST_LENGTH);
+}
+
+int main(int argc, char *argv[]) {
+    static shardedChain shards;  // too large for the stack with MAX_SHARDS chains
+    long batchSize = CLI_DEFAULT_BATCH;
+    int numShards = 0;
+    int precinctPrefixLen = -1;  // unset; routing then hashes the whole ID
+    int numThreads = 0;
+    int arg = 1;
+
+    while (arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0) {
+        if (strcmp(argv[arg], "--batch") == 0) {
+            batchSize = atol(argv[arg + 1]);
+            if (batchSize <= 0) {
+                batchSize = CLI_DEFAULT_BATCH;
+            }
+        } else if (strcmp(argv[arg], "--shards") == 0) {
+            numShards = atoi(argv[arg + 1]);
+            if (numShards < 1 || numShards > MAX_SHARDS) {
+                printf("--shards must be between 1 and %d\n", MAX_SHARDS);
+                return 1;
+            }
+        } else if (strcmp(argv[arg], "--precinct-prefix") == 0) {
+            char *end;
+            long length = strtol(argv[arg + 1], &end, 10);
+            if (*end != '\0' || length < 1 || length >= VOTER_KEY_SIZE) {
+                printf("--precinct-prefix must be between 1 and %d\n", VOTER_KEY_SIZE - 1);
+                return 1;
+            }
+            precinctPrefixLen = (int)length;
+        } else if (strcmp(argv[arg], "--threads") == 0) {
+            numThreads = atoi(argv[arg + 1]);
+            if (numThreads < 1 || numThreads > CLI_MAX_THREADS) {
+                printf("--threads must be between 1 and %d\n", CLI_MAX_THREADS);
+                return 1;
+            }
+        } else {
+            break;
+        }
+        arg += 2;
+    }
+    if (arg >= argc) {
+        usage(argv[0]);
+        return 1;
+    }
+    const char *command = argv[arg];
+    const char *operand = arg + 1 < argc ? argv[arg + 1] : NULL;
+
+    blockchain bc;
+    AVLTree voterTree;
+    shardedChain *sc = NULL;
+    int status = 0;
+
+    if (precinctPrefixLen > 0 && numShards == 0) {
+        printf("--precinct-prefix only applies with --shards\n");
+        return 1;
+    }
+    if (numShards > 0) {
+        if (strcmp(command, "tally-window") == 0 || strcmp(command, "block") == 0 ||
+            strcmp(command, "export") == 0 || strcmp(command, "seal") == 0) {
+            printf("%s reads the single chain file and does not support --shards\n", command);
+            return 1;
+        }
+        if (strcmp(command, "cast") == 0 || strcmp(command, "verify") == 0 ||
+            strcmp(command, "tally") == 0 || strcmp(command, "stats") == 0) {
+            sc = &shards;
+        }
+    }
+
+    METRICS_START_REPORTER(METRICS_DEFAULT_FILE, METRICS_DEFAULT_INTERVAL_MS);
+    logStart();
+
+    if (sc && initializeShardedChain(sc, numShards, precinctPrefixLen > 0 ? precinctPrefixLen : 0) != 0) {
+        status = 1;
+    } else if (strcmp(command, "import-voters") == 0) {
+        initializeTree(&voterTree);
+        status = importVoters(&voterTree, operand, batchSize);
+    } else if (strcmp(command, "remove-voters") == 0) {
+        initializeTree(&voterTree);
+        status = removeVoters(&voterTree, operand, batchSize);
+    } else if (strcmp(command, "cast") == 0) {
+        initializeTree(&voterTree);
+        if (!sc) initializeBlockchain(&bc);
+        status = numThreads > 0 ? castBallotsParallel(&bc, sc, &voterTree, operand, batchSize, numThreads)
+                                : castBallots(&bc, sc, &voterTree, operand, batchSize);
+    } else if (strcmp(command, "verify") == 0) {
+        if (sc) {
+            status = verifyShardedChain(sc) ? 0 : 1;
+        } else {
+            initializeBlockchain(&bc);
+            status = verify(&bc);
+        }
+    } else if (strcmp(command, "tally") == 0) {
+        if (sc) {
+            status = tallyShards(sc);
+        } else {
+            initializeBlockchain(&bc);
+            status = tally(&bc);
+        }
+    } else if (strcmp(command, "tally-window") == 0) {
+        status = tallyWindow(operand, arg + 2 < argc ? argv[arg + 2] : NULL);
+    } else if (strcmp(command, "block") == 0) {
+        status = showBlock(operand);
+    } else if (strcmp(command, "export") == 0) {
+        if (!operand) {
+            usage(argv[0]);
+            status = 1;
+        } else {
+            initializeBlockchain(&bc);
+            status = exportChainColumns(&bc, operand) == 0 ? 0 : 1;
+        }
+    } else if (strcmp(command, "seal") == 0) {
+        status = seal(&bc, operand);
+    } else if (strcmp(command, "stats") == 0) {
+        initializeTree(&voterTree);
+        if (!sc) initializeBlockchain(&bc);
+        stats(&bc, sc, &voterTree);
+    } else {
+        usage(argv[0]);
+        status = 1;
+    }
+    if (sc && sc->numShards > 0) {
+        destroyShardedChain(sc);
+    }
+
+    logStop();
+    METRICS_STOP_REPORTER();
+    return status;
+}
@@ -0,0 +1,216 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "commitworker.h"
+#include "logging.h"
+
+static void pushResult(commitWorker *worker, commitRequest *request, int status, uint64_t seq) {
+    SDL_Event event;
+    commitResult *result = malloc(sizeof(commitResult));
+
+    if (result) {
+        snprintf(result->voterID, sizeof(result->voterID), "%s", request->voterID);
+        snprintf(result->candID, sizeof(result->candID), "%s", request->candID);
+        result->latencyMs = SDL_GetTicks() - request->enqueuedTicks;
+        result->seq = seq;
+    }
+    memset(&event, 0, sizeof(event));
+    event.type = worker->doneEvent;
+    event.user.code = status;
+    event.user.data1 = result;
+    if (SDL_PushEvent(&event) < 0) {
+        free(result);
+    }
+}
+
+/*
+Applies one batch: every ballot is checked and appended in memory and the registry is
+copied, all under dataLock. The files are written after the lock is released: only
+the new blocks are appended to the chain file, which is safe unlocked because this
+thread is the only one that appends. Completion events go out once the blocks are on
+disk; if the append fails those ballots report COMMIT_FAILED and their blocks are
+appended again with the next batch.
+*/
+static void commitBatch(commitWorker *worker, commitRequest *batch, int n, int saveRegistry) {
+    int status[COMMIT_QUEUE_SIZE];
+    uint64_t seq[COMMIT_QUEUE_SIZE];
+    int appended = 0;
+    registryImage image;
+    int haveImage = 0;
+
+    SDL_LockMutex(worker->dataLock);
+    for (int i = 0; i < n; i++) {
+        block *appendedBlock = NULL;
+        // Marking first makes the worker the single authority on double votes
+        int update = updateVoting(worker->voterTree, batch[i].voterID);
+        if (update == 1) {
+            status[i] = COMMIT_ALREADY_VOTED;
+        } else if (update == -1) {
+            status[i] = COMMIT_NOT_REGISTERED;
+        } else if ((appendedBlock = appendBlock(worker->bc, batch[i].voterID, batch[i].candID)) == NULL) {
+            undoVoting(worker->voterTree, batch[i].voterID);  // no block, so the voter may retry
+            status[i] = COMMIT_FAILED;
+        } else {
+            status[i] = COMMIT_OK;
+            appended++;
+        }
+        seq[i] = appendedBlock ? appendedBlock->seq : UINT64_MAX;
+    }
+    if (appended > 0) {
+        merkleAccumulatorRoot(&worker->bc->merkle_acc, worker->bc->merkle_root);
+    }
+    block *first = worker->persisted ? worker->persisted->next : worker->bc->head;
+    block *last = worker->bc->tail;
+    if (appended > 0 || saveRegistry) {
+        haveImage = captureRegistryImage(worker->voterTree, &image) == 0;
+    }
+    SDL_UnlockMutex(worker->dataLock);
+
+    if (first != NULL) {
+        if (appendBlocksToFile(worker->bc, first, "blockchain_data.bin") == 0) {
+            worker->persisted = last;
+        } else {
+            LOG_ERROR("worker", "Chain file append failed; retrying with the next batch");
+            for (int i = 0; i < n; i++) {
+                if (status[i] == COMMIT_OK) status[i] = COMMIT_FAILED;
+            }
+        }
+    }
+    if (haveImage) {
+        writeRegistryImage(&image, "voter_data.bin");
+        freeRegistryImage(&image);
+    }
+
+    for (int i = 0; i < n; i++) {
+        pushResult(worker, &batch[i], status[i], seq[i]);
+    }
+}
+
+static int commitThread(void *data) {
+    commitWorker *worker = (commitWorker *)data;
+    commitRequest batch[COMMIT_QUEUE_SIZE];
+
+    for (;;) {
+        SDL_LockMutex(worker->queueLock);
+        while (worker->count == 0 && !worker->saveRegistry && !worker->stop) {
+            SDL_CondWait(worker->queueCond, worker->queueLock);
+        }
+        if (worker->count == 0 && !worker->saveRegistry && worker->stop) {
+            SDL_UnlockMutex(worker->queueLock);
+            break;
+        }
+        int saveRegistry = worker->saveRegistry;
+        worker->saveRegistry = 0;
+        // Take everything that is waiting as one batch
+        int n = worker->count;
+        for (int i = 0; i < n; i++) {
+            batch[i] = worker->queue[(worker->head + i) % COMMIT_QUEUE_SIZE];
+        }
+        worker->head = (worker->head + n) % COMMIT_QUEUE_SIZE;
+        worker->count = 0;
+        SDL_UnlockMutex(worker->queueLock);
+
+        commitBatch(worker, batch, n, saveRegistry);
+    }
+    return 0;
+}
+
+// Returns 0 on success and -1 if the worker thread could not be started.
+int startCommitWorker(commitWorker *worker, blockchain *bc, AVLTree *voterTree) {
+    memset(worker, 0, sizeof(*worker));
+    worker->bc = bc;
+    worker->voterTree = voterTree;
+    worker->persisted = bc->tail;  // the chain was just loaded from its file
+    worker->dataLock = SDL_CreateMutex();
+    worker->queueLock = SDL_CreateMutex();
+    worker->queueCond = SDL_CreateCond();
+    worker->doneEvent = SDL_RegisterEvents(1);
+    if (!worker->dataLock || !worker->queueLock || !worker->queueCond) {
+        LOG_ERROR("worker", "Failed to create commit worker locks: %s", SDL_GetError());
+        return -1;
+    }
+
+    worker->thread = SDL_CreateThread(commitThread, "commit-worker", worker);
+    if (worker->thread == NULL) {
+        LOG_ERROR("worker", "Failed to start commit worker: %s", SDL_GetError());
+        return -1;
+    }
+    return 0;
+}
+
+// Queues a ballot for commit. Returns 0 if queued and -1 if the queue is full.
+int enqueueBallot(commitWorker *worker, const char *voterID, const char *candID) {
+    int status = -1;
+
+    SDL_LockMutex(worker->queueLock);
+    if (worker->count < COMMIT_QUEUE_SIZE && !worker->stop) {
+        commitRequest *request = &worker->queue[(worker->head + worker->count) % COMMIT_QUEUE_SIZE];
+        snprintf(request->voterID, sizeof(request->voterID), "%s", voterID);
+        snprintf(request->candID, sizeof(request->candID), "%s", candID);
+        request->enqueuedTicks = SDL_GetTicks();
+        worker->count++;
+        SDL_CondSignal(worker->queueCond);
+        status = 0;
+    }
+    SDL_UnlockMutex(worker->queueLock);
+    return status;
+}
+
+/*
+Checks a ballot from the UI and queues it. The voter must be registered and not have
+voted, and candID must be exactly one of the indexed candidates; both are checked under
+dataLock. A refused ballot never reaches the worker, so it cannot use up the voter's
+vote. The worker still re-checks the voter, since another ballot may get there first.
+*/
+int submitBallot(commitWorker *worker, prefixIndex *candidates, const char *voterID, const char *candID) {
+    char id[VOTER_KEY_SIZE + 1];
+    int status = SUBMIT_QUEUED;
+
+    snprintf(id, sizeof(id), "%s", voterID);
+    SDL_LockMutex(worker->dataLock);
+    VoterNode *voter = findVoter(worker->voterTree, id);
+    if (voter == NULL) {
+        status = SUBMIT_NOT_REGISTERED;
+    } else if (voter->voted) {
+        status = SUBMIT_ALREADY_VOTED;
+    } else if (!prefixIndexContains(candidates, candID)) {
+        status = SUBMIT_UNKNOWN_CANDIDATE;
+    }
+    SDL_UnlockMutex(worker->dataLock);
+
+    if (status == SUBMIT_QUEUED && enqueueBallot(worker, voterID, candID) != 0) {
+        status = SUBMIT_QUEUE_FULL;
+    }
+    return status;
+}
+
+/*
+Asks the worker to write the registry file, for changes the UI made under dataLock.
+Requests made while a write is pending are merged into it.
+*/
+void requestRegistrySave(commitWorker *worker) {
+    SDL_LockMutex(worker->queueLock);
+    worker->saveRegistry = 1;
+    SDL_CondSignal(worker->queueCond);
+    SDL_UnlockMutex(worker->queueLock);
+}
+
+// Commits everything still queued, then stops the thread. Safe to call twice.
+void stopCommitWorker(commitWorker *worker) {
+    if (worker->thread) {
+        SDL_LockMutex(worker->queueLock);
+        worker->stop = 1;
+        SDL_CondSignal(worker->queueCond);
+        SDL_UnlockMutex(worker->queueLock);
+        SDL_WaitThread(worker->thread, NULL);
+        worker->thread = NULL;
+    }
+    if (worker->queueCond) SDL_DestroyCond(worker->queueCond);
+    if (worker->queueLock) SDL_DestroyMutex(worker->queueLock);
+    if (worker->dataLock) SDL_DestroyMutex(worker->dataLock);
+    worker->queueCond = NULL;
+    worker->queueLock = NULL;
+    worker->dataLock = NULL;
+}
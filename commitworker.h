@@ -0,0 +1,75 @@
+#ifndef COMMITWORKER_H
+#define COMMITWORKER_H
+
+#include <SDL2/SDL.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "prefixindex.h"
+
+#define COMMIT_QUEUE_SIZE 256
+
+/*
+Background commit worker for the GUI.
+The UI thread enqueues a ballot and returns immediately; the worker marks the voter,
+appends the block and writes the chain and registry files, then pushes a doneEvent whose
+user.code is the commit status and whose data1 is a malloc'd commitResult that the
+receiver must free. Ballots that queue up while a commit is running are written together:
+their blocks are appended to the chain file and the registry is written once per batch.
+
+dataLock guards the chain and the voter tree; the UI must hold it whenever it reads or
+modifies either of them. It is never held during file I/O. The worker is the only thread
+that appends blocks or writes the files; the UI asks for a registry write after changing
+the tree with requestRegistrySave.
+*/
+enum {
+    COMMIT_OK = 0,
+    COMMIT_ALREADY_VOTED = 1,
+    COMMIT_NOT_REGISTERED = 2,
+    COMMIT_FAILED = 3
+};
+
+// Outcome of submitBallot; only SUBMIT_QUEUED hands the ballot to the worker
+enum {
+    SUBMIT_QUEUED = 0,
+    SUBMIT_NOT_REGISTERED,
+    SUBMIT_ALREADY_VOTED,
+    SUBMIT_UNKNOWN_CANDIDATE,
+    SUBMIT_QUEUE_FULL
+};
+
+typedef struct commitRequest {
+    char voterID[16];
+    char candID[32];
+    Uint32 enqueuedTicks;
+} commitRequest;
+
+typedef struct commitResult {
+    char voterID[16];
+    char candID[32];
+    Uint32 latencyMs;   // enqueue to durable
+    uint64_t seq;       // sequence number of the ballot's block; UINT64_MAX if none
+} commitResult;
+
+typedef struct commitWorker {
+    blockchain *bc;
+    AVLTree *voterTree;
+    SDL_mutex *dataLock;
+    SDL_mutex *queueLock;
+    SDL_cond *queueCond;
+    commitRequest queue[COMMIT_QUEUE_SIZE];
+    int head;
+    int count;
+    int stop;
+    int saveRegistry;    // registry write requested by the UI
+    block *persisted;    // last block in the chain file; worker thread only
+    Uint32 doneEvent;
+    SDL_Thread *thread;
+} commitWorker;
+
+int startCommitWorker(commitWorker *worker, blockchain *bc, AVLTree *voterTree);
+int enqueueBallot(commitWorker *worker, const char *voterID, const char *candID);
+int submitBallot(commitWorker *worker, prefixIndex *candidates, const char *voterID, const char *candID);
+void requestRegistrySave(commitWorker *worker);
+void stopCommitWorker(commitWorker *worker);
+
+#endif
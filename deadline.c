@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <libgen.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#include "blockchain.h"
+#include "deadline.h"
+
+#define MAX_TIMER_MS (24u * 60u * 60u * 1000u)  // longer waits are split into daily hops
+
+// Milliseconds from now until the deadline, clamped to what one timer hop may wait.
+static Uint32 msUntil(time_t deadline) {
+    time_t now = time(NULL);
+    if (deadline <= now) return 1;
+    double ms = difftime(deadline, now) * 1000.0;
+    return ms > MAX_TIMER_MS ? MAX_TIMER_MS : (Uint32)ms;
+}
+
+static void pushEvent(Uint32 type) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = type;
+    SDL_PushEvent(&event);
+}
+
+// Runs on SDL's timer thread; re-arms itself until the wall clock passes the deadline.
+static Uint32 deadlineTimerCallback(Uint32 interval, void *param) {
+    deadlineWatch *watch = (deadlineWatch *)param;
+    time_t deadline = currentDeadline(watch);
+    (void)interval;
+
+    if (time(NULL) >= deadline) {
+        pushEvent(watch->endEvent);
+        return 0;
+    }
+    return msUntil(deadline);
+}
+
+static void armTimer(deadlineWatch *watch) {
+    if (watch->timer) SDL_RemoveTimer(watch->timer);
+    watch->timer = SDL_AddTimer(msUntil(currentDeadline(watch)), deadlineTimerCallback, watch);
+    if (watch->timer == 0) {
+        printf("Failed to arm voting deadline timer: %s\n", SDL_GetError());
+    }
+}
+
+#ifdef __linux__
+/*
+Watches the directory rather than the file so that editors which replace the file
+(write to a temp file, then rename) are noticed too.
+*/
+static int deadlineWatchThread(void *data) {
+    deadlineWatch *watch = (deadlineWatch *)data;
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char path[256];
+
+    snprintf(path, sizeof(path), "%s", watch->filename);
+    const char *name = basename(path);
+
+    while (!__atomic_load_n(&watch->stop, __ATOMIC_ACQUIRE)) {
+        struct pollfd pfd = {watch->inotifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, 250) <= 0) continue;
+
+        ssize_t len = read(watch->inotifyFd, buffer, sizeof(buffer));
+        for (char *p = buffer; len > 0 && p < buffer + len; ) {
+            struct inotify_event *event = (struct inotify_event *)p;
+            if (event->len > 0 && strcmp(event->name, name) == 0) {
+                pushEvent(watch->changedEvent);
+            }
+            p += sizeof(struct inotify_event) + event->len;
+        }
+    }
+    return 0;
+}
+#endif
+
+/*
+Loads the deadline, arms the timer and starts the file watch.
+Requires SDL_INIT_TIMER. Returns 0 on success and -1 if the file cannot be read.
+*/
+int startDeadlineWatch(deadlineWatch *watch, const char *filename) {
+    long deadline;
+
+    memset(watch, 0, sizeof(*watch));
+    snprintf(watch->filename, sizeof(watch->filename), "%s", filename);
+    watch->inotifyFd = -1;
+    if (loadVotingDeadline(filename, &deadline) != 0) {
+        printf("Error: Could not read voting deadline from %s\n", filename);
+        return -1;
+    }
+    __atomic_store_n(&watch->deadline, (time_t)deadline, __ATOMIC_RELEASE);
+    watch->endEvent = SDL_RegisterEvents(2);
+    watch->changedEvent = watch->endEvent + 1;
+    armTimer(watch);
+
+#ifdef __linux__
+    char dir[256];
+    snprintf(dir, sizeof(dir), "%s", filename);
+    watch->inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->inotifyFd >= 0 &&
+        inotify_add_watch(watch->inotifyFd, dirname(dir), IN_CLOSE_WRITE | IN_MOVED_TO) >= 0) {
+        watch->thread = SDL_CreateThread(deadlineWatchThread, "deadline-watch", watch);
+    } else {
+        perror("Failed to watch voting deadline file");
+    }
+#endif
+    return 0;
+}
+
+/*
+Rereads the file after a change notification and re-arms the timer.
+Returns 1 if the deadline moved, 0 if unchanged and -1 if the file could not be read.
+*/
+int reloadDeadline(deadlineWatch *watch) {
+    long deadline;
+
+    if (loadVotingDeadline(watch->filename, &deadline) != 0) {
+        return -1;
+    }
+    if ((time_t)deadline == currentDeadline(watch)) {
+        return 0;
+    }
+    __atomic_store_n(&watch->deadline, (time_t)deadline, __ATOMIC_RELEASE);
+    armTimer(watch);
+    printf("Voting deadline changed to: %ld (Unix timestamp)\n", deadline);
+    return 1;
+}
+
+// The deadline as last loaded; safe to call from any thread
+time_t currentDeadline(const deadlineWatch *watch) {
+    return __atomic_load_n(&watch->deadline, __ATOMIC_ACQUIRE);
+}
+
+void stopDeadlineWatch(deadlineWatch *watch) {
+    __atomic_store_n(&watch->stop, 1, __ATOMIC_RELEASE);
+    if (watch->timer) SDL_RemoveTimer(watch->timer);
+    watch->timer = 0;
+    if (watch->thread) SDL_WaitThread(watch->thread, NULL);
+    watch->thread = NULL;
+    if (watch->inotifyFd >= 0) close(watch->inotifyFd);
+    watch->inotifyFd = -1;
+}
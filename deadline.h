@@ -0,0 +1,32 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <time.h>
+#include <SDL2/SDL.h>
+
+/*
+Voting-deadline watcher for the GUI.
+The deadline is read from the file once and armed as an SDL timer that pushes an
+endEvent into the event loop when voting closes. On Linux an inotify thread watches
+the file; when an admin rewrites it a changedEvent is pushed and the loop calls
+reloadDeadline, which rereads the file and re-arms the timer. Nothing polls the file.
+The timer callback runs on SDL's timer thread, so deadline is only read through
+currentDeadline and stored atomically.
+*/
+typedef struct deadlineWatch {
+    char filename[256];
+    time_t deadline;  // atomic; see currentDeadline
+    Uint32 endEvent;
+    Uint32 changedEvent;
+    SDL_TimerID timer;
+    SDL_Thread *thread;
+    int inotifyFd;
+    int stop;  // atomic
+} deadlineWatch;
+
+int startDeadlineWatch(deadlineWatch *watch, const char *filename);
+int reloadDeadline(deadlineWatch *watch);
+time_t currentDeadline(const deadlineWatch *watch);
+void stopDeadlineWatch(deadlineWatch *watch);
+
+#endif
@@ -0,0 +1,239 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "blockchain.h"
+#include "export.h"
+
+static int compareStrings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/*
+Sorts and de-duplicates ids in place. Returns the number of distinct IDs and stores
+the longest ID length plus one in width.
+*/
+static uint32_t buildDictionary(char **ids, uint64_t n, size_t *width) {
+    uint32_t distinct = 0;
+
+    *width = 1;
+    if (n == 0) return 0;
+    qsort(ids, n, sizeof(char *), compareStrings);
+    for (uint64_t i = 0; i < n; i++) {
+        if (distinct == 0 || strcmp(ids[distinct - 1], ids[i]) != 0) {
+            ids[distinct++] = ids[i];
+            size_t len = strlen(ids[i]) + 1;
+            if (len > *width) *width = len;
+        }
+    }
+    return distinct;
+}
+
+static uint32_t dictionaryOrdinal(char **dict, uint32_t count, const char *id) {
+    char **found = bsearch(&id, dict, count, sizeof(char *), compareStrings);
+    return (uint32_t)(found - dict);
+}
+
+// Writes a header plus rowCount elements from data into dir/file.
+static int writeColumn(const char *dir, const char *file, uint32_t type, uint32_t elemSize,
+                       uint64_t rowCount, const void *data) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        perror("Failed to open column file for writing");
+        return -1;
+    }
+
+    columnHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, COLUMN_MAGIC, sizeof(header.magic));
+    header.type = type;
+    header.elemSize = elemSize;
+    header.rowCount = rowCount;
+    snprintf(header.name, sizeof(header.name), "%.*s", (int)(strcspn(file, ".")), file);
+
+    int status = 0;
+    if (fwrite(&header, sizeof(header), 1, out) != 1 ||
+        (rowCount > 0 && fwrite(data, elemSize, rowCount, out) != rowCount)) {
+        perror("Failed to write column file");
+        status = -1;
+    }
+    fclose(out);
+    return status;
+}
+
+// Writes dict as a fixed-width, NUL padded byte column.
+static int writeDictionary(const char *dir, const char *file, char **dict, uint32_t count, size_t width) {
+    char *packed = calloc(count ? count : 1, width);
+    if (packed == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(packed + (size_t)i * width, dict[i], strlen(dict[i]));
+    }
+    int status = writeColumn(dir, file, COLUMN_BYTES, (uint32_t)width, count, packed);
+    free(packed);
+    return status;
+}
+
+/*
+Exports the chain into dir (created if needed) using the layout described in export.h.
+Columns are built one at a time so peak memory is one u64 per block plus the dictionaries.
+Returns 0 on success and -1 on failure.
+*/
+int exportChainColumns(blockchain *bc, const char *dir) {
+    uint64_t rows = bc->length;
+    char **voterDict = malloc((rows ? rows : 1) * sizeof(char *));
+    char **candDict = malloc((rows ? rows : 1) * sizeof(char *));
+    void *column = malloc((rows ? rows : 1) * SHA256_DIGEST_LENGTH);
+    int status = -1;
+
+    if (voterDict == NULL || candDict == NULL || column == NULL) {
+        printf("Memory allocation failed\n");
+        goto done;
+    }
+    if (mkdir(dir, 0755) != 0) {
+        struct stat st;
+        if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode)) {
+            perror("Failed to create export directory");
+            goto done;
+        }
+    }
+
+    uint64_t i = 0;
+    for (block *b = bc->head; b != NULL && i < rows; b = b->next, i++) {
+        voterDict[i] = b->voterID;
+        candDict[i] = b->candID;
+    }
+    size_t voterWidth, candWidth;
+    uint32_t voterCount = buildDictionary(voterDict, rows, &voterWidth);
+    uint32_t candCount = buildDictionary(candDict, rows, &candWidth);
+
+    uint64_t *u64 = column;
+    i = 0;
+    for (block *b = bc->head; b != NULL && i < rows; b = b->next, i++) {
+        u64[i] = b->seq;
+    }
+    if (writeColumn(dir, "seq.col", COLUMN_U64, 8, rows, column)) goto done;
+
+    uint32_t *u32 = column;
+    i = 0;
+    for (block *b = bc->head; b != NULL && i < rows; b = b->next, i++) {
+        u32[i] = dictionaryOrdinal(voterDict, voterCount, b->voterID);
+    }
+    if (writeColumn(dir, "voter.col", COLUMN_U32, 4, rows, column)) goto done;
+
+    i = 0;
+    for (block *b = bc->head; b != NULL && i < rows; b = b->next, i++) {
+        u32[i] = dictionaryOrdinal(candDict, candCount, b->candID);
+    }
+    if (writeColumn(dir, "cand.col", COLUMN_U32, 4, rows, column)) goto done;
+
+    int64_t *i64 = column;
+    i = 0;
+    for (block *b = bc->head; b != NULL && i < rows; b = b->next, i++) {
+        i64[i] = b->timestamp;
+    }
+    if (writeColumn(dir, "ts.col", COLUMN_I64, 8, rows, column)) goto done;
+
+    unsigned char *digests = column;
+    i = 0;
+    for (block *b = bc->head; b != NULL && i < rows; b = b->next, i++) {
+        hashBlock(b, digests + i * SHA256_DIGEST_LENGTH);
+    }
+    if (writeColumn(dir, "digest.col", COLUMN_BYTES, SHA256_DIGEST_LENGTH, rows, column)) goto done;
+
+    if (writeDictionary(dir, "voters.dict", voterDict, voterCount, voterWidth)) goto done;
+    if (writeDictionary(dir, "candidates.dict", candDict, candCount, candWidth)) goto done;
+
+    printf("Exported %lu blocks (%u voters, %u candidates) to %s.\n",
+           (unsigned long)rows, voterCount, candCount, dir);
+    status = 0;
+
+done:
+    free(voterDict);
+    free(candDict);
+    free(column);
+    return status;
+}
+
+/*
+Maps dir/file read-only and validates its header against the expected element type and
+size; elemSize 0 accepts any size, for the variable-width dictionaries.
+Returns 0 on success and -1 if the file is missing, not a column file or of another type.
+*/
+int mapColumn(const char *dir, const char *file, uint32_t type, uint32_t elemSize, columnMap *col) {
+    char path[512];
+    struct stat st;
+
+    memset(col, 0, sizeof(*col));
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open column file");
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(columnHeader)) {
+        printf("Column file %s is too short\n", path);
+        close(fd);
+        return -1;
+    }
+
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror("Failed to map column file");
+        return -1;
+    }
+
+    columnHeader *header = base;
+    uint64_t dataSize = (uint64_t)st.st_size - sizeof(columnHeader);
+    if (memcmp(header->magic, COLUMN_MAGIC, sizeof(header->magic)) != 0 || header->elemSize == 0 ||
+        header->rowCount > dataSize / header->elemSize) {
+        printf("Invalid column file %s\n", path);
+        munmap(base, st.st_size);
+        return -1;
+    }
+    if (header->type != type || (elemSize != 0 && header->elemSize != elemSize)) {
+        printf("Column file %s holds type %u of %u bytes, expected type %u of %u bytes\n",
+               path, header->type, header->elemSize, type, elemSize);
+        munmap(base, st.st_size);
+        return -1;
+    }
+
+    col->base = base;
+    col->mappedSize = st.st_size;
+    col->header = header;
+    col->data = (const unsigned char *)base + sizeof(columnHeader);
+    col->rowCount = header->rowCount;
+    return 0;
+}
+
+void unmapColumn(columnMap *col) {
+    if (col->base) munmap(col->base, col->mappedSize);
+    memset(col, 0, sizeof(*col));
+}
+
+/*
+Example consumer: counts votes per candidates.dict ordinal with a single pass over cand.col.
+votes must hold maxCandidates entries. Returns the number of rows counted, or -1.
+*/
+int64_t tallyExportedColumns(const char *dir, uint64_t *votes, uint32_t maxCandidates) {
+    columnMap cand;
+    if (mapColumn(dir, "cand.col", COLUMN_U32, sizeof(uint32_t), &cand) != 0) return -1;
+
+    const uint32_t *ordinals = cand.data;
+    memset(votes, 0, maxCandidates * sizeof(uint64_t));
+    for (uint64_t i = 0; i < cand.rowCount; i++) {
+        if (ordinals[i] < maxCandidates) votes[ordinals[i]]++;
+    }
+
+    int64_t rows = (int64_t)cand.rowCount;
+    unmapColumn(&cand);
+    return rows;
+}
@@ -0,0 +1,57 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdint.h>
+#include "blockchain.h"
+
+/*
+Columnar ballot export.
+
+exportChainColumns writes one file per column into a directory. Row i of every
+column describes block i of the chain:
+
+    seq.col         u64    block number
+    voter.col       u32    ordinal into voters.dict
+    cand.col        u32    ordinal into candidates.dict
+    ts.col          i64    unix timestamp of the ballot (0 if read from a legacy chain file)
+    digest.col      32B    full block hash (the next block's prevhash)
+    voters.dict     N B    distinct voter IDs, sorted, NUL padded to elemSize
+    candidates.dict N B    distinct candidate IDs, sorted, NUL padded to elemSize
+
+Every file starts with a 64-byte columnHeader followed directly by rowCount elements of
+elemSize bytes in host byte order, so the data is 64-byte aligned when the file is mapped
+and can be used as a plain C array.
+*/
+#define COLUMN_MAGIC "VCOLUMN1"
+#define COLUMN_HEADER_SIZE 64
+
+enum columnType {
+    COLUMN_U32 = 1,
+    COLUMN_U64 = 2,
+    COLUMN_I64 = 3,
+    COLUMN_BYTES = 4
+};
+
+typedef struct columnHeader {
+    char magic[8];
+    uint32_t type;
+    uint32_t elemSize;
+    uint64_t rowCount;
+    char name[16];
+    unsigned char reserved[COLUMN_HEADER_SIZE - 40];
+} columnHeader;
+
+typedef struct columnMap {
+    void *base;          // start of the mapping
+    size_t mappedSize;
+    columnHeader *header;
+    const void *data;    // first element
+    uint64_t rowCount;
+} columnMap;
+
+int exportChainColumns(blockchain *bc, const char *dir);
+int mapColumn(const char *dir, const char *file, uint32_t type, uint32_t elemSize, columnMap *col);
+void unmapColumn(columnMap *col);
+int64_t tallyExportedColumns(const char *dir, uint64_t *votes, uint32_t maxCandidates);
+
+#endif
@@ -5,8 +5,16 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string.h>
+#include <sys/resource.h>
 #include "blockchain.h"
 #include "avl.h"
+#include "textcache.h"
+#include "deadline.h"
+#include "commitworker.h"
+#include "prefixindex.h"
+#include "liveresults.h"
+#include "metrics.h"
+#include "logging.h"
 
 // Screen dimensions
 const int SCREEN_WIDTH = 1000;
@@ -22,16 +30,83 @@ const SDL_Color GREEN = {0, 255, 0, 255};
 const SDL_Color GRAY = {200, 200, 200, 255};
  static char candidateID[32] = {0};
 
+#define SCREEN_COUNT 5
+
+#define CANDIDATE_ROW_HEIGHT 36
+#define VOTER_HINT_COUNT 8
+#define DASHBOARD_MAX_BARS 12
+#define DASHBOARD_REFRESH_MS 250   // the results screen redraws at most 4 times a second
+
+// Scrollable candidate list; only the rows inside the viewport are drawn
+typedef struct {
+    SDL_Rect viewport;
+    int scroll;     // pixels scrolled past the first row
+    int selected;   // index into the candidate table, or -1
+} CandidateList;
+
 // GUI State
 typedef struct {
     blockchain *bc;
     AVLTree *voterTree;
+    commitWorker *worker;      // commits ballots off the UI thread
+    CandidateTable *candidates;
+    CandidateList castVoteList;
+    CandidateList browseList;
+    prefixIndex *voterIndex;       // queried on every keystroke in the Voter ID box
+    prefixIndex *candidateIndex;
+    char voterStatus[64];          // registration status of the typed Voter ID
+    int voterStatusOk;
+    char voterHints[VOTER_HINT_COUNT][48];
+    int voterHintCount;
+    liveResults *results;
+    SDL_Rect resultBars[DASHBOARD_MAX_BARS];  // bar slots, laid out once per candidate count
+    int resultBarCount;
+    unsigned long shownResultsVersion;
+    Uint32 lastDashboardTicks;
     int integrityFailed;
     char errorMessage[256];
     char inputBuffer[50];
     int currentScreen;
+    int dirty[SCREEN_COUNT];   // screen needs to be redrawn
+    time_t deadline;           // end of the voting period
+    long shownRemaining;       // countdown value currently on screen
 } GUIState;
 
+// Retained widget list: the same rectangles drive both drawing and hit-testing
+typedef struct {
+    SDL_Rect rect;
+    const char *label;
+    SDL_Color color;
+} Widget;
+
+#define WIDGET_COUNT(widgets) ((int)(sizeof(widgets) / sizeof((widgets)[0])))
+
+enum { MAIN_REGISTER, MAIN_CAST_VOTE, MAIN_CANDIDATES, MAIN_RESULTS, MAIN_EXIT };
+static const Widget mainMenuWidgets[] = {
+    {{350, 200, 300, 50}, "Register Voter", {100, 150, 250, 255}},
+    {{350, 270, 300, 50}, "Cast Vote", {100, 150, 250, 255}},
+    {{350, 340, 300, 50}, "display candidate", {100, 150, 250, 255}},
+    {{350, 410, 300, 50}, "Live Results", {100, 150, 250, 255}},
+    {{350, 480, 300, 50}, "Exit", {255, 0, 0, 255}}
+};
+
+enum { REGISTER_SUBMIT, REGISTER_BACK };
+static const Widget registerVoterWidgets[] = {
+    {{350, 350, 300, 50}, "Register", {0, 255, 0, 255}},
+    {{350, 420, 300, 50}, "Back", {255, 0, 0, 255}}
+};
+
+enum { RESULTS_BACK };
+static const Widget resultsWidgets[] = {
+    {{50, 640, 145, 45}, "Back", {200, 200, 200, 255}}
+};
+
+enum { CAST_BACK, CAST_SUBMIT };
+static const Widget castVoteWidgets[] = {
+    {{350, 400, 145, 50}, "Back", {200, 200, 200, 255}},
+    {{505, 400, 145, 50}, "Submit", {200, 200, 200, 255}}
+};
+
 // Function prototypes
 void renderText(SDL_Renderer* renderer, TTF_Font* font, const char* text, 
                 SDL_Color color, int x, int y, SDL_Rect* destRect);
@@ -41,18 +116,17 @@ void handleMainMenuEvents(SDL_Event* e, GUIState* guiState);
 void renderMainMenu(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiState);
 
 // Render text function
+// Textures come from the text cache, so static labels are rasterized only once.
 void renderText(SDL_Renderer* renderer, TTF_Font* font, const char* text, 
                 SDL_Color color, int x, int y, SDL_Rect* destRect) {
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text, color);
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    
-    SDL_QueryTexture(texture, NULL, NULL, &destRect->w, &destRect->h);
     destRect->x = x;
     destRect->y = y;
-    
-    SDL_RenderCopy(renderer, texture, NULL, destRect);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    destRect->w = destRect->h = 0;
+
+    SDL_Texture* texture = getTextTexture(renderer, font, text, color, &destRect->w, &destRect->h);
+    if (texture) {
+        SDL_RenderCopy(renderer, texture, NULL, destRect);
+    }
 }
 
 
@@ -70,16 +144,210 @@ void drawButton(SDL_Renderer* renderer, TTF_Font* font, const char* text,
     // Render button text
     SDL_Color textColor = WHITE;
     SDL_Rect textRect;
-    SDL_Surface* surface = TTF_RenderText_Blended(font, text, textColor);
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    
-    SDL_QueryTexture(texture, NULL, NULL, &textRect.w, &textRect.h);
-    textRect.x = buttonRect->x + (buttonRect->w - textRect.w) / 2;
-    textRect.y = buttonRect->y + (buttonRect->h - textRect.h) / 2;
-    
-    SDL_RenderCopy(renderer, texture, NULL, &textRect);
-    SDL_FreeSurface(surface);
-    SDL_DestroyTexture(texture);
+    SDL_Texture* texture = getTextTexture(renderer, font, text, textColor, &textRect.w, &textRect.h);
+    if (texture) {
+        textRect.x = buttonRect->x + (buttonRect->w - textRect.w) / 2;
+        textRect.y = buttonRect->y + (buttonRect->h - textRect.h) / 2;
+        SDL_RenderCopy(renderer, texture, NULL, &textRect);
+    }
+}
+
+// Returns the index of the widget under (x, y), or -1
+int hitWidget(const Widget *widgets, int count, int x, int y) {
+    for (int i = 0; i < count; i++) {
+        const SDL_Rect *r = &widgets[i].rect;
+        if (x >= r->x && x <= r->x + r->w && y >= r->y && y <= r->y + r->h) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void drawWidgets(SDL_Renderer* renderer, TTF_Font* font, const Widget *widgets, int count) {
+    for (int i = 0; i < count; i++) {
+        SDL_Rect rect = widgets[i].rect;
+        drawButton(renderer, font, widgets[i].label, &rect, widgets[i].color);
+    }
+}
+
+// Marks the current screen for redraw
+void markDirty(GUIState* guiState) {
+    guiState->dirty[guiState->currentScreen] = 1;
+}
+
+// Draws the time left in the voting period in the top right corner
+void renderCountdown(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiState) {
+    char text[64];
+    long remaining = guiState->shownRemaining > 0 ? guiState->shownRemaining : 0;
+    SDL_Rect textRect;
+
+    snprintf(text, sizeof(text), "Voting closes in %ld:%02ld", remaining / 60, remaining % 60);
+    renderText(renderer, font, text, BLACK, SCREEN_WIDTH - 320, 10, &textRect);
+}
+
+// Keeps the scroll offset inside the list and the selection inside the table
+void clampCandidateList(CandidateList* list, const CandidateTable* table) {
+    int maxScroll = table->count * CANDIDATE_ROW_HEIGHT - list->viewport.h;
+    if (list->scroll > maxScroll) list->scroll = maxScroll;
+    if (list->scroll < 0) list->scroll = 0;
+    if (list->selected >= table->count) list->selected = table->count - 1;
+}
+
+// Scrolls just enough to bring the selected row into view
+void scrollToSelected(CandidateList* list, const CandidateTable* table) {
+    int top = list->selected * CANDIDATE_ROW_HEIGHT;
+    if (top < list->scroll) {
+        list->scroll = top;
+    } else if (top + CANDIDATE_ROW_HEIGHT > list->scroll + list->viewport.h) {
+        list->scroll = top + CANDIDATE_ROW_HEIGHT - list->viewport.h;
+    }
+    clampCandidateList(list, table);
+}
+
+/*
+Draws the rows of the candidate list that intersect its viewport.
+The cost depends on the viewport height, not on the number of candidates,
+and row labels come from the text cache.
+*/
+void renderCandidateList(SDL_Renderer* renderer, TTF_Font* font, const CandidateList* list,
+                         const CandidateTable* table) {
+    const SDL_Rect *view = &list->viewport;
+    SDL_Rect textRect;
+    char label[128];
+
+    SDL_SetRenderDrawColor(renderer, 245, 245, 245, 255);
+    SDL_RenderFillRect(renderer, view);
+
+    if (table->count == 0) {
+        renderText(renderer, font, "No candidates", BLACK, view->x + 10, view->y + 6, &textRect);
+    }
+
+    SDL_RenderSetClipRect(renderer, view);
+    int first = list->scroll / CANDIDATE_ROW_HEIGHT;
+    int last = (list->scroll + view->h + CANDIDATE_ROW_HEIGHT - 1) / CANDIDATE_ROW_HEIGHT;
+    if (last > table->count) last = table->count;
+
+    for (int i = first; i < last; i++) {
+        SDL_Rect row = {view->x, view->y + i * CANDIDATE_ROW_HEIGHT - list->scroll,
+                        view->w, CANDIDATE_ROW_HEIGHT};
+        if (i == list->selected) {
+            SDL_SetRenderDrawColor(renderer, LIGHT_BLUE.r, LIGHT_BLUE.g, LIGHT_BLUE.b, 255);
+            SDL_RenderFillRect(renderer, &row);
+        }
+        snprintf(label, sizeof(label), "%s  %s", table->items[i].id, table->items[i].name);
+        renderText(renderer, font, label, BLACK, row.x + 10, row.y + 4, &textRect);
+    }
+    SDL_RenderSetClipRect(renderer, NULL);
+
+    // Scrollbar thumb, proportional to the visible share of the list
+    int total = table->count * CANDIDATE_ROW_HEIGHT;
+    if (total > view->h) {
+        int thumb = view->h * view->h / total;
+        if (thumb < 20) thumb = 20;
+        SDL_Rect bar = {view->x + view->w - 8, view->y + (view->h - thumb) * list->scroll / (total - view->h),
+                        6, thumb};
+        SDL_SetRenderDrawColor(renderer, GRAY.r - 60, GRAY.g - 60, GRAY.b - 60, 255);
+        SDL_RenderFillRect(renderer, &bar);
+    }
+
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_RenderDrawRect(renderer, view);
+}
+
+/*
+Handles wheel scrolling, clicks and arrow/page keys for a candidate list.
+Returns 1 if the event was consumed by the list, 0 otherwise.
+*/
+int handleCandidateListEvent(SDL_Event* e, CandidateList* list, const CandidateTable* table) {
+    const SDL_Rect *view = &list->viewport;
+    int pageRows = view->h / CANDIDATE_ROW_HEIGHT;
+    int x, y;
+
+    switch (e->type) {
+        case SDL_MOUSEWHEEL:
+            SDL_GetMouseState(&x, &y);
+            if (x < view->x || x > view->x + view->w || y < view->y || y > view->y + view->h) {
+                return 0;
+            }
+            list->scroll -= e->wheel.y * 3 * CANDIDATE_ROW_HEIGHT;
+            clampCandidateList(list, table);
+            return 1;
+
+        case SDL_MOUSEBUTTONDOWN:
+            x = e->button.x;
+            y = e->button.y;
+            if (x < view->x || x > view->x + view->w || y < view->y || y >= view->y + view->h) {
+                return 0;
+            }
+            int row = (y - view->y + list->scroll) / CANDIDATE_ROW_HEIGHT;
+            if (row < table->count) {
+                list->selected = row;
+            }
+            return 1;
+
+        case SDL_KEYDOWN:
+            if (table->count == 0) {
+                return 0;
+            }
+            switch (e->key.keysym.sym) {
+                case SDLK_UP:       list->selected--; break;
+                case SDLK_DOWN:     list->selected++; break;
+                case SDLK_PAGEUP:   list->selected -= pageRows; break;
+                case SDLK_PAGEDOWN: list->selected += pageRows; break;
+                case SDLK_HOME:     list->selected = 0; break;
+                case SDLK_END:      list->selected = table->count - 1; break;
+                default:            return 0;
+            }
+            if (list->selected < 0) list->selected = 0;
+            scrollToSelected(list, table);
+            return 1;
+    }
+    return 0;
+}
+
+/*
+Looks up the typed Voter ID prefix and refreshes the suggestions shown next to the box,
+each with its registered/voted status. Runs on every keystroke.
+*/
+void updateVoterHints(GUIState* guiState) {
+    prefixEntry matches[VOTER_HINT_COUNT];
+    const char *typed = guiState->inputBuffer;
+
+    SDL_LockMutex(guiState->worker->dataLock);
+    int found = prefixIndexFind(guiState->voterIndex, typed, matches, VOTER_HINT_COUNT);
+    for (int i = 0; i < found; i++) {
+        VoterNode *voter = (VoterNode *)matches[i].value;
+        snprintf(guiState->voterHints[i], sizeof(guiState->voterHints[i]), "%s  %s",
+                 voter->voterID, voter->voted ? "voted" : "registered");
+    }
+    guiState->voterHintCount = typed[0] != '\0' ? found : 0;
+
+    guiState->voterStatusOk = 0;
+    if (typed[0] == '\0') {
+        guiState->voterStatus[0] = '\0';
+    } else if (found > 0 && strcmp(matches[0].key, typed) == 0) {
+        VoterNode *voter = (VoterNode *)matches[0].value;
+        guiState->voterStatusOk = !voter->voted;
+        strcpy(guiState->voterStatus, voter->voted ? "Already voted" : "Registered, not voted");
+    } else if (found > 0) {
+        strcpy(guiState->voterStatus, "Keep typing...");
+    } else {
+        strcpy(guiState->voterStatus, "No registered voter matches");
+    }
+    SDL_UnlockMutex(guiState->worker->dataLock);
+}
+
+// Moves the candidate list selection to the first ID starting with the typed text
+void updateCandidateHint(GUIState* guiState) {
+    prefixEntry match;
+    CandidateList *list = &guiState->castVoteList;
+
+    if (candidateID[0] != '\0' && prefixIndexFind(guiState->candidateIndex, candidateID, &match, 1) == 1) {
+        list->selected = (int)((Candidate *)match.value - guiState->candidates->items);
+        scrollToSelected(list, guiState->candidates);
+    } else {
+        list->selected = -1;
+    }
 }
 
 // Render Main Menu
@@ -91,30 +359,15 @@ void renderMainMenu(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiState)
     SDL_Rect titleRect;
     renderText(renderer, font, "Blockchain Voting System", BLUE, 
                SCREEN_WIDTH/2 - 200, 50, &titleRect);
-    // Define button positions and sizes
-    SDL_Rect buttons[] = {
-        {350, 200, 300, 50},  // Register Voter
-        {350, 270, 300, 50},  // Cast Vote
-        {350, 340, 300, 50},  // Display Candidate
-        {350, 410, 300, 50}   // Exit
-    };
-    const char* buttonLabels[] = {
-        "Register Voter", 
-        "Cast Vote", 
-        "display candidate", 
-        "Exit"
-    };
     // Render buttons
-    for (int i = 0; i < 4; i++) {
-        drawButton(renderer, font, buttonLabels[i], &buttons[i], 
-                   i == 3 ? RED : LIGHT_BLUE);
-    }
+    drawWidgets(renderer, font, mainMenuWidgets, WIDGET_COUNT(mainMenuWidgets));
     // Render error message if any
     if (strlen(guiState->errorMessage) > 0) {
         SDL_Rect errorRect;
         renderText(renderer, font, guiState->errorMessage, RED, 
                    250, SCREEN_HEIGHT - 100, &errorRect);
     }
+    renderCountdown(renderer, font, guiState);
     SDL_RenderPresent(renderer);
 }
 // Render Register Voter Screen
@@ -140,11 +393,7 @@ void renderRegisterVoter(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiSt
                360, 260, &inputTextRect);
 
     // Buttons
-    SDL_Rect registerButton = {350, 350, 300, 50};
-    SDL_Rect backButton = {350, 420, 300, 50};
-    
-    drawButton(renderer, font, "Register", &registerButton, GREEN);
-    drawButton(renderer, font, "Back", &backButton, RED);
+    drawWidgets(renderer, font, registerVoterWidgets, WIDGET_COUNT(registerVoterWidgets));
 
     // Render error message if any
     if (strlen(guiState->errorMessage) > 0) {
@@ -153,6 +402,7 @@ void renderRegisterVoter(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiSt
                    250, SCREEN_HEIGHT - 100, &errorRect);
     }
 
+    renderCountdown(renderer, font, guiState);
     SDL_RenderPresent(renderer);
 }
 
@@ -162,10 +412,11 @@ void handleRegisterVoterEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* r
     
     switch (e->type) {
         case SDL_MOUSEBUTTONDOWN:
-            int x = e->button.x, y = e->button.y;
+            int widget = hitWidget(registerVoterWidgets, WIDGET_COUNT(registerVoterWidgets),
+                                   e->button.x, e->button.y);
             
             // Back button
-            if (x >= 350 && x <= 650 && y >= 420 && y <= 470) {
+            if (widget == REGISTER_BACK) {
                 guiState->currentScreen = 0;  // Back to main menu
                 guiState->errorMessage[0] = '\0';
                 guiState->inputBuffer[0] = '\0';
@@ -173,20 +424,34 @@ void handleRegisterVoterEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* r
             }
             
             // Register button
-            if (x >= 350 && x <= 650 && y >= 350 && y <= 400) {
+            if (widget == REGISTER_SUBMIT) {
                 strncpy(voterID, guiState->inputBuffer, sizeof(voterID) - 1);
                 voterID[sizeof(voterID) - 1] = '\0';
                 
                 // Check voter registration
                 if (strlen(voterID) == 0) {
                     strcpy(guiState->errorMessage, "Please enter a Voter ID");
-                } /*else if isVoterRegistered(guiState->voterTree->root, voterID)) {
-                    strcpy(guiState->errorMessage, "Voter ID already registered");
-                } */else {
-                    insertVoter(guiState->voterTree, voterID);
-                    strcpy(guiState->errorMessage, "Voter registered successfully");
-                    saveTreeToBinaryFile(guiState->voterTree, "voter_data.bin");
-                    guiState->inputBuffer[0] = '\0';
+                } else if (strlen(guiState->inputBuffer) >= VOTER_KEY_SIZE) {
+                    strcpy(guiState->errorMessage, "Voter ID is too long");
+                } else {
+                    SDL_LockMutex(guiState->worker->dataLock);
+                    int added = registerVoter(guiState->voterTree, voterID);
+                    VoterNode *voter = added == 1 ? findVoter(guiState->voterTree, voterID) : NULL;
+                    if (voter) {
+                        prefixIndexInsert(guiState->voterIndex, voter->voterID, voter);
+                    }
+                    SDL_UnlockMutex(guiState->worker->dataLock);
+
+                    // The worker writes the registry file, so the UI never waits on the disk
+                    if (added == 1) {
+                        requestRegistrySave(guiState->worker);
+                        strcpy(guiState->errorMessage, "Voter registered successfully");
+                        guiState->inputBuffer[0] = '\0';
+                    } else if (added == 0) {
+                        strcpy(guiState->errorMessage, "Voter ID already registered");
+                    } else {
+                        strcpy(guiState->errorMessage, "Voter could not be registered");
+                    }
                 }
             }
             break;
@@ -220,11 +485,19 @@ void handleCastVoteEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* render
     // Basic null checks
     if (!e || !guiState || !renderer || !font) return;
 
-    // Change this to a local static variable with a larger buffer
-    static char candidateID[32] = {0};  // Increased buffer size
     char voterID[16] = {0};
     static int inputFocus = 0;  // 0 for Voter ID, 1 for Candidate ID
-    
+
+    // Picking a candidate from the list fills in the Candidate ID box
+    CandidateList *list = &guiState->castVoteList;
+    if (handleCandidateListEvent(e, list, guiState->candidates)) {
+        if (e->type != SDL_MOUSEWHEEL && list->selected >= 0) {
+            strncpy(candidateID, guiState->candidates->items[list->selected].id, sizeof(candidateID) - 1);
+            candidateID[sizeof(candidateID) - 1] = '\0';
+        }
+        return;
+    }
+
     switch (e->type) {
         case SDL_MOUSEBUTTONDOWN:
             int x = e->button.x, y = e->button.y;
@@ -239,17 +512,21 @@ void handleCastVoteEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* render
                 inputFocus = 1;  // Candidate ID focus
             }
 
+            int widget = hitWidget(castVoteWidgets, WIDGET_COUNT(castVoteWidgets), x, y);
+
             // Back button
-            if (x >= 350 && x <= 495 && y >= 400 && y <= 450) {
+            if (widget == CAST_BACK) {
                 guiState->currentScreen = 0;
                 guiState->errorMessage[0] = '\0';
                 guiState->inputBuffer[0] = '\0';
                 candidateID[0] = '\0';  // Clear candidateID
+                guiState->castVoteList.selected = -1;
+                updateVoterHints(guiState);
                 return;
             }
 
             // Submit button
-            if (x >= 505 && x <= 650 && y >= 400 && y <= 450) {
+            if (widget == CAST_SUBMIT) {
                 // Validate required pointers
                 if (!guiState->voterTree || !guiState->bc) {
                     strcpy(guiState->errorMessage, "System error: Invalid data");
@@ -260,34 +537,32 @@ void handleCastVoteEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* render
                 strncpy(voterID, guiState->inputBuffer, sizeof(voterID) - 1);
                 voterID[sizeof(voterID) - 1] = '\0';
 
-                // Validation checks
+                // Validation checks; a longer ID would otherwise be cut to a registered one
                 if (strlen(voterID) == 0) {
                     strcpy(guiState->errorMessage, "Please enter a Voter ID");
+                } else if (strlen(guiState->inputBuffer) >= VOTER_KEY_SIZE) {
+                    strcpy(guiState->errorMessage, "Voter ID is too long");
+                } else if (strlen(candidateID) == 0) {
+                    strcpy(guiState->errorMessage, "Please enter a Candidate ID");
                 } else {
-                    VoterNode *voter = findVoter(guiState->voterTree->root, voterID);
-                    if (voter == NULL) {
+                    int submitted = submitBallot(guiState->worker, guiState->candidateIndex,
+                                                 voterID, candidateID);
+                    if (submitted == SUBMIT_NOT_REGISTERED) {
                         strcpy(guiState->errorMessage, "Voter not registered");
-                    } else if (voter->voted) {
+                    } else if (submitted == SUBMIT_ALREADY_VOTED) {
                         strcpy(guiState->errorMessage, "Voter has already voted");
-                    } else if (strlen(candidateID) == 0) {
-                        strcpy(guiState->errorMessage, "Please enter a Candidate ID");
+                    } else if (submitted == SUBMIT_UNKNOWN_CANDIDATE) {
+                        strcpy(guiState->errorMessage, "Unknown candidate ID");
+                    } else if (submitted == SUBMIT_QUEUED) {
+                        // The worker reports back with a commit event once the ballot is on disk
+                        snprintf(guiState->errorMessage, sizeof(guiState->errorMessage),
+                                 "Vote pending for %s...", voterID);
+                        guiState->inputBuffer[0] = '\0';
+                        candidateID[0] = '\0';
+                        guiState->castVoteList.selected = -1;
+                        updateVoterHints(guiState);
                     } else {
-                        // Attempt to cast vote
-                        castVote(voterID, candidateID, guiState->bc);
-
-                        // Update voter status
-                        int updateStatus = updateVotingStatus(guiState->voterTree->root, voterID);
-
-                        if (updateStatus == 0) {
-                            // Save updated voter tree
-                            saveTreeToBinaryFile(guiState->voterTree, "voter_data.bin");
-
-                            strcpy(guiState->errorMessage, "Vote cast successfully");
-                            guiState->inputBuffer[0] = '\0';
-                            candidateID[0] = '\0';
-                        } else {
-                            strcpy(guiState->errorMessage, "Error updating voter status");
-                        }
+                        strcpy(guiState->errorMessage, "Commit queue full, please retry");
                     }
                 }
             }
@@ -298,12 +573,11 @@ void handleCastVoteEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* render
             if (inputFocus == 0 && strlen(guiState->inputBuffer) < sizeof(guiState->inputBuffer) - 1) {
                 strncat(guiState->inputBuffer, e->text.text, 
                         sizeof(guiState->inputBuffer) - strlen(guiState->inputBuffer) - 1);
+                updateVoterHints(guiState);
             } else if (inputFocus == 1 && strlen(candidateID) < sizeof(candidateID) - 1) {
                 strncat(candidateID, e->text.text, 
                         sizeof(candidateID) - strlen(candidateID) - 1);
-                
-                // Debug print to verify input
-                printf("Candidate ID: %s\n", candidateID);
+                updateCandidateHint(guiState);
             }
             break;
         
@@ -312,11 +586,10 @@ void handleCastVoteEvents(SDL_Event* e, GUIState* guiState, SDL_Renderer* render
                 // Backspace based on current focus
                 if (inputFocus == 0 && strlen(guiState->inputBuffer) > 0) {
                     guiState->inputBuffer[strlen(guiState->inputBuffer) - 1] = '\0';
+                    updateVoterHints(guiState);
                 } else if (inputFocus == 1 && strlen(candidateID) > 0) {
                     candidateID[strlen(candidateID) - 1] = '\0';
-                    
-                    // Debug print to verify backspace
-                    printf("Candidate ID after backspace: %s\n", candidateID);
+                    updateCandidateHint(guiState);
                 }
             }
             break;
@@ -333,8 +606,8 @@ void renderCastVoteScreen(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiS
     // Colors
     SDL_Color GRAY = {200, 200, 200, 255};
     SDL_Color BLACK = {0, 0, 0, 255};
-    SDL_Color LIGHT_GRAY = {220, 220, 220, 255};
     SDL_Color RED = {255, 0, 0, 255};
+    SDL_Rect textRect;
 
     // Render labels and input boxes for Voter ID
     SDL_Rect voterIDRect = {350, 200, 300, 50};
@@ -343,30 +616,9 @@ void renderCastVoteScreen(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiS
     SDL_SetRenderDrawColor(renderer, BLACK.r, BLACK.g, BLACK.b, 255);
     SDL_RenderDrawRect(renderer, &voterIDRect);
 
-    // Safely render Voter ID label
-    SDL_Surface* voterIDLabelSurface = TTF_RenderText_Blended(font, "Voter ID", BLACK);
-    if (voterIDLabelSurface) {
-        SDL_Texture* voterIDLabelTexture = SDL_CreateTextureFromSurface(renderer, voterIDLabelSurface);
-        if (voterIDLabelTexture) {
-            SDL_Rect voterIDLabelRect = {350, 170, voterIDLabelSurface->w, voterIDLabelSurface->h};
-            SDL_RenderCopy(renderer, voterIDLabelTexture, NULL, &voterIDLabelRect);
-            SDL_DestroyTexture(voterIDLabelTexture);
-        }
-        SDL_FreeSurface(voterIDLabelSurface);
-    }
-
-    // Render voter input
-    SDL_Surface* voterInputSurface = TTF_RenderText_Blended(font, 
-        guiState->inputBuffer ? guiState->inputBuffer : "", BLACK);
-    if (voterInputSurface) {
-        SDL_Texture* voterInputTexture = SDL_CreateTextureFromSurface(renderer, voterInputSurface);
-        if (voterInputTexture) {
-            SDL_Rect voterInputRect = {360, 210, voterInputSurface->w, voterInputSurface->h};
-            SDL_RenderCopy(renderer, voterInputTexture, NULL, &voterInputRect);
-            SDL_DestroyTexture(voterInputTexture);
-        }
-        SDL_FreeSurface(voterInputSurface);
-    }
+    // Voter ID label and input; the input is only re-rasterized when its content changes
+    renderText(renderer, font, "Voter ID", BLACK, 350, 170, &textRect);
+    renderText(renderer, font, guiState->inputBuffer, BLACK, 360, 210, &textRect);
 
     // Render candidate ID input box
     SDL_Rect candidateIDRect = {350, 300, 300, 50};
@@ -375,51 +627,30 @@ void renderCastVoteScreen(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiS
     SDL_SetRenderDrawColor(renderer, BLACK.r, BLACK.g, BLACK.b, 255);
     SDL_RenderDrawRect(renderer, &candidateIDRect);
 
-    // Safely render Candidate ID label
-    SDL_Surface* candidateIDLabelSurface = TTF_RenderText_Blended(font, "Candidate ID", BLACK);
-    if (candidateIDLabelSurface) {
-        SDL_Texture* candidateIDLabelTexture = SDL_CreateTextureFromSurface(renderer, candidateIDLabelSurface);
-        if (candidateIDLabelTexture) {
-            SDL_Rect candidateIDLabelRect = {350, 270, candidateIDLabelSurface->w, candidateIDLabelSurface->h};
-            SDL_RenderCopy(renderer, candidateIDLabelTexture, NULL, &candidateIDLabelRect);
-            SDL_DestroyTexture(candidateIDLabelTexture);
-        }
-        SDL_FreeSurface(candidateIDLabelSurface);
+    // Candidate ID label and input
+    renderText(renderer, font, "Candidate ID", BLACK, 350, 270, &textRect);
+    if (candidateIDParam) {
+        renderText(renderer, font, candidateIDParam, BLACK, 360, 310, &textRect);
     }
 
-    // Render candidate input
-    SDL_Surface* candidateInputSurface = TTF_RenderText_Blended(font, 
-        (candidateIDParam && candidateIDParam[0] != '\0') ? candidateIDParam : "", BLACK);
-    if (candidateInputSurface) {
-        SDL_Texture* candidateInputTexture = SDL_CreateTextureFromSurface(renderer, candidateInputSurface);
-        if (candidateInputTexture) {
-            SDL_Rect candidateInputRect = {360, 310, candidateInputSurface->w, candidateInputSurface->h};
-            SDL_RenderCopy(renderer, candidateInputTexture, NULL, &candidateInputRect);
-            SDL_DestroyTexture(candidateInputTexture);
-        }
-        SDL_FreeSurface(candidateInputSurface);
+    // Back and Submit buttons
+    drawWidgets(renderer, font, castVoteWidgets, WIDGET_COUNT(castVoteWidgets));
+
+    // As-you-type status and suggestions for the Voter ID box
+    renderText(renderer, font, guiState->voterStatus, guiState->voterStatusOk ? BLUE : RED,
+               20, 140, &textRect);
+    for (int i = 0; i < guiState->voterHintCount; i++) {
+        renderText(renderer, font, guiState->voterHints[i], BLACK, 20, 180 + i * 32, &textRect);
     }
 
-    // Back and Submit buttons
-    SDL_Rect backButton = {350, 400, 145, 50};
-    SDL_Rect submitButton = {505, 400, 145, 50};
-    drawButton(renderer, font, "Back", &backButton, GRAY);
-    drawButton(renderer, font, "Submit", &submitButton, GRAY);
+    // Candidates to pick from instead of typing the ID
+    renderText(renderer, font, "Candidates", BLACK, guiState->castVoteList.viewport.x, 140, &textRect);
+    renderCandidateList(renderer, font, &guiState->castVoteList, guiState->candidates);
 
     // Render error message
-    if (guiState->errorMessage && strlen(guiState->errorMessage) > 0) {
-        SDL_Surface* errorSurface = TTF_RenderText_Blended(font, guiState->errorMessage, RED);
-        if (errorSurface) {
-            SDL_Texture* errorTexture = SDL_CreateTextureFromSurface(renderer, errorSurface);
-            if (errorTexture) {
-                SDL_Rect errorRect = {350, 460, errorSurface->w, errorSurface->h};
-                SDL_RenderCopy(renderer, errorTexture, NULL, &errorRect);
-                SDL_DestroyTexture(errorTexture);
-            }
-            SDL_FreeSurface(errorSurface);
-        }
-    }
+    renderText(renderer, font, guiState->errorMessage, RED, 350, 460, &textRect);
 
+    renderCountdown(renderer, font, guiState);
     SDL_RenderPresent(renderer);
 }/*
 void renderCastVoteScreen(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiState, const char* candidateID) {
@@ -526,10 +757,28 @@ void renderCastVoteScreen(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiS
 }*/
 
 void handleCandidateManagementEvents(SDL_Event* e, GUIState* guiState) {
+    if (handleCandidateListEvent(e, &guiState->browseList, guiState->candidates)) {
+        return;
+    }
     if (e->type == SDL_KEYDOWN) {
         switch (e->key.keysym.sym) {
-            case SDLK_1: // Display Candidates
-                displayCandidates();  // Call your logic for displaying candidates
+            case SDLK_1: // Reload Candidates from candidates.txt
+                freePrefixIndex(guiState->candidateIndex);
+                freeCandidateTable(guiState->candidates);
+                loadCandidateTable(guiState->candidates, CANDIDATES_FILE);
+                buildCandidatePrefixIndex(guiState->candidateIndex, guiState->candidates);
+                freeLiveResults(guiState->results);
+                // Only the capture holds the lock; the commit worker keeps appending during the tally
+                chainSnapshot snapshot;
+                SDL_LockMutex(guiState->worker->dataLock);
+                captureChainSnapshot(guiState->bc, &snapshot);
+                SDL_UnlockMutex(guiState->worker->dataLock);
+                initLiveResults(guiState->results, &snapshot, guiState->candidates);
+                guiState->browseList.selected = guiState->castVoteList.selected = -1;
+                clampCandidateList(&guiState->browseList, guiState->candidates);
+                clampCandidateList(&guiState->castVoteList, guiState->candidates);
+                snprintf(guiState->errorMessage, sizeof(guiState->errorMessage),
+                         "%d candidates loaded", guiState->candidates->count);
                 break;
             
             case SDLK_0: // Return to Main Menu
@@ -555,89 +804,144 @@ void renderCandidateManagement(SDL_Renderer* renderer, TTF_Font* font, GUIState*
     // Text options (updated to remove the "Add Candidate" option)
     const char* options[] = {
         "=== Candidate Management ===",
-        "1. Display Candidates",
+        "1. Reload Candidates",
         "0. Return to Main Menu",
         "Choose an option (Press 1 or 0):"
     };
 
     SDL_Color textColor = {0, 0, 0, 255};  // Black text
+    SDL_Rect textRect;
     int y_offset = 50;
 
     for (int i = 0; i < 4; ++i) {  // Updated loop to match the 4 options
-        SDL_Surface* textSurface = TTF_RenderText_Solid(font, options[i], textColor);
-        if (!textSurface) {
-            fprintf(stderr, "Text rendering failed: %s\n", TTF_GetError());
-            continue;
-        }
-
-        SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-        if (!textTexture) {
-            fprintf(stderr, "Texture creation failed: %s\n", SDL_GetError());
-            SDL_FreeSurface(textSurface);
-            continue;
-        }
-
-        SDL_Rect textRect = {50, y_offset, textSurface->w, textSurface->h};
-        SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
-
-        SDL_FreeSurface(textSurface);
-        SDL_DestroyTexture(textTexture);
-
+        renderText(renderer, font, options[i], textColor, 50, y_offset, &textRect);
         y_offset += 50;
     }
 
     // Render error message
-    if (strlen(guiState->errorMessage) > 0) {
-        SDL_Surface* errorSurface = TTF_RenderText_Solid(font, guiState->errorMessage, textColor);
-        if (errorSurface) {
-            SDL_Texture* errorTexture = SDL_CreateTextureFromSurface(renderer, errorSurface);
-            if (errorTexture) {
-                SDL_Rect errorRect = {50, y_offset, errorSurface->w, errorSurface->h};
-                SDL_RenderCopy(renderer, errorTexture, NULL, &errorRect);
-                SDL_DestroyTexture(errorTexture);
-            }
-            SDL_FreeSurface(errorSurface);
-        }
-    }
+    renderText(renderer, font, guiState->errorMessage, textColor, 50, y_offset, &textRect);
+
+    renderCandidateList(renderer, font, &guiState->browseList, guiState->candidates);
 
+    renderCountdown(renderer, font, guiState);
     SDL_RenderPresent(renderer);
 }
 void renderVotingEndedScreen(SDL_Renderer* renderer, TTF_Font* font) {
+    SDL_Rect textRect;
+
     // Clear the screen with a background color
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);  // White background
     SDL_RenderClear(renderer);
 
     // Display message "Voting Period Ended"
-    SDL_Surface* textSurface = TTF_RenderText_Blended(font, "The Voting Period Has Ended!", (SDL_Color){255, 0, 0, 255});
-    if (textSurface) {
-        SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-        SDL_Rect textRect = {100, 200, textSurface->w, textSurface->h};
-        SDL_RenderCopy(renderer, textTexture, NULL, &textRect);
+    renderText(renderer, font, "The Voting Period Has Ended!", (SDL_Color){255, 0, 0, 255}, 100, 200, &textRect);
+
+    // Display additional message if needed, like a thank you note or instructions
+    renderText(renderer, font, "Thank you for participating!", (SDL_Color){0, 0, 0, 255}, 100, 300, &textRect);
+
+    // Update the screen
+    SDL_RenderPresent(renderer);
+}
 
-        SDL_FreeSurface(textSurface);
-        SDL_DestroyTexture(textTexture);
+// Lays out one bar slot per candidate; redone only when the candidate count changes
+void layoutResultBars(GUIState* guiState) {
+    int count = guiState->results->numCandidates;
+    if (count > DASHBOARD_MAX_BARS) count = DASHBOARD_MAX_BARS;
+
+    for (int i = 0; i < count; i++) {
+        guiState->resultBars[i] = (SDL_Rect){300, 220 + i * 34, 560, 26};
     }
+    guiState->resultBarCount = count;
+}
 
-    // Display additional message if needed, like a thank you note or instructions
-    SDL_Surface* thankYouSurface = TTF_RenderText_Blended(font, "Thank you for participating!", (SDL_Color){0, 0, 0, 255});
-    if (thankYouSurface) {
-        SDL_Texture* thankYouTexture = SDL_CreateTextureFromSurface(renderer, thankYouSurface);
-        SDL_Rect thankYouRect = {100, 300, thankYouSurface->w, thankYouSurface->h};
-        SDL_RenderCopy(renderer, thankYouTexture, NULL, &thankYouRect);
+/*
+Live results screen: turnout, chain length, commit rate and latency, plus one bar per
+candidate. Everything comes from counters that are updated as ballots commit.
+*/
+void renderResultsDashboard(SDL_Renderer* renderer, TTF_Font* font, GUIState* guiState) {
+    liveResults *results = guiState->results;
+    SDL_Rect textRect;
+    char text[128];
 
-        SDL_FreeSurface(thankYouSurface);
-        SDL_DestroyTexture(thankYouTexture);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderClear(renderer);
+    renderText(renderer, font, "Live Results", BLUE, 50, 20, &textRect);
+
+    SDL_LockMutex(guiState->worker->dataLock);
+    unsigned long registered = guiState->voterTree->stats.registered;
+    unsigned long voted = guiState->voterTree->stats.voted;
+    unsigned long chainLength = guiState->bc->length;
+    SDL_UnlockMutex(guiState->worker->dataLock);
+
+    snprintf(text, sizeof(text), "Turnout: %lu / %lu (%.1f%%)", voted, registered,
+             registered ? 100.0 * voted / registered : 0.0);
+    renderText(renderer, font, text, BLACK, 50, 70, &textRect);
+    snprintf(text, sizeof(text), "Chain length: %lu blocks", chainLength);
+    renderText(renderer, font, text, BLACK, 50, 105, &textRect);
+    snprintf(text, sizeof(text), "Votes/sec: %.1f   (%lu this session)",
+             votesPerSecond(results), results->committed);
+    renderText(renderer, font, text, BLACK, 50, 140, &textRect);
+    snprintf(text, sizeof(text), "Commit latency p50 / p95 / p99: %u / %u / %u ms",
+             latencyPercentile(results, 50), latencyPercentile(results, 95),
+             latencyPercentile(results, 99));
+    renderText(renderer, font, text, BLACK, 50, 175, &textRect);
+
+    if (guiState->resultBarCount != (results->numCandidates < DASHBOARD_MAX_BARS ?
+                                     results->numCandidates : DASHBOARD_MAX_BARS)) {
+        layoutResultBars(guiState);
     }
 
-    // Update the screen
+    int maxVotes = 1;
+    for (int i = 0; i < results->numCandidates; i++) {
+        if (results->votes[i] > maxVotes) maxVotes = results->votes[i];
+    }
+
+    for (int i = 0; i < guiState->resultBarCount; i++) {
+        SDL_Rect slot = guiState->resultBars[i];
+        SDL_Rect bar = slot;
+        bar.w = (int)((long long)slot.w * results->votes[i] / maxVotes);
+
+        renderText(renderer, font, guiState->candidates->items[i].name, BLACK, 50, slot.y, &textRect);
+        SDL_SetRenderDrawColor(renderer, GRAY.r, GRAY.g, GRAY.b, 255);
+        SDL_RenderFillRect(renderer, &slot);
+        SDL_SetRenderDrawColor(renderer, BLUE.r, BLUE.g, BLUE.b, 255);
+        SDL_RenderFillRect(renderer, &bar);
+
+        snprintf(text, sizeof(text), "%d", results->votes[i]);
+        renderText(renderer, font, text, BLACK, slot.x + slot.w + 10, slot.y, &textRect);
+    }
+    if (results->numCandidates > guiState->resultBarCount) {
+        snprintf(text, sizeof(text), "+%d more candidates", results->numCandidates - guiState->resultBarCount);
+        renderText(renderer, font, text, BLACK, 300, 220 + DASHBOARD_MAX_BARS * 34, &textRect);
+    }
+
+    drawWidgets(renderer, font, resultsWidgets, WIDGET_COUNT(resultsWidgets));
+    renderCountdown(renderer, font, guiState);
     SDL_RenderPresent(renderer);
+
+    guiState->shownResultsVersion = results->version;
+    guiState->lastDashboardTicks = SDL_GetTicks();
+}
+
+void handleResultsDashboardEvents(SDL_Event* e, GUIState* guiState) {
+    if ((e->type == SDL_MOUSEBUTTONDOWN &&
+         hitWidget(resultsWidgets, WIDGET_COUNT(resultsWidgets), e->button.x, e->button.y) == RESULTS_BACK) ||
+        (e->type == SDL_KEYDOWN && e->key.keysym.sym == SDLK_0)) {
+        guiState->currentScreen = 0;
+    }
 }
 
 // Rest of the implementation would follow a similar pattern for other screens
 // (Cast Vote, Alter Vote, Verify Blockchain, Count Votes)
-int main(){
+int main(int argc, char *argv[]){
+    // --idle-bench N: run the kiosk untouched for N seconds and report CPU use
+    int idleBenchSeconds = 0;
+    if (argc > 2 && strcmp(argv[1], "--idle-bench") == 0) {
+        idleBenchSeconds = atoi(argv[2]);
+    }
+
     // SDL Initialization
-    if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) < 0) {
         printf("SDL could not initialize! SDL_Error: %s\n", SDL_GetError());
         return 1;
     }
@@ -689,98 +993,251 @@ int main(){
     if (file != NULL) {
         fprintf(file, "%ld", expiration_time);  // Write the expiration time
         fclose(file);
-        printf("Voting expiration time set to: %ld (Unix timestamp)\n", expiration_time);
+        LOG_INFO("gui", "Voting expiration time set to: %ld (Unix timestamp)", expiration_time);
     } else {
-        printf("Error: Unable to open the file for writing.\n");
+        LOG_ERROR("gui", "Unable to open voting_time.txt for writing");
     }
     // Initialize blockchain and voter tree
     blockchain bc;
     AVLTree voterTree;
     
     bc.head = bc.tail = NULL;
-    bc.merkle_count = 0;
     initializeTree(&voterTree);
     initializeBlockchain(&bc);
 
+    // Candidates are loaded once and shared by every list on screen
+    CandidateTable candidates;
+    loadCandidateTable(&candidates, CANDIDATES_FILE);
+
+    // Sorted prefix indexes behind the as-you-type suggestions
+    prefixIndex voterIndex, candidateIndex;
+    buildVoterPrefixIndex(&voterIndex, &voterTree);
+    buildCandidatePrefixIndex(&candidateIndex, &candidates);
+
+    // Results are tallied once here and then kept current from commit events
+    liveResults results;
+    chainSnapshot snapshot;
+    captureChainSnapshot(&bc, &snapshot);
+    initLiveResults(&results, &snapshot, &candidates);
+
     // GUI State
     GUIState guiState = {
         .bc = &bc,
         .voterTree = &voterTree,
+        .candidates = &candidates,
+        .castVoteList = {{680, 170, 300, 480}, 0, -1},
+        .browseList = {{50, 300, 900, 380}, 0, -1},
+        .voterIndex = &voterIndex,
+        .candidateIndex = &candidateIndex,
+        .results = &results,
         .integrityFailed = 0,
         .errorMessage = {0},
         .inputBuffer = {0},
-        .currentScreen = 0
+        .currentScreen = 0,
+        .dirty = {1, 1, 1, 1, 1},
+        .deadline = expiration_time,
+        .shownRemaining = -1
     };
 
+    // Ballots are committed on a background thread
+    commitWorker worker;
+    if (startCommitWorker(&worker, &bc, &voterTree) != 0) {
+        stopCommitWorker(&worker);
+        clearTextCache();
+        TTF_CloseFont(font);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        TTF_Quit();
+        SDL_Quit();
+        return 1;
+    }
+    guiState.worker = &worker;
+    METRICS_START_REPORTER(METRICS_DEFAULT_FILE, METRICS_DEFAULT_INTERVAL_MS);
+    // From here on, log records are written by a background thread
+    logStart();
+
+    // The deadline is read once; a timer ends voting and file changes re-arm it
+    deadlineWatch deadline;
+    if (startDeadlineWatch(&deadline, "voting_time.txt") == 0) {
+        guiState.deadline = currentDeadline(&deadline);
+    }
+
     // Main event loop
     SDL_Event e;
     int quit = 0;
-    Candidate candidates[MAX_CANDIDATES];
-    int numCandidates;
-    loadCandidatesFromFile(candidates,&numCandidates);
+    Uint32 startTicks = SDL_GetTicks();
+    int framesRendered = 0;
+    int votingEnded = 0;
     while (!quit) {
-        // Check voting time at the start of each loop iteration
-        if (hasTimePassed("voting_time.txt")) {
+        // The deadline timer pushed its end-of-voting event
+        if (votingEnded) {
             renderVotingEndedScreen(renderer, font);
-            countVotes(&bc, candidates, numCandidates); 
+            stopCommitWorker(&worker);  // commit whatever is still queued first
+            countVotes(&bc, candidates.items, candidates.count);
             SDL_Delay(3000);  // Show the message for 3 seconds
             quit = 1;
             break;  // Exit the loop immediately
         }
 
-        while (SDL_PollEvent(&e) != 0) {
-            // Quit event
-            if (e.type == SDL_QUIT) {
-                quit = 1;
-            }
+        // The countdown is the only thing that changes without input
+        long remaining = (long)(guiState.deadline - time(NULL));
+        if (remaining != guiState.shownRemaining) {
+            guiState.shownRemaining = remaining;
+            markDirty(&guiState);
+        }
 
-            // Handle events based on current screen
+        // Render only when the current screen has changed
+        if (guiState.dirty[guiState.currentScreen]) {
+            guiState.dirty[guiState.currentScreen] = 0;
             switch (guiState.currentScreen) {
-                case 0: // Main Menu
-                    handleMainMenuEvents(&e, &guiState);
+                case 0:
+                    renderMainMenu(renderer, font, &guiState);
                     break;
-                case 1: // Register Voter
-                    handleRegisterVoterEvents(&e, &guiState, renderer, font);
+                case 1:
+                    renderRegisterVoter(renderer, font, &guiState);
                     break;
-                case 2: // Cast Vote
-                    handleCastVoteEvents(&e, &guiState, renderer, font);
+                case 2:
+                    renderCastVoteScreen(renderer, font, &guiState, candidateID);
                     break;
-                case 3: // Candidate Management
-                    handleCandidateManagementEvents(&e, &guiState);
+                case 3:
+                    renderCandidateManagement(renderer, font, &guiState);
+                    break;
+                case 4:
+                    renderResultsDashboard(renderer, font, &guiState);
                     break;
             }
+            framesRendered++;
         }
 
-        // Render based on current screen
-        switch (guiState.currentScreen) {
-            case 0:
-                renderMainMenu(renderer, font, &guiState);
-                break;
-            case 1:
-                renderRegisterVoter(renderer, font, &guiState);
-                break;
-            case 2:
-                renderCastVoteScreen(renderer, font, &guiState, candidateID);
-                break;
-            case 3:
-                renderCandidateManagement(renderer, font, &guiState);
-                break;
+        // Sleep until input arrives or the countdown reaches its next second
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        int timeout = 1000 - (int)(now.tv_nsec / 1000000);
+
+        // New commits are shown on the results screen once the refresh interval has passed
+        if (guiState.currentScreen == 4 && results.version != guiState.shownResultsVersion) {
+            int sinceDraw = (int)(SDL_GetTicks() - guiState.lastDashboardTicks);
+            if (sinceDraw >= DASHBOARD_REFRESH_MS) {
+                markDirty(&guiState);
+                continue;
+            }
+            if (DASHBOARD_REFRESH_MS - sinceDraw < timeout) {
+                timeout = DASHBOARD_REFRESH_MS - sinceDraw;
+            }
+        }
+
+        if (SDL_WaitEventTimeout(&e, timeout)) {
+            do {
+                // Quit event
+                if (e.type == SDL_QUIT) {
+                    quit = 1;
+                }
+
+                if (e.type == deadline.endEvent) {
+                    votingEnded = 1;
+                    continue;
+                }
+                if (e.type == worker.doneEvent) {
+                    commitResult *result = (commitResult *)e.user.data1;
+                    const char *voter = result ? result->voterID : "";
+                    // After a candidate reload the snapshot tally may already include this block
+                    if (e.user.code == COMMIT_OK && result && result->seq >= results.baseLength) {
+                        prefixEntry match;
+                        int candidate = -1;
+                        if (prefixIndexFind(&candidateIndex, result->candID, &match, 1) == 1 &&
+                            strcmp(match.key, result->candID) == 0) {
+                            candidate = (int)((Candidate *)match.value - candidates.items);
+                        }
+                        recordCommittedVote(&results, candidate, result->latencyMs);
+                    }
+                    switch (e.user.code) {
+                        case COMMIT_OK:
+                            snprintf(guiState.errorMessage, sizeof(guiState.errorMessage),
+                                     "Vote recorded for %s", voter);
+                            break;
+                        case COMMIT_ALREADY_VOTED:
+                            snprintf(guiState.errorMessage, sizeof(guiState.errorMessage),
+                                     "Voter %s has already voted", voter);
+                            break;
+                        default:
+                            snprintf(guiState.errorMessage, sizeof(guiState.errorMessage),
+                                     "Vote for %s could not be recorded", voter);
+                            break;
+                    }
+                    free(result);
+                    updateVoterHints(&guiState);  // voted flags may have changed
+                    if (guiState.currentScreen != 4) {
+                        markDirty(&guiState);  // the results screen refreshes on its own schedule
+                    }
+                    continue;
+                }
+                if (e.type == deadline.changedEvent) {
+                    if (reloadDeadline(&deadline) > 0) {
+                        guiState.deadline = currentDeadline(&deadline);
+                        markDirty(&guiState);
+                    }
+                    continue;
+                }
+
+                // Handle events based on current screen
+                switch (guiState.currentScreen) {
+                    case 0: // Main Menu
+                        handleMainMenuEvents(&e, &guiState);
+                        break;
+                    case 1: // Register Voter
+                        handleRegisterVoterEvents(&e, &guiState, renderer, font);
+                        break;
+                    case 2: // Cast Vote
+                        handleCastVoteEvents(&e, &guiState, renderer, font);
+                        break;
+                    case 3: // Candidate Management
+                        handleCandidateManagementEvents(&e, &guiState);
+                        break;
+                    case 4: // Live Results
+                        handleResultsDashboardEvents(&e, &guiState);
+                        break;
+                }
+
+                // Pointer movement alone never changes what is on screen
+                if (e.type != SDL_MOUSEMOTION) {
+                    markDirty(&guiState);
+                }
+            } while (SDL_PollEvent(&e));
         }
  
         // Count votes if voting is still ongoing and integrity is maintained
        /* if (guiState.integrityFailed == 0) {
-            countVotes(&bc, candidates, numCandidates);
+            countVotes(&bc, candidates.items, candidates.count);
         }*/
 
-        SDL_Delay(16);  // Cap at ~60 FPS
+        if (idleBenchSeconds > 0 && SDL_GetTicks() - startTicks >= (Uint32)idleBenchSeconds * 1000) {
+            struct rusage usage;
+            getrusage(RUSAGE_SELF, &usage);
+            double cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 +
+                                usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+            double wallSeconds = (SDL_GetTicks() - startTicks) / 1000.0;
+            printf("Idle benchmark: %.1f s wall, %.3f s CPU (%.2f%%), %d frames rendered\n",
+                   wallSeconds, cpuSeconds, 100.0 * cpuSeconds / wallSeconds, framesRendered);
+            quit = 1;
+        }
     }
 
     // Cleanup
+    stopCommitWorker(&worker);
+    METRICS_STOP_REPORTER();
+    stopDeadlineWatch(&deadline);
+    freeLiveResults(&results);
+    freePrefixIndex(&voterIndex);
+    freePrefixIndex(&candidateIndex);
+    freeCandidateTable(&candidates);
+    destroyAVLTree(&voterTree);
+    clearTextCache();
     TTF_CloseFont(font);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
     TTF_Quit();
     SDL_Quit();
+    logStop();
 
     return 0;
 }
@@ -921,30 +1378,33 @@ int main() {
 // Main menu event handler
 void handleMainMenuEvents(SDL_Event* e, GUIState* guiState) {
     if (e->type == SDL_MOUSEBUTTONDOWN) {
-        int x = e->button.x, y = e->button.y;
+        int widget = hitWidget(mainMenuWidgets, WIDGET_COUNT(mainMenuWidgets), e->button.x, e->button.y);
 
         // Register Voter Button
-        if (x >= 350 && x <= 650 && y >= 200 && y <= 250) {
+        if (widget == MAIN_REGISTER) {
             guiState->currentScreen = 1;  // Go to Register Voter screen
             guiState->errorMessage[0] = '\0';  // Clear any error message
         }
         // Cast Vote Button
-        else if (x >= 350 && x <= 650 && y >= 270 && y <= 320) {
+        else if (widget == MAIN_CAST_VOTE) {
             guiState->currentScreen = 2;  // Go to Cast Vote screen
             guiState->errorMessage[0] = '\0';  // Clear any error message
         }
         // Candidate Management Button
-        else if (x >= 350 && x <= 650 && y >= 340 && y <= 390) {
+        else if (widget == MAIN_CANDIDATES) {
             guiState->currentScreen = 3;  // Go to Candidate Management screen
             guiState->errorMessage[0] = '\0';  // Clear any error message
         }
+        // Live Results Button
+        else if (widget == MAIN_RESULTS) {
+            guiState->currentScreen = 4;  // Go to Live Results screen
+        }
        
         // Exit Button
-        else if (x >= 350 && x <= 650 && y >= 550 && y <= 600) {
+        else if (widget == MAIN_EXIT) {
             SDL_Event quitEvent;
             quitEvent.type = SDL_QUIT;
             SDL_PushEvent(&quitEvent);  // Trigger quit event
         }
     }
 }
-
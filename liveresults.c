@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "liveresults.h"
+
+/*
+Sets up the counters from one tally of the captured chain prefix.
+Returns 0 on success, -1 if memory runs out.
+*/
+int initLiveResults(liveResults *results, const chainSnapshot *snapshot, CandidateTable *table) {
+    memset(results, 0, sizeof(*results));
+    results->votes = calloc(table->count > 0 ? table->count : 1, sizeof(int));
+    if (results->votes == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    results->numCandidates = table->count;
+    results->intact = tallyChainSnapshot(snapshot, table->items, table->count, results->votes, 0);
+    if (results->intact < 0) {
+        free(results->votes);
+        results->votes = NULL;
+        return -1;
+    }
+    memcpy(results->baseRoot, snapshot->root, SHA256_DIGEST_LENGTH);
+    results->baseLength = snapshot->length;
+
+    unsigned long counted = 0;
+    for (int i = 0; i < table->count; i++) {
+        counted += results->votes[i];
+    }
+    results->otherVotes = snapshot->length - counted;
+    return 0;
+}
+
+void freeLiveResults(liveResults *results) {
+    free(results->votes);
+    results->votes = NULL;
+    results->numCandidates = 0;
+}
+
+// candidate is the table index of the ballot's candidate, or -1 if it is not in the table
+void recordCommittedVote(liveResults *results, int candidate, unsigned int latencyMs) {
+    time_t now = time(NULL);
+    int bucket = now % RATE_BUCKETS;
+
+    if (candidate >= 0 && candidate < results->numCandidates) {
+        results->votes[candidate]++;
+    } else {
+        results->otherVotes++;
+    }
+    results->committed++;
+
+    results->latencies[results->latencyCount % LATENCY_WINDOW] = latencyMs;
+    results->latencyCount++;
+
+    if (results->rateSeconds[bucket] != now) {
+        results->rateSeconds[bucket] = now;
+        results->rateCounts[bucket] = 0;
+    }
+    results->rateCounts[bucket]++;
+    results->version++;
+}
+
+static int compareLatency(const void *a, const void *b) {
+    unsigned int x = *(const unsigned int *)a, y = *(const unsigned int *)b;
+    return (x > y) - (x < y);
+}
+
+// Latency in ms at the given percentile (0-100) over the last LATENCY_WINDOW commits
+unsigned int latencyPercentile(liveResults *results, double percentile) {
+    unsigned int sorted[LATENCY_WINDOW];
+    unsigned long n = results->latencyCount < LATENCY_WINDOW ? results->latencyCount : LATENCY_WINDOW;
+
+    if (n == 0) {
+        return 0;
+    }
+    memcpy(sorted, results->latencies, n * sizeof(unsigned int));
+    qsort(sorted, n, sizeof(unsigned int), compareLatency);
+
+    unsigned long rank = (unsigned long)(percentile / 100.0 * (n - 1) + 0.5);
+    return sorted[rank];
+}
+
+// Average commit rate over the last RATE_SPAN complete seconds
+double votesPerSecond(liveResults *results) {
+    time_t now = time(NULL);
+    unsigned long total = 0;
+
+    for (int i = 1; i <= RATE_SPAN; i++) {
+        int bucket = (now - i) % RATE_BUCKETS;
+        if (results->rateSeconds[bucket] == now - i) {
+            total += results->rateCounts[bucket];
+        }
+    }
+    return (double)total / RATE_SPAN;
+}
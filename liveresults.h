@@ -0,0 +1,41 @@
+#ifndef LIVERESULTS_H
+#define LIVERESULTS_H
+
+#include <time.h>
+#include "blockchain.h"
+#include "chainsnapshot.h"
+
+#define LATENCY_WINDOW 1024    // most recent commit latencies kept for percentiles
+#define RATE_BUCKETS 8         // one bucket per wall-clock second
+#define RATE_SPAN 5            // votes/sec is averaged over this many full seconds
+
+/*
+Running results for the live dashboard.
+The chain is tallied once, from a snapshot, when the counters are set up; after that every
+committed ballot bumps its candidate's counter, so the dashboard never rescans the chain.
+baseRoot is the Merkle root of the baseLength blocks in that first tally; commits of
+blocks with seq < baseLength are already counted and must not be recorded again.
+version changes on every update, which lets the GUI skip redraws when nothing moved.
+*/
+typedef struct liveResults {
+    int *votes;                 // indexed like the candidate table
+    int numCandidates;
+    unsigned long otherVotes;   // ballots for IDs not in the candidate table
+    unsigned char baseRoot[SHA256_DIGEST_LENGTH];
+    unsigned long baseLength;
+    int intact;                 // 1 if the snapshot blocks hashed to baseRoot
+    unsigned long committed;
+    unsigned int latencies[LATENCY_WINDOW];
+    unsigned long latencyCount;
+    unsigned long rateCounts[RATE_BUCKETS];
+    time_t rateSeconds[RATE_BUCKETS];
+    unsigned long version;
+} liveResults;
+
+int initLiveResults(liveResults *results, const chainSnapshot *snapshot, CandidateTable *table);
+void freeLiveResults(liveResults *results);
+void recordCommittedVote(liveResults *results, int candidate, unsigned int latencyMs);
+unsigned int latencyPercentile(liveResults *results, double percentile);
+double votesPerSecond(liveResults *results);
+
+#endif
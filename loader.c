@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "blockchain.h"
+#include "loader.h"
+#include "segment.h"
+#include "logging.h"
+
+#define CHUNK_BLOCKS (1UL << LOADER_CHUNK_LEVEL)
+#define LEGACY_FIXED (2 * sizeof(size_t))                      // the two string lengths
+#define RECORD_FIXED (LEGACY_FIXED + sizeof(uint64_t) + sizeof(int64_t))  // plus seq and timestamp
+
+typedef struct loadJob {
+    const unsigned char *map;
+    unsigned long sealed;      // blocks decoded from cold segments ahead of the file's records
+    size_t sealedStrings;      // bytes of their IDs at the start of the string arena
+    size_t dataStart;          // offset of the first record, after the file header
+    size_t fixed;              // bytes before the strings of a record
+    size_t overhead;           // non-string bytes per record
+    uint64_t *offsets;         // file offset of every record found by the scanner, after the sealed ones
+    block *blocks;
+    char *strings;
+    unsigned char (*chunkRoots)[SHA256_DIGEST_LENGTH];
+    unsigned char (*chunkLast)[SHA256_DIGEST_LENGTH];  // full hash of each chunk's last block
+    merkleAccumulator partial; // accumulator of the trailing chunk when it is not full
+    int verify;
+    int altered;
+    unsigned long scanned;
+    unsigned long total;
+    int scanDone;
+    unsigned long nextChunk;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} loadJob;
+
+static size_t readLength(const unsigned char *p) {
+    size_t len;
+    memcpy(&len, p, sizeof(len));
+    return len;
+}
+
+// prevhash of block i; sealed blocks are already decoded
+static const unsigned char *recordPrevhash(loadJob *job, unsigned long i) {
+    if (i < job->sealed) {
+        return job->blocks[i].prevhash;
+    }
+    const unsigned char *p = job->map + job->offsets[i - job->sealed];
+    return p + job->fixed + readLength(p) + readLength(p + sizeof(size_t));
+}
+
+// Decodes record i of the file into block i; sealed blocks come decoded from their segments
+static void decodeRecord(loadJob *job, unsigned long i) {
+    unsigned long record = i - job->sealed;
+    const unsigned char *p = job->map + job->offsets[record];
+    size_t voterID_len = readLength(p);
+    size_t candID_len = readLength(p + sizeof(size_t));
+    // strings of a record start after the fixed bytes of the header and every earlier record
+    char *dest = job->strings + job->sealedStrings +
+                 (job->offsets[record] - job->dataStart - record * job->overhead);
+    block *b = &job->blocks[i];
+
+    memcpy(dest, p + job->fixed, voterID_len + candID_len);
+    dest[voterID_len - 1] = '\0';
+    dest[voterID_len + candID_len - 1] = '\0';
+    b->voterID = dest;
+    b->candID = dest + voterID_len;
+    if (job->fixed == RECORD_FIXED) {
+        memcpy(&b->seq, p + LEGACY_FIXED, sizeof(uint64_t));
+        memcpy(&b->timestamp, p + LEGACY_FIXED + sizeof(uint64_t), sizeof(int64_t));
+    } else {
+        b->seq = i;
+        b->timestamp = 0;
+    }
+    memcpy(b->prevhash, p + job->fixed + voterID_len + candID_len, SHA256_DIGEST_LENGTH);
+    b->next = &job->blocks[i + 1];
+}
+
+// Decodes, hashes and checks blocks [start, end) and reduces them to a Merkle subtree.
+static void decodeChunk(loadJob *job, unsigned long chunk, unsigned long start, unsigned long end) {
+    merkleAccumulator acc;
+    unsigned char leaf[SHA256_DIGEST_LENGTH];
+
+    merkleAccumulatorInit(&acc);
+    for (unsigned long i = start; i < end; i++) {
+        block *b = &job->blocks[i];
+        if (i >= job->sealed) {
+            decodeRecord(job, i);
+        }
+        hashBlock(b, leaf);
+        merkleAccumulatorAdd(&acc, leaf);
+        int intact = i + 1 >= end || hashCompare(leaf, (unsigned char *)recordPrevhash(job, i + 1));
+        // Order against the predecessor; the first block of a chunk is checked by the caller
+        if (i > start) {
+            intact = intact && b->seq == b[-1].seq + 1 && b->timestamp >= b[-1].timestamp;
+        }
+        if (job->verify && !intact) {
+            pthread_mutex_lock(&job->lock);
+            job->altered = 1;
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+
+    memcpy(job->chunkLast[chunk], leaf, SHA256_DIGEST_LENGTH);
+    if (end - start == CHUNK_BLOCKS) {
+        memcpy(job->chunkRoots[chunk], acc.frontier[LOADER_CHUNK_LEVEL], SHA256_DIGEST_LENGTH);
+    } else {
+        job->partial = acc;
+    }
+}
+
+// Worker: takes the next chunk once the scanner has found all of its records.
+static void *decodeWorker(void *arg) {
+    loadJob *job = (loadJob *)arg;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        unsigned long chunk = job->nextChunk++;
+        unsigned long start = chunk * CHUNK_BLOCKS;
+        unsigned long end = start + CHUNK_BLOCKS;
+        while (!job->scanDone && job->scanned < end) {
+            pthread_cond_wait(&job->cond, &job->lock);
+        }
+        if (job->scanDone && end > job->total) end = job->total;
+        pthread_mutex_unlock(&job->lock);
+
+        if (start >= end) break;
+        decodeChunk(job, chunk, start, end);
+    }
+    return NULL;
+}
+
+static void publishScanned(loadJob *job, unsigned long n, int done) {
+    pthread_mutex_lock(&job->lock);
+    job->scanned = n;
+    if (done) {
+        job->total = n;
+        job->scanDone = 1;
+    }
+    pthread_cond_broadcast(&job->cond);
+    pthread_mutex_unlock(&job->lock);
+}
+
+/*
+Loads filename into bc using numThreads decode workers (0 = one per online CPU).
+If verified is not NULL every prevhash link is checked during the load and *verified is
+set to 1 if the chain is intact and 0 otherwise. A truncated trailing record is ignored,
+like loadBlockchainFromFile does. Returns 0 on success and -1 on failure.
+*/
+int loadBlockchainParallel(blockchain *bc, const char *filename, int numThreads, int *verified) {
+    struct stat st;
+    loadJob job;
+    int status = -1;
+
+    resetBlockchain(bc);
+    if (verified) *verified = 1;
+
+    segmentStore store;
+    if (openSegmentStore(&store, filename) != 0) {
+        return -1;
+    }
+    unsigned long sealed = (unsigned long)sealedBlockCount(&store);
+    size_t sealedStrings = (size_t)sealedStringBytes(&store);
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open file for loading blockchain");
+        closeSegmentStore(&store);
+        return -1;
+    }
+    if (fstat(fd, &st) != 0) {
+        perror("Failed to stat blockchain file");
+        close(fd);
+        closeSegmentStore(&store);
+        return -1;
+    }
+    if (st.st_size == 0 && sealed == 0) {
+        close(fd);
+        closeSegmentStore(&store);
+        return 0;
+    }
+
+    size_t size = st.st_size;
+    void *map = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("Failed to map blockchain file");
+        closeSegmentStore(&store);
+        return -1;
+    }
+    if (map) {
+        madvise(map, size, MADV_SEQUENTIAL);
+        madvise(map, size, MADV_WILLNEED);
+    }
+
+    memset(&job, 0, sizeof(job));
+    job.fixed = LEGACY_FIXED;
+    if (size >= sizeof(chainFileHeader) && memcmp(map, CHAIN_FILE_MAGIC, 4) == 0) {
+        chainFileHeader header;
+        memcpy(&header, map, sizeof(header));
+        if (header.version != CHAIN_FILE_VERSION) {
+            LOG_ERROR("chain", "Unsupported chain file version %u", header.version);
+            munmap(map, size);
+            closeSegmentStore(&store);
+            return -1;
+        }
+        job.dataStart = sizeof(chainFileHeader);
+        job.fixed = RECORD_FIXED;
+    }
+    job.overhead = job.fixed + SHA256_DIGEST_LENGTH;
+
+    // Upper bounds: every record is at least its fixed bytes plus two 1-byte strings
+    unsigned long maxRecords = size / (job.overhead + 2) + 1;
+    unsigned long maxChunks = (sealed + maxRecords) / CHUNK_BLOCKS + 1;
+
+    job.map = map;
+    job.sealed = sealed;
+    job.sealedStrings = sealedStrings;
+    job.verify = verified != NULL;
+    job.offsets = malloc(maxRecords * sizeof(uint64_t));
+    job.blocks = malloc((sealed + maxRecords) * sizeof(block));
+    job.strings = malloc(sealedStrings + size + 1);
+    job.chunkRoots = malloc(maxChunks * SHA256_DIGEST_LENGTH);
+    job.chunkLast = malloc(maxChunks * SHA256_DIGEST_LENGTH);
+    if (!job.offsets || !job.blocks || !job.strings || !job.chunkRoots || !job.chunkLast) {
+        printf("Memory allocation failed\n");
+        goto done;
+    }
+    // Sealed blocks are decoded up front; the workers hash them with the file's records
+    if (decodeSegmentBlocks(&store, job.blocks, job.strings) != 0) {
+        goto done;
+    }
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.cond, NULL);
+    job.scanned = sealed;
+
+    if (numThreads <= 0) numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (numThreads <= 0) numThreads = 1;
+    pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+    int started = 0;
+    while (threads && started < numThreads &&
+           pthread_create(&threads[started], NULL, decodeWorker, &job) == 0) {
+        started++;
+    }
+
+    // Boundary scan on this thread; workers start decoding as soon as a chunk is complete
+    const unsigned char *bytes = map;
+    size_t offset = job.dataStart;
+    unsigned long n = 0;
+    uint64_t position = 0;
+    while (offset + job.fixed <= size) {
+        size_t voterID_len = readLength(bytes + offset);
+        size_t candID_len = readLength(bytes + offset + sizeof(size_t));
+        if (voterID_len == 0 || candID_len == 0 ||
+            voterID_len > size || candID_len > size ||
+            offset + job.overhead + voterID_len + candID_len > size) {
+            break;
+        }
+        // An interrupted seal leaves the sealed blocks at the front of the file
+        uint64_t seq = position++;
+        if (job.fixed == RECORD_FIXED) {
+            memcpy(&seq, bytes + offset + LEGACY_FIXED, sizeof(uint64_t));
+        }
+        if (n == 0 && seq < sealed) {
+            offset += job.overhead + voterID_len + candID_len;
+            continue;
+        }
+        job.offsets[n++] = offset;
+        offset += job.overhead + voterID_len + candID_len;
+        if (((sealed + n) & (CHUNK_BLOCKS - 1)) == 0) publishScanned(&job, sealed + n, 0);
+    }
+    publishScanned(&job, sealed + n, 1);
+
+    if (started == 0) decodeWorker(&job);  // no threads available: decode inline
+    for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+    free(threads);
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+
+    unsigned long total = sealed + n;
+    if (total > 0) {
+        unsigned long chunks = (total + CHUNK_BLOCKS - 1) / CHUNK_BLOCKS;
+        unsigned long fullChunks = total / CHUNK_BLOCKS;
+
+        for (unsigned long c = 0; c + 1 < chunks; c++) {
+            block *first = &job.blocks[(c + 1) * CHUNK_BLOCKS];
+            if (!hashCompare(job.chunkLast[c], first->prevhash) ||
+                first->seq != first[-1].seq + 1 || first->timestamp < first[-1].timestamp) {
+                job.altered = 1;
+            }
+        }
+        for (unsigned long c = 0; c < fullChunks; c++) {
+            merkleAccumulatorAddSubtree(&bc->merkle_acc, job.chunkRoots[c], LOADER_CHUNK_LEVEL);
+        }
+        for (int level = LOADER_CHUNK_LEVEL - 1; level >= 0; level--) {
+            if ((job.partial.count >> level) & 1) {
+                merkleAccumulatorAddSubtree(&bc->merkle_acc, job.partial.frontier[level], level);
+            }
+        }
+
+        job.blocks[total - 1].next = NULL;
+        bc->head = &job.blocks[0];
+        bc->tail = &job.blocks[total - 1];
+        bc->length = total;
+        bc->sealed = sealed;
+        memcpy(bc->tail_hash, job.chunkLast[chunks - 1], SHA256_DIGEST_LENGTH);
+        merkleAccumulatorRoot(&bc->merkle_acc, bc->merkle_root);
+        job.blocks = NULL;   // now owned by the chain
+        job.strings = NULL;
+    }
+    if (verified) *verified = !job.altered;
+    LOG_INFO("chain", "Blockchain loaded successfully from %s (%lu blocks, %lu of them sealed, %d threads)",
+             filename, total, sealed, started);
+    status = 0;
+
+done:
+    free(job.offsets);
+    free(job.blocks);
+    free(job.strings);
+    free(job.chunkRoots);
+    free(job.chunkLast);
+    if (map) munmap(map, size);
+    closeSegmentStore(&store);
+    return status;
+}
+
+// The block arena starts at the head block and the string arena at its voterID
+void freeLoadedBlockchain(blockchain *bc) {
+    if (bc->head != NULL) {
+        free(bc->head->voterID);
+        free(bc->head);
+    }
+    resetBlockchain(bc);
+}
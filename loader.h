@@ -0,0 +1,27 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "blockchain.h"
+
+#define LOADER_CHUNK_LEVEL 12  // blocks are decoded in aligned chunks of 2^12
+
+/*
+Parallel chain loader.
+
+The file is mapped once. The calling thread scans record boundaries (the two string
+lengths of each record) while worker threads decode each finished chunk into one
+preallocated block/string arena, hash its blocks, optionally check every prevhash link and
+the seq/timestamp order, and reduce the chunk to a Merkle subtree root. Blocks sealed into
+cold segments (segment.h) are decoded into the front of the arenas first and go through
+the same chunks, so the root and the checks cover them as well. Legacy files without a
+header load with seq = position and timestamp = 0. The chain comes back fully linked with
+its accumulator, tail hash and root rebuilt, exactly as loadBlockchainFromFile would
+leave it.
+
+Blocks live in the arena, so they must not be freed one by one; freeLoadedBlockchain
+releases the whole arena and empties the chain.
+*/
+int loadBlockchainParallel(blockchain *bc, const char *filename, int numThreads, int *verified);
+void freeLoadedBlockchain(blockchain *bc);
+
+#endif
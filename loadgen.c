@@ -0,0 +1,386 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "prefixindex.h"
+#include "segment.h"
+
+#define LOADGEN_ID_CHARSET "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+#define LOADGEN_MAX_PRECINCTS 36
+#define LOADGEN_VOTERS_PER_PRECINCT 1000000  // six digits after the precinct character
+
+/*
+Deterministic synthetic election generator.
+
+Voters get 7-character IDs (precinct character + 6 digits) so they fit VoterNode.voterID.
+Ballots visit a shuffled permutation of the voters until the turnout is reached.
+Candidates are drawn from a Zipf distribution over M candidates, where s = 0 is uniform.
+A configurable share of ballots is replaced by invalid ones (an unregistered voter or
+an unknown candidate), which the core rejects without marking anyone, or by repeats of
+a voter whose earlier ballot was valid. All randomness comes from one seeded splitmix64
+stream, so a seed always reproduces the same files and the same load.
+
+    loadgen [options] --out DIR     write voters.txt, candidates.txt and ballots.txt for the CLI
+    loadgen [options] --drive DIR   register and vote through insertVoter/castVote in DIR
+*/
+typedef struct loadgenConfig {
+    unsigned long voters;
+    int candidates;
+    int precincts;
+    double turnout;
+    double zipf;
+    double invalidRate;
+    double doubleRate;
+    uint64_t seed;
+} loadgenConfig;
+
+typedef struct loadgenStats {
+    unsigned long ballots;
+    unsigned long valid;
+    unsigned long invalid;
+    unsigned long doubles;
+} loadgenStats;
+
+static uint64_t rngState;
+
+static uint64_t nextRandom(void) {
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform double in [0, 1)
+static double nextUniform(void) {
+    return (nextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static unsigned long nextBelow(unsigned long n) {
+    return (unsigned long)(nextUniform() * n);
+}
+
+static void voterIDFor(const loadgenConfig *config, unsigned long index, char *out) {
+    snprintf(out, 16, "%c%06u", LOADGEN_ID_CHARSET[index % config->precincts],
+             (unsigned)(index / config->precincts % LOADGEN_VOTERS_PER_PRECINCT));
+}
+
+// Same XXXXX-XXXXX shape as generateUniqueID, but drawn from the seeded stream
+static void candidateIDFor(char *out) {
+    for (int i = 0; i < 11; i++) {
+        out[i] = i == 5 ? '-' : LOADGEN_ID_CHARSET[nextBelow(sizeof(LOADGEN_ID_CHARSET) - 1)];
+    }
+    out[11] = '\0';
+}
+
+// Cumulative Zipf weights: rank k has weight 1 / k^s
+static double *buildZipfTable(int n, double s) {
+    double *cdf = malloc(n * sizeof(double));
+    double total = 0;
+
+    if (!cdf) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    for (int k = 0; k < n; k++) {
+        total += 1.0 / pow(k + 1, s);
+        cdf[k] = total;
+    }
+    for (int k = 0; k < n; k++) {
+        cdf[k] /= total;
+    }
+    return cdf;
+}
+
+static int sampleZipf(const double *cdf, int n) {
+    double u = nextUniform();
+    int lo = 0, hi = n - 1;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cdf[mid] < u) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+typedef void (*ballotSink)(void *ctx, const char *voterID, const char *candID);
+
+/*
+Produces the ballot stream in order and hands every ballot to sink.
+The stream depends only on the configuration and the candidate IDs.
+*/
+static int generateBallots(const loadgenConfig *config, char (*candIDs)[12],
+                           ballotSink sink, void *ctx, loadgenStats *stats) {
+    unsigned long target = (unsigned long)(config->turnout * config->voters + 0.5);
+    uint32_t *order = malloc(config->voters * sizeof(uint32_t));
+    double *cdf = buildZipfTable(config->candidates, config->zipf);
+    char voterID[16], badID[16];
+
+    memset(stats, 0, sizeof(*stats));
+    if (!order || !cdf) {
+        printf("Memory allocation failed\n");
+        free(order);
+        free(cdf);
+        return -1;
+    }
+
+    // Fisher-Yates over voter indices; the prefix of length target is who turns out.
+    // Once slot i is used, order[0..valid) is reused for the voters who cast a valid ballot.
+    for (unsigned long i = 0; i < config->voters; i++) {
+        order[i] = (uint32_t)i;
+    }
+    for (unsigned long i = 0; i < target; i++) {
+        unsigned long j = i + nextBelow(config->voters - i);
+        uint32_t tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    for (unsigned long i = 0; i < target; i++) {
+        double roll = nextUniform();
+        const char *candID = candIDs[sampleZipf(cdf, config->candidates)];
+
+        if (roll < config->invalidRate) {
+            // Half unregistered voters (lower case is never generated), half unknown candidates
+            if (nextRandom() & 1) {
+                snprintf(voterID, sizeof(voterID), "x%06lu", nextBelow(LOADGEN_VOTERS_PER_PRECINCT));
+                sink(ctx, voterID, candID);
+            } else {
+                voterIDFor(config, order[i], voterID);
+                snprintf(badID, sizeof(badID), "ZZZZZ-%05lu", nextBelow(100000));
+                sink(ctx, voterID, badID);
+            }
+            stats->invalid++;
+        } else if (roll < config->invalidRate + config->doubleRate && stats->valid > 0) {
+            voterIDFor(config, order[nextBelow(stats->valid)], voterID);
+            sink(ctx, voterID, candID);
+            stats->doubles++;
+        } else {
+            voterIDFor(config, order[i], voterID);
+            sink(ctx, voterID, candID);
+            order[stats->valid++] = order[i];
+        }
+        stats->ballots++;
+    }
+
+    free(order);
+    free(cdf);
+    return 0;
+}
+
+static void writeBallot(void *ctx, const char *voterID, const char *candID) {
+    fprintf((FILE *)ctx, "%s,%s\n", voterID, candID);
+}
+
+typedef struct driveContext {
+    blockchain *bc;
+    AVLTree *tree;
+    prefixIndex candidates;
+} driveContext;
+
+// The same checks the CLI makes before a ballot reaches the chain
+static void driveBallot(void *ctx, const char *voterID, const char *candID) {
+    driveContext *drive = (driveContext *)ctx;
+    char voter[16], cand[16];
+
+    if (!prefixIndexContains(&drive->candidates, candID)) {
+        return;
+    }
+    snprintf(voter, sizeof(voter), "%s", voterID);
+    snprintf(cand, sizeof(cand), "%s", candID);
+    if (updateVoting(drive->tree, voter) == 0) {
+        castVote(voter, cand, drive->bc);
+    }
+}
+
+static int writeCandidates(const char *path, int count, char (*candIDs)[12]) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        perror("Error opening candidates file");
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        fprintf(file, "%s,Candidate %d\n", candIDs[i], i + 1);
+    }
+    fclose(file);
+    return 0;
+}
+
+static int writeFiles(const loadgenConfig *config, const char *dir, char (*candIDs)[12],
+                      loadgenStats *stats) {
+    char path[4096];
+    char voterID[16];
+
+    snprintf(path, sizeof(path), "%s/candidates.txt", dir);
+    if (writeCandidates(path, config->candidates, candIDs) != 0) {
+        return -1;
+    }
+
+    snprintf(path, sizeof(path), "%s/voters.txt", dir);
+    FILE *voters = fopen(path, "w");
+    if (!voters) {
+        perror("Error opening voters file");
+        return -1;
+    }
+    setvbuf(voters, NULL, _IOFBF, 1 << 20);
+    for (unsigned long i = 0; i < config->voters; i++) {
+        voterIDFor(config, i, voterID);
+        fprintf(voters, "%s\n", voterID);
+    }
+    fclose(voters);
+
+    snprintf(path, sizeof(path), "%s/ballots.txt", dir);
+    FILE *ballots = fopen(path, "w");
+    if (!ballots) {
+        perror("Error opening ballots file");
+        return -1;
+    }
+    setvbuf(ballots, NULL, _IOFBF, 1 << 20);
+    int status = generateBallots(config, candIDs, writeBallot, ballots, stats);
+    fclose(ballots);
+    return status;
+}
+
+static double elapsedSince(struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Runs the election in dir through the per-record core paths used by the GUI
+static int driveCore(const loadgenConfig *config, const char *dir, char (*candIDs)[12],
+                     loadgenStats *stats) {
+    char voterID[16];
+    struct timespec start;
+
+    if (chdir(dir) != 0) {
+        perror("Error entering drive directory");
+        return -1;
+    }
+    // Start from an empty election so runs are comparable
+    remove("blockchain_data.bin");
+    remove("blockchain_data.bin" SEGMENT_FILE_SUFFIX);
+    remove("blockchain_data.bin" SEGMENT_INDEX_SUFFIX);
+    remove("voter_data.bin");
+    remove("voter_data.bin" REGISTRY_STATS_SUFFIX);
+    if (writeCandidates(CANDIDATES_FILE, config->candidates, candIDs) != 0) {
+        return -1;
+    }
+
+    blockchain bc;
+    AVLTree tree;
+    initializeTree(&tree);
+    initializeBlockchain(&bc);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (unsigned long i = 0; i < config->voters; i++) {
+        voterIDFor(config, i, voterID);
+        insertVoter(&tree, voterID);
+    }
+    double registerSeconds = elapsedSince(&start);
+
+    CandidateTable table;
+    driveContext drive = {.bc = &bc, .tree = &tree};
+    if (loadCandidateTable(&table, CANDIDATES_FILE) < 0) {
+        return -1;
+    }
+    if (buildCandidatePrefixIndex(&drive.candidates, &table) != 0) {
+        freeCandidateTable(&table);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int status = generateBallots(config, candIDs, driveBallot, &drive, stats);
+    double voteSeconds = elapsedSince(&start);
+    freePrefixIndex(&drive.candidates);
+    freeCandidateTable(&table);
+    if (status != 0) {
+        return -1;
+    }
+
+    printf("Registered %lu voters in %.2f s (%.0f/s)\n", config->voters, registerSeconds,
+           registerSeconds > 0 ? config->voters / registerSeconds : 0.0);
+    printf("Processed %lu ballots in %.2f s (%.0f/s), chain length %lu\n", stats->ballots,
+           voteSeconds, voteSeconds > 0 ? stats->ballots / voteSeconds : 0.0, bc.length);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    printf("Usage: %s [options] (--out DIR | --drive DIR)\n", prog);
+    printf("  --voters N       registered voters (default 10000)\n");
+    printf("  --candidates M   candidates (default 8)\n");
+    printf("  --precincts P    precincts, 1-%d (default 10)\n", LOADGEN_MAX_PRECINCTS);
+    printf("  --turnout T      share of voters who cast a ballot (default 0.7)\n");
+    printf("  --zipf S         candidate popularity skew, 0 = uniform (default 1.0)\n");
+    printf("  --invalid R      share of invalid ballots (default 0.01)\n");
+    printf("  --double R       share of double-vote attempts (default 0.01)\n");
+    printf("  --seed X         RNG seed (default 42)\n");
+}
+
+int main(int argc, char *argv[]) {
+    loadgenConfig config = {10000, 8, 10, 0.7, 1.0, 0.01, 0.01, 42};
+    const char *outDir = NULL, *driveDir = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (value == NULL) {
+            usage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--voters") == 0) config.voters = strtoul(value, NULL, 10);
+        else if (strcmp(argv[i], "--candidates") == 0) config.candidates = atoi(value);
+        else if (strcmp(argv[i], "--precincts") == 0) config.precincts = atoi(value);
+        else if (strcmp(argv[i], "--turnout") == 0) config.turnout = atof(value);
+        else if (strcmp(argv[i], "--zipf") == 0) config.zipf = atof(value);
+        else if (strcmp(argv[i], "--invalid") == 0) config.invalidRate = atof(value);
+        else if (strcmp(argv[i], "--double") == 0) config.doubleRate = atof(value);
+        else if (strcmp(argv[i], "--seed") == 0) config.seed = strtoull(value, NULL, 10);
+        else if (strcmp(argv[i], "--out") == 0) outDir = value;
+        else if (strcmp(argv[i], "--drive") == 0) driveDir = value;
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+        i++;
+    }
+
+    if ((outDir == NULL) == (driveDir == NULL) || config.candidates <= 0 ||
+        config.precincts < 1 || config.precincts > LOADGEN_MAX_PRECINCTS ||
+        config.voters == 0 || config.voters > (unsigned long)config.precincts * LOADGEN_VOTERS_PER_PRECINCT ||
+        config.turnout < 0 || config.turnout > 1) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    rngState = config.seed;
+    char (*candIDs)[12] = malloc(config.candidates * sizeof(*candIDs));
+    if (!candIDs) {
+        printf("Memory allocation failed\n");
+        return 1;
+    }
+    for (int i = 0; i < config.candidates; i++) {
+        candidateIDFor(candIDs[i]);
+    }
+
+    const char *dir = outDir ? outDir : driveDir;
+    mkdir(dir, 0755);
+
+    loadgenStats stats;
+    int status = outDir ? writeFiles(&config, outDir, candIDs, &stats)
+                        : driveCore(&config, driveDir, candIDs, &stats);
+    if (status == 0) {
+        printf("Seed %llu: %lu voters, %d candidates, %lu ballots (%lu valid, %lu invalid, %lu double-vote attempts)\n",
+               (unsigned long long)config.seed, config.voters, config.candidates,
+               stats.ballots, stats.valid, stats.invalid, stats.doubles);
+    }
+
+    free(candIDs);
+    return status == 0 ? 0 : 1;
+}
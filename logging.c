@@ -0,0 +1,238 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include "logging.h"
+
+/*
+The ring is a bounded multi-producer queue: a producer claims a position by advancing
+head with a compare-and-swap, fills the slot and publishes it by storing position + 1
+in the slot's sequence. The single writer thread consumes in order and hands the slot
+back by storing position + LOG_RING_SLOTS.
+
+An idle writer sleeps on a condition variable. It sets writerWaiting before its last
+look at the ring and a producer reads the flag after publishing, all sequentially
+consistent, so either the writer sees the record or the producer sees the flag and
+signals. Producers are counted in activeProducers so logStop can wait for claimed
+slots to be published before it stops the writer.
+*/
+typedef struct logRecord {
+    unsigned long sequence;
+    int level;
+    struct timespec time;
+    char component[16];
+    char message[LOG_MESSAGE_MAX];
+} logRecord;
+
+int logLevel = LOG_LEVEL_INFO;
+
+static logRecord ring[LOG_RING_SLOTS];
+static unsigned long ringHead;
+static unsigned long ringTail;
+static unsigned long dropped;
+static FILE *sink;
+static int running;
+static int stopping;
+static int writerWaiting;
+static int activeProducers;
+static pthread_t writer;
+static pthread_mutex_t wakeLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+
+static const char *levelNames[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR"};
+
+static void formatRecord(FILE *out, const logRecord *record) {
+    struct tm tm;
+    char stamp[32];
+
+    localtime_r(&record->time.tv_sec, &tm);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%S", &tm);
+    fprintf(out, "%s.%03ld %-5s %s: %s\n", stamp, record->time.tv_nsec / 1000000,
+            levelNames[record->level], record->component, record->message);
+}
+
+static void fillRecord(logRecord *record, int level, const char *component,
+                       const char *format, va_list args) {
+    record->level = level;
+    clock_gettime(CLOCK_REALTIME, &record->time);
+    snprintf(record->component, sizeof(record->component), "%s", component);
+    vsnprintf(record->message, sizeof(record->message), format, args);
+}
+
+static void wakeWriter(void) {
+    pthread_mutex_lock(&wakeLock);
+    pthread_cond_signal(&wake);
+    pthread_mutex_unlock(&wakeLock);
+}
+
+void logWrite(int level, const char *component, const char *format, ...) {
+    va_list args;
+
+    __atomic_add_fetch(&activeProducers, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&running, __ATOMIC_SEQ_CST)) {
+        __atomic_sub_fetch(&activeProducers, 1, __ATOMIC_RELEASE);
+        logRecord record;
+        va_start(args, format);
+        fillRecord(&record, level, component, format, args);
+        va_end(args);
+        formatRecord(sink ? sink : stderr, &record);
+        return;
+    }
+
+    unsigned long pos = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+    logRecord *slot;
+    for (;;) {
+        slot = &ring[pos & (LOG_RING_SLOTS - 1)];
+        long diff = (long)(__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ringHead, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // Full: drop rather than wait for the writer
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            __atomic_sub_fetch(&activeProducers, 1, __ATOMIC_RELEASE);
+            return;
+        } else {
+            pos = __atomic_load_n(&ringHead, __ATOMIC_RELAXED);
+        }
+    }
+
+    va_start(args, format);
+    fillRecord(slot, level, component, format, args);
+    va_end(args);
+    __atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&writerWaiting, __ATOMIC_SEQ_CST)) {
+        wakeWriter();
+    }
+    __atomic_sub_fetch(&activeProducers, 1, __ATOMIC_RELEASE);
+}
+
+// Writes out every published record; returns how many were written
+static int drainRing(void) {
+    int written = 0;
+    for (;;) {
+        logRecord *slot = &ring[ringTail & (LOG_RING_SLOTS - 1)];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != ringTail + 1) {
+            return written;
+        }
+        formatRecord(sink, slot);
+        __atomic_store_n(&slot->sequence, ringTail + LOG_RING_SLOTS, __ATOMIC_RELEASE);
+        ringTail++;
+        written++;
+    }
+}
+
+static int recordReady(void) {
+    logRecord *slot = &ring[ringTail & (LOG_RING_SLOTS - 1)];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_SEQ_CST) == ringTail + 1;
+}
+
+// Sleeps until a record is published at the tail or logStop asks the writer to exit
+static void waitForRecords(void) {
+    pthread_mutex_lock(&wakeLock);
+    __atomic_store_n(&writerWaiting, 1, __ATOMIC_SEQ_CST);
+    while (!recordReady() && !__atomic_load_n(&stopping, __ATOMIC_ACQUIRE)) {
+        pthread_cond_wait(&wake, &wakeLock);
+    }
+    __atomic_store_n(&writerWaiting, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&wakeLock);
+}
+
+static void *writerThread(void *arg) {
+    (void)arg;
+    unsigned long reportedDrops = 0;
+
+    for (;;) {
+        int stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+        if (drainRing() == 0) {
+            unsigned long drops = logDropped();
+            if (drops != reportedDrops) {
+                fprintf(sink, "logging: %lu records dropped (ring full)\n", drops - reportedDrops);
+                reportedDrops = drops;
+            }
+            fflush(sink);
+            if (stop) {
+                return NULL;
+            }
+            waitForRecords();
+        }
+    }
+}
+
+static int parseLevel(const char *name) {
+    const char *names[] = {"trace", "debug", "info", "warn", "error", "off"};
+    for (int i = 0; i <= LOG_LEVEL_OFF; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            return i;
+        }
+    }
+    return LOG_LEVEL_INFO;
+}
+
+/*
+Reads VOTING_LOG_LEVEL / VOTING_LOG_FILE and starts the background writer.
+Returns 0 on success, -1 if the writer could not be started (logging stays synchronous).
+*/
+int logStart(void) {
+    const char *level = getenv("VOTING_LOG_LEVEL");
+    const char *file = getenv("VOTING_LOG_FILE");
+
+    if (running) {
+        return 0;
+    }
+    if (level) {
+        logLevel = parseLevel(level);
+    }
+    sink = stderr;
+    if (file && (sink = fopen(file, "a")) == NULL) {
+        perror("Error opening log file");
+        sink = stderr;
+    }
+
+    for (unsigned long i = 0; i < LOG_RING_SLOTS; i++) {
+        ring[i].sequence = i;
+    }
+    ringHead = ringTail = 0;
+    stopping = 0;
+    if (pthread_create(&writer, NULL, writerThread, NULL) != 0) {
+        return -1;
+    }
+    __atomic_store_n(&running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+/*
+Flushes everything still queued and returns to synchronous logging. Producers that
+already claimed a slot finish publishing it before the writer is told to stop, so no
+record is left half-written in the ring.
+*/
+void logStop(void) {
+    if (!running) {
+        return;
+    }
+    __atomic_store_n(&running, 0, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&activeProducers, __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+    __atomic_store_n(&stopping, 1, __ATOMIC_RELEASE);
+    wakeWriter();
+    pthread_join(writer, NULL);
+    fflush(sink);
+    if (sink != stderr) {
+        fclose(sink);
+        sink = NULL;
+    }
+}
+
+void logSetLevel(int level) {
+    logLevel = level;
+}
+
+unsigned long logDropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
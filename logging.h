@@ -0,0 +1,58 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+/*
+Leveled logging for the core and the front-ends.
+
+Every record carries a timestamp, a level, a component name ("chain", "registry", ...)
+and a formatted message. Calls below LOG_COMPILE_LEVEL are removed by the compiler
+entirely (argument evaluation included); calls below the runtime level cost one compare.
+
+Once logStart has run, records are formatted on the calling thread into a fixed-size
+lock-free ring buffer and written out by a background thread, so a slow terminal or
+disk never stalls ingestion or verification. When the ring is full, records are dropped
+and counted instead of blocking. Before logStart, records are written synchronously.
+
+Runtime configuration comes from the environment:
+    VOTING_LOG_LEVEL   trace|debug|info|warn|error|off (default info)
+    VOTING_LOG_FILE    append records to this file instead of stderr
+*/
+enum {
+    LOG_LEVEL_TRACE,
+    LOG_LEVEL_DEBUG,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR,
+    LOG_LEVEL_OFF
+};
+
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_RING_SLOTS 4096    // power of two
+#define LOG_MESSAGE_MAX 224
+
+extern int logLevel;
+
+void logWrite(int level, const char *component, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+int logStart(void);
+void logStop(void);
+void logSetLevel(int level);
+unsigned long logDropped(void);
+
+#define LOG_ENABLED(level) ((level) >= LOG_COMPILE_LEVEL && (level) >= logLevel)
+
+#define LOG_AT(level, component, ...) \
+    do { \
+        if (LOG_ENABLED(level)) logWrite((level), (component), __VA_ARGS__); \
+    } while (0)
+
+#define LOG_TRACE(component, ...) LOG_AT(LOG_LEVEL_TRACE, component, __VA_ARGS__)
+#define LOG_DEBUG(component, ...) LOG_AT(LOG_LEVEL_DEBUG, component, __VA_ARGS__)
+#define LOG_INFO(component, ...) LOG_AT(LOG_LEVEL_INFO, component, __VA_ARGS__)
+#define LOG_WARN(component, ...) LOG_AT(LOG_LEVEL_WARN, component, __VA_ARGS__)
+#define LOG_ERROR(component, ...) LOG_AT(LOG_LEVEL_ERROR, component, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,233 @@
+#include "metrics.h"
+
+#ifdef VOTING_METRICS
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+typedef struct metricsThread {
+    uint64_t counts[METRIC_TIMER_COUNT][METRICS_BUCKETS];
+    uint64_t totals[METRIC_TIMER_COUNT];   // sum of recorded ns
+    uint64_t maxima[METRIC_TIMER_COUNT];
+    uint64_t counters[METRIC_COUNTER_COUNT];
+    struct metricsThread *next;
+} metricsThread;
+
+static const char *timerNames[METRIC_TIMER_COUNT] = {
+    "castVote", "merkleUpdate", "chainPersist", "registryPersist", "findVoter", "tally"
+};
+static const char *counterNames[METRIC_COUNTER_COUNT] = {
+    "blocksAppended", "blocksWritten", "votersWritten", "voterMisses", "filterRejects"
+};
+
+// Every thread that ever recorded; blocks are never freed so a dump can still read them
+static metricsThread *threads;
+static pthread_mutex_t threadsLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread metricsThread *local;
+
+static pthread_t reporter;
+static int reporterRunning;
+static int reporterStop;
+static int reporterInterval;
+static char reporterFile[4096];
+static pthread_mutex_t reporterLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reporterCond = PTHREAD_COND_INITIALIZER;
+
+uint64_t metricsNow(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+
+static metricsThread *localBlock(void) {
+    if (local == NULL) {
+        local = calloc(1, sizeof(metricsThread));
+        if (local == NULL) {
+            return NULL;
+        }
+        pthread_mutex_lock(&threadsLock);
+        local->next = threads;
+        threads = local;
+        pthread_mutex_unlock(&threadsLock);
+    }
+    return local;
+}
+
+// Values below 16 get their own bucket; above that, 16 buckets per power of two
+static int bucketFor(uint64_t ns) {
+    if (ns < METRICS_SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int msb = 63 - __builtin_clzll(ns);
+    int shift = msb - 4;
+    return (msb - 3) * METRICS_SUB_BUCKETS + (int)((ns >> shift) & (METRICS_SUB_BUCKETS - 1));
+}
+
+// Highest value that lands in bucket
+static uint64_t bucketValue(int bucket) {
+    if (bucket < METRICS_SUB_BUCKETS) {
+        return bucket;
+    }
+    int shift = bucket / METRICS_SUB_BUCKETS - 1;
+    uint64_t sub = METRICS_SUB_BUCKETS + bucket % METRICS_SUB_BUCKETS;
+    return ((sub + 1) << shift) - 1;
+}
+
+// Only the owning thread writes its block; relaxed stores keep concurrent dumps tear-free
+static void bump(uint64_t *slot, uint64_t amount) {
+    __atomic_store_n(slot, __atomic_load_n(slot, __ATOMIC_RELAXED) + amount, __ATOMIC_RELAXED);
+}
+
+void metricsRecord(int timer, uint64_t ns) {
+    metricsThread *block = localBlock();
+    if (block == NULL) {
+        return;
+    }
+    bump(&block->counts[timer][bucketFor(ns)], 1);
+    bump(&block->totals[timer], ns);
+    if (ns > __atomic_load_n(&block->maxima[timer], __ATOMIC_RELAXED)) {
+        __atomic_store_n(&block->maxima[timer], ns, __ATOMIC_RELAXED);
+    }
+}
+
+void metricsAdd(int counter, uint64_t amount) {
+    metricsThread *block = localBlock();
+    if (block != NULL) {
+        bump(&block->counters[counter], amount);
+    }
+}
+
+// Bucket bounds can overshoot, so the result is capped at the largest value seen
+static uint64_t percentile(const uint64_t *buckets, uint64_t count, uint64_t max, double p) {
+    uint64_t rank = (uint64_t)(p / 100.0 * count + 0.5);
+    uint64_t seen = 0;
+
+    if (rank == 0) rank = 1;
+    for (int b = 0; b < METRICS_BUCKETS; b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            uint64_t value = bucketValue(b);
+            return value < max ? value : max;
+        }
+    }
+    return 0;
+}
+
+// Writes a merged snapshot of every thread's metrics as JSON
+void metricsDump(FILE *file) {
+    static uint64_t merged[METRICS_BUCKETS];
+    uint64_t counters[METRIC_COUNTER_COUNT] = {0};
+
+    pthread_mutex_lock(&threadsLock);
+    fprintf(file, "{\"timestamp\": %ld, \"timers\": [\n", (long)time(NULL));
+    for (int t = 0; t < METRIC_TIMER_COUNT; t++) {
+        uint64_t count = 0, total = 0, max = 0;
+
+        memset(merged, 0, sizeof(merged));
+        for (metricsThread *block = threads; block; block = block->next) {
+            for (int b = 0; b < METRICS_BUCKETS; b++) {
+                uint64_t n = __atomic_load_n(&block->counts[t][b], __ATOMIC_RELAXED);
+                merged[b] += n;
+                count += n;
+            }
+            total += __atomic_load_n(&block->totals[t], __ATOMIC_RELAXED);
+            uint64_t blockMax = __atomic_load_n(&block->maxima[t], __ATOMIC_RELAXED);
+            if (blockMax > max) max = blockMax;
+        }
+
+        fprintf(file, "{\"name\": \"%s\", \"count\": %llu, \"mean_ns\": %.0f, \"p50_ns\": %llu, "
+                      "\"p90_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}%s\n",
+                timerNames[t], (unsigned long long)count, count ? (double)total / count : 0.0,
+                (unsigned long long)percentile(merged, count, max, 50),
+                (unsigned long long)percentile(merged, count, max, 90),
+                (unsigned long long)percentile(merged, count, max, 99),
+                (unsigned long long)percentile(merged, count, max, 99.9),
+                (unsigned long long)max, t + 1 < METRIC_TIMER_COUNT ? "," : "");
+    }
+
+    for (metricsThread *block = threads; block; block = block->next) {
+        for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+            counters[c] += __atomic_load_n(&block->counters[c], __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&threadsLock);
+
+    fprintf(file, "], \"counters\": {");
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        fprintf(file, "\"%s\": %llu%s", counterNames[c], (unsigned long long)counters[c],
+                c + 1 < METRIC_COUNTER_COUNT ? ", " : "");
+    }
+    fprintf(file, "}}\n");
+}
+
+// Replaces the snapshot file atomically so readers never see a partial dump
+static void writeSnapshot(void) {
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", reporterFile);
+
+    FILE *file = fopen(tmp, "w");
+    if (!file) {
+        perror("Error opening metrics file");
+        return;
+    }
+    metricsDump(file);
+    fclose(file);
+    rename(tmp, reporterFile);
+}
+
+static void *reporterThread(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&reporterLock);
+    while (!reporterStop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += reporterInterval / 1000;
+        deadline.tv_nsec += (long)(reporterInterval % 1000) * 1000000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&reporterCond, &reporterLock, &deadline);
+
+        pthread_mutex_unlock(&reporterLock);
+        writeSnapshot();
+        pthread_mutex_lock(&reporterLock);
+    }
+    pthread_mutex_unlock(&reporterLock);
+    return NULL;
+}
+
+/*
+Starts a thread that rewrites filename with a fresh snapshot every intervalMs.
+Returns 0 on success, -1 if the thread could not be started or one is already running.
+*/
+int metricsStartReporter(const char *filename, int intervalMs) {
+    if (reporterRunning) {
+        return -1;
+    }
+    snprintf(reporterFile, sizeof(reporterFile), "%s", filename);
+    reporterInterval = intervalMs > 0 ? intervalMs : METRICS_DEFAULT_INTERVAL_MS;
+    reporterStop = 0;
+    if (pthread_create(&reporter, NULL, reporterThread, NULL) != 0) {
+        return -1;
+    }
+    reporterRunning = 1;
+    return 0;
+}
+
+// Stops the reporter; it writes one last snapshot on the way out
+void metricsStopReporter(void) {
+    if (!reporterRunning) {
+        return;
+    }
+    pthread_mutex_lock(&reporterLock);
+    reporterStop = 1;
+    pthread_cond_signal(&reporterCond);
+    pthread_mutex_unlock(&reporterLock);
+    pthread_join(reporter, NULL);
+    reporterRunning = 0;
+}
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+Hot-path metrics, compiled in only when VOTING_METRICS is defined.
+
+Each thread records into its own block of counters and log-linear latency histograms
+(16 sub-buckets per power of two, so any percentile is within about 6% of the true value),
+so recording is a couple of relaxed stores with no lock and no sharing. A reporter
+thread periodically merges all thread blocks and rewrites a JSON snapshot file.
+
+Without VOTING_METRICS every macro below expands to nothing and metrics.c is empty.
+*/
+enum {
+    METRIC_CAST_VOTE,
+    METRIC_MERKLE_UPDATE,
+    METRIC_CHAIN_PERSIST,
+    METRIC_REGISTRY_PERSIST,
+    METRIC_FIND_VOTER,
+    METRIC_TALLY,
+    METRIC_TIMER_COUNT
+};
+
+enum {
+    COUNTER_BLOCKS_APPENDED,
+    COUNTER_BLOCKS_WRITTEN,
+    COUNTER_VOTERS_WRITTEN,
+    COUNTER_VOTER_MISSES,
+    COUNTER_FILTER_REJECTS,
+    METRIC_COUNTER_COUNT
+};
+
+#define METRICS_SUB_BUCKETS 16
+#define METRICS_BUCKETS 1024
+#define METRICS_DEFAULT_FILE "voting_metrics.json"
+#define METRICS_DEFAULT_INTERVAL_MS 1000
+
+#ifdef VOTING_METRICS
+
+uint64_t metricsNow(void);
+void metricsRecord(int timer, uint64_t ns);
+void metricsAdd(int counter, uint64_t amount);
+void metricsDump(FILE *file);
+int metricsStartReporter(const char *filename, int intervalMs);
+void metricsStopReporter(void);
+
+#define METRIC_TIMER_START(var) uint64_t var = metricsNow()
+#define METRIC_TIMER_STOP(timer, var) metricsRecord((timer), metricsNow() - (var))
+#define METRIC_ADD(counter, amount) metricsAdd((counter), (amount))
+#define METRICS_START_REPORTER(filename, intervalMs) metricsStartReporter((filename), (intervalMs))
+#define METRICS_STOP_REPORTER() metricsStopReporter()
+
+#else
+
+#define METRIC_TIMER_START(var) ((void)0)
+#define METRIC_TIMER_STOP(timer, var) ((void)0)
+#define METRIC_ADD(counter, amount) ((void)0)
+#define METRICS_START_REPORTER(filename, intervalMs) ((void)0)
+#define METRICS_STOP_REPORTER() ((void)0)
+
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "prefixindex.h"
+
+void initPrefixIndex(prefixIndex *index) {
+    index->entries = NULL;
+    index->count = index->capacity = 0;
+    index->pending = NULL;
+    index->pendingCount = 0;
+}
+
+void freePrefixIndex(prefixIndex *index) {
+    free(index->entries);
+    free(index->pending);
+    initPrefixIndex(index);
+}
+
+// First position in entries[0..count) whose key is not less than key
+static unsigned long lowerBound(const prefixEntry *entries, unsigned long count, const char *key) {
+    unsigned long lo = 0, hi = count;
+    while (lo < hi) {
+        unsigned long mid = lo + (hi - lo) / 2;
+        if (strcmp(entries[mid].key, key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static int reserveEntries(prefixIndex *index, unsigned long needed) {
+    if (needed <= index->capacity) {
+        return 0;
+    }
+    unsigned long capacity = index->capacity ? index->capacity : 1024;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    prefixEntry *entries = realloc(index->entries, capacity * sizeof(prefixEntry));
+    if (entries == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    index->entries = entries;
+    index->capacity = capacity;
+    return 0;
+}
+
+// Merges the pending array into the base array, back to front so it can be done in place
+static int mergePending(prefixIndex *index) {
+    if (reserveEntries(index, index->count + index->pendingCount) != 0) {
+        return -1;
+    }
+
+    long i = (long)index->count - 1;
+    long j = (long)index->pendingCount - 1;
+    long out = (long)(index->count + index->pendingCount) - 1;
+    while (j >= 0) {
+        if (i >= 0 && strcmp(index->entries[i].key, index->pending[j].key) > 0) {
+            index->entries[out--] = index->entries[i--];
+        } else {
+            index->entries[out--] = index->pending[j--];
+        }
+    }
+
+    index->count += index->pendingCount;
+    index->pendingCount = 0;
+    return 0;
+}
+
+/*
+Adds key to the index. Returns 0 on success, 1 if the key is already indexed
+and -1 if memory runs out (the key is then not indexed).
+*/
+int prefixIndexInsert(prefixIndex *index, const char *key, void *value) {
+    // A full buffer means the merge after an earlier insert ran out of memory; retry it
+    if (index->pendingCount == PREFIX_PENDING_MAX && mergePending(index) != 0) {
+        return -1;
+    }
+
+    unsigned long pos = lowerBound(index->entries, index->count, key);
+    if (pos < index->count && strcmp(index->entries[pos].key, key) == 0) {
+        return 1;
+    }
+    pos = lowerBound(index->pending, index->pendingCount, key);
+    if (pos < index->pendingCount && strcmp(index->pending[pos].key, key) == 0) {
+        return 1;
+    }
+
+    if (index->pending == NULL) {
+        index->pending = malloc(PREFIX_PENDING_MAX * sizeof(prefixEntry));
+        if (index->pending == NULL) {
+            printf("Memory allocation failed\n");
+            return -1;
+        }
+    }
+
+    memmove(&index->pending[pos + 1], &index->pending[pos],
+            (index->pendingCount - pos) * sizeof(prefixEntry));
+    index->pending[pos].key = key;
+    index->pending[pos].value = value;
+    index->pendingCount++;
+
+    if (index->pendingCount == PREFIX_PENDING_MAX) {
+        mergePending(index);  // on failure the key stays pending and the next insert retries
+    }
+    return 0;
+}
+
+// 1 if key itself is indexed, not merely a longer key it is a prefix of
+int prefixIndexContains(prefixIndex *index, const char *key) {
+    prefixEntry match;
+    return prefixIndexFind(index, key, &match, 1) == 1 && strcmp(match.key, key) == 0;
+}
+
+/*
+Copies up to maxMatches entries whose key starts with prefix into matches, in key order.
+An empty prefix matches everything. Returns the number of entries copied.
+*/
+int prefixIndexFind(prefixIndex *index, const char *prefix, prefixEntry *matches, int maxMatches) {
+    size_t len = strlen(prefix);
+    unsigned long i = lowerBound(index->entries, index->count, prefix);
+    unsigned long j = lowerBound(index->pending, index->pendingCount, prefix);
+    int found = 0;
+
+    while (found < maxMatches) {
+        int baseMatch = i < index->count && strncmp(index->entries[i].key, prefix, len) == 0;
+        int pendingMatch = j < index->pendingCount && strncmp(index->pending[j].key, prefix, len) == 0;
+
+        if (baseMatch && (!pendingMatch || strcmp(index->entries[i].key, index->pending[j].key) < 0)) {
+            matches[found++] = index->entries[i++];
+        } else if (pendingMatch) {
+            matches[found++] = index->pending[j++];
+        } else {
+            break;
+        }
+    }
+    return found;
+}
+
+/*
+Indexes every voter in the tree; each entry's value is its VoterNode, so the
+voted flag read through a match is always current. The in-order walk yields
+the keys already sorted by strcmp.
+*/
+int buildVoterPrefixIndex(prefixIndex *index, AVLTree *tree) {
+    uint32_t stack[AVL_MAX_HEIGHT];
+    uint32_t node = tree->root;
+    int top = 0;
+
+    initPrefixIndex(index);
+    if (reserveEntries(index, tree->stats.registered) != 0) {
+        return -1;
+    }
+    while (node != 0 || top > 0) {
+        while (node != 0 && top < AVL_MAX_HEIGHT) {
+            stack[top++] = node;
+            node = voterNodeAt(&tree->pool, node)->left;
+        }
+        VoterNode *voter = voterNodeAt(&tree->pool, stack[--top]);
+        if (reserveEntries(index, index->count + 1) != 0) {
+            return -1;
+        }
+        index->entries[index->count].key = voter->voterID;
+        index->entries[index->count].value = voter;
+        index->count++;
+        node = voter->right;
+    }
+    return 0;
+}
+
+static int compareEntries(const void *a, const void *b) {
+    return strcmp(((const prefixEntry *)a)->key, ((const prefixEntry *)b)->key);
+}
+
+/*
+Indexes every candidate ID; each entry's value points at its Candidate in the table.
+The index has to be rebuilt whenever the table is reloaded.
+*/
+int buildCandidatePrefixIndex(prefixIndex *index, CandidateTable *table) {
+    initPrefixIndex(index);
+    if (table->count == 0) {
+        return 0;
+    }
+    if (reserveEntries(index, table->count) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < table->count; i++) {
+        index->entries[i].key = table->items[i].id;
+        index->entries[i].value = &table->items[i];
+    }
+    index->count = table->count;
+    qsort(index->entries, index->count, sizeof(prefixEntry), compareEntries);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#ifndef PREFIXINDEX_H
+#define PREFIXINDEX_H
+
+#include "blockchain.h"
+#include "avl.h"
+
+#define PREFIX_PENDING_MAX 4096  // inserts buffered before they are merged into the base array
+
+/*
+Ordered index over ID strings for as-you-type lookups.
+
+Entries are kept in a sorted base array plus a small sorted pending array that takes
+new inserts; once it fills up it is merged into the base in one linear pass, so an
+insert never shifts the whole base. A prefix query is a lower_bound in both arrays
+followed by a merge of the matching runs, i.e. O(log n + matches).
+
+Keys are not copied: they point at the ID owned by the indexed record (a VoterNode
+or a Candidate), which must outlive the index.
+*/
+typedef struct prefixEntry {
+    const char *key;
+    void *value;
+} prefixEntry;
+
+typedef struct prefixIndex {
+    prefixEntry *entries;
+    unsigned long count;
+    unsigned long capacity;
+    prefixEntry *pending;
+    unsigned long pendingCount;
+} prefixIndex;
+
+void initPrefixIndex(prefixIndex *index);
+void freePrefixIndex(prefixIndex *index);
+int prefixIndexInsert(prefixIndex *index, const char *key, void *value);
+int prefixIndexFind(prefixIndex *index, const char *prefix, prefixEntry *matches, int maxMatches);
+int prefixIndexContains(prefixIndex *index, const char *key);
+int buildVoterPrefixIndex(prefixIndex *index, AVLTree *tree);
+int buildCandidatePrefixIndex(prefixIndex *index, CandidateTable *table);
+
+#endif
@@ -0,0 +1,856 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "loader.h"
+#include "segment.h"
+#include "logging.h"
+
+#define SEGMENT_ID_MAX 255          // IDs are stored with one-byte lengths
+#define SEGMENT_MAX_ROWS (1U << 20) // keeps every column offset well inside 32 bits
+
+typedef struct segmentIndexFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+} segmentIndexFileHeader;
+
+// Growable byte buffer used while a segment is being encoded
+typedef struct byteBuffer {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} byteBuffer;
+
+static int bufferAppend(byteBuffer *buf, const void *src, size_t n) {
+    if (buf->len + n > buf->cap) {
+        size_t cap = buf->cap ? buf->cap : 4096;
+        while (cap < buf->len + n) cap *= 2;
+        unsigned char *data = realloc(buf->data, cap);
+        if (data == NULL) {
+            printf("Memory allocation failed\n");
+            return -1;
+        }
+        buf->data = data;
+        buf->cap = cap;
+    }
+    memcpy(buf->data + buf->len, src, n);
+    buf->len += n;
+    return 0;
+}
+
+static int bufferAppendVarint(byteBuffer *buf, uint64_t value) {
+    unsigned char bytes[10];
+    int n = 0;
+    do {
+        bytes[n] = value & 0x7f;
+        value >>= 7;
+        if (value) bytes[n] |= 0x80;
+        n++;
+    } while (value);
+    return bufferAppend(buf, bytes, n);
+}
+
+// Reads one LEB128 value from *p, which must stay below end; returns -1 if it runs past
+static int readVarint(const unsigned char **p, const unsigned char *end, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; *p < end && shift < 64; shift += 7) {
+        unsigned char byte = *(*p)++;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static int readAt(FILE *file, uint64_t offset, void *out, size_t length) {
+    return fseek(file, (long)offset, SEEK_SET) == 0 && fread(out, 1, length, file) == length ? 0 : -1;
+}
+
+/*
+Opens the segments stored next to the chain file at chainPath. Missing files mean
+nothing has been sealed. Returns 0 on success and -1 if the index is unreadable.
+*/
+int openSegmentStore(segmentStore *store, const char *chainPath) {
+    segmentIndexFileHeader header;
+
+    memset(store, 0, sizeof(*store));
+    snprintf(store->archivePath, sizeof(store->archivePath), "%s%s", chainPath, SEGMENT_FILE_SUFFIX);
+    snprintf(store->indexPath, sizeof(store->indexPath), "%s%s", chainPath, SEGMENT_INDEX_SUFFIX);
+
+    FILE *file = fopen(store->indexPath, "rb");
+    if (!file) {
+        return 0;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, SEGMENT_INDEX_MAGIC, 4) != 0 || header.version != SEGMENT_VERSION) {
+        LOG_ERROR("segment", "Invalid segment index %s", store->indexPath);
+        fclose(file);
+        return -1;
+    }
+    if (header.count > 0) {
+        store->entries = malloc(header.count * sizeof(segmentIndexEntry));
+        if (store->entries == NULL ||
+            fread(store->entries, sizeof(segmentIndexEntry), header.count, file) != header.count) {
+            LOG_ERROR("segment", "Failed to read segment index %s", store->indexPath);
+            free(store->entries);
+            store->entries = NULL;
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    store->count = store->capacity = header.count;
+    return 0;
+}
+
+void closeSegmentStore(segmentStore *store) {
+    free(store->entries);
+    store->entries = NULL;
+    store->count = store->capacity = 0;
+}
+
+uint64_t sealedBlockCount(const segmentStore *store) {
+    if (store->count == 0) {
+        return 0;
+    }
+    const segmentIndexEntry *last = &store->entries[store->count - 1];
+    return last->firstSeq + last->rowCount;
+}
+
+// Arena size loadBlockchainParallel reserves for the IDs of the sealed blocks
+uint64_t sealedStringBytes(const segmentStore *store) {
+    uint64_t bytes = 0;
+    for (unsigned long i = 0; i < store->count; i++) {
+        bytes += store->entries[i].stringBytes;
+    }
+    return bytes;
+}
+
+// Replaces the index file atomically, so a crash leaves either the old or the new one
+static int writeSegmentIndex(const segmentStore *store) {
+    char tmpPath[310];
+    segmentIndexFileHeader header;
+
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", store->indexPath);
+    FILE *file = fopen(tmpPath, "wb");
+    if (!file) {
+        perror("Failed to open segment index for writing");
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEGMENT_INDEX_MAGIC, 4);
+    header.version = SEGMENT_VERSION;
+    header.count = store->count;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(store->entries, sizeof(segmentIndexEntry), store->count, file) == store->count;
+    if (fclose(file) != 0 || !ok || rename(tmpPath, store->indexPath) != 0) {
+        perror("Failed to write segment index");
+        remove(tmpPath);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+Encodes rows blocks starting at first into one segment and fills in entry's row count,
+time bounds and string bytes. The chain must be intact, so timestamps never decrease.
+Returns 0 on success and -1 if an ID is too long to seal or allocation failed.
+*/
+static int encodeSegment(block *first, uint32_t rows, byteBuffer *out, segmentIndexEntry *entry) {
+    byteBuffer dict = {0}, runs = {0}, restarts = {0}, voters = {0}, times = {0}, hashes = {0};
+    const char *dictIDs[256];
+    uint32_t dictCount = 0, runCount = 0, restartCount = 0;
+    segmentRun run = {0, UINT32_MAX};
+    char prevVoter[SEGMENT_ID_MAX + 1] = "";
+    int64_t prevTime = first->timestamp;
+    block *last = NULL;
+    int status = -1;
+
+    entry->firstSeq = first->seq;
+    entry->firstTimestamp = first->timestamp;
+    entry->rowCount = rows;
+    entry->stringBytes = 0;
+
+    block *current = first;
+    for (uint32_t row = 0; row < rows; row++, current = current->next) {
+        size_t voterLen = strlen(current->voterID);
+        size_t candLen = strlen(current->candID);
+        if (voterLen > SEGMENT_ID_MAX || candLen > SEGMENT_ID_MAX) {
+            printf("Block %lu has an ID longer than %d bytes; cannot seal\n",
+                   (unsigned long)current->seq, SEGMENT_ID_MAX);
+            goto done;
+        }
+        entry->stringBytes += voterLen + candLen + 2;
+
+        // Candidate column: dictionary index, run-length encoded
+        uint32_t d = 0;
+        while (d < dictCount && strcmp(dictIDs[d], current->candID) != 0) d++;
+        if (d == dictCount) {
+            if (dictCount == 256) {
+                printf("More than 256 distinct candidates in one segment; cannot seal\n");
+                goto done;
+            }
+            unsigned char len8 = (unsigned char)candLen;
+            dictIDs[dictCount++] = current->candID;
+            if (bufferAppend(&dict, &len8, 1) || bufferAppend(&dict, current->candID, candLen)) goto done;
+        }
+        if (d != run.dict) {
+            if (run.dict != UINT32_MAX) {
+                run.end = row;
+                if (bufferAppend(&runs, &run, sizeof(run))) goto done;
+                runCount++;
+            }
+            run.dict = d;
+        }
+
+        // Voter and time columns: deltas against the previous row, reset at restart points
+        unsigned char shared = 0;
+        if (bufferAppendVarint(&times, (uint64_t)(current->timestamp - prevTime))) goto done;
+        prevTime = current->timestamp;
+        if (row % SEGMENT_RESTART_INTERVAL == 0) {
+            segmentRestart restart = {(uint32_t)voters.len, (uint32_t)times.len, current->timestamp};
+            if (bufferAppend(&restarts, &restart, sizeof(restart))) goto done;
+            restartCount++;
+        } else {
+            while (shared < voterLen && prevVoter[shared] == current->voterID[shared]) shared++;
+        }
+        unsigned char suffixLen = (unsigned char)(voterLen - shared);
+        if (bufferAppend(&voters, &shared, 1) || bufferAppend(&voters, &suffixLen, 1) ||
+            bufferAppend(&voters, current->voterID + shared, suffixLen)) goto done;
+        memcpy(prevVoter, current->voterID, voterLen + 1);
+
+        if (bufferAppend(&hashes, current->prevhash, SHA256_DIGEST_LENGTH)) goto done;
+        last = current;
+    }
+    run.end = rows;
+    if (bufferAppend(&runs, &run, sizeof(run))) goto done;
+    runCount++;
+    entry->lastTimestamp = last->timestamp;
+
+    segmentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEGMENT_MAGIC, 4);
+    header.version = SEGMENT_VERSION;
+    header.firstSeq = first->seq;
+    header.rowCount = rows;
+    header.dictCount = dictCount;
+    header.runCount = runCount;
+    header.restartCount = restartCount;
+    header.dictOffset = sizeof(header);
+    // The fixed-width tables stay 8-byte aligned
+    header.runOffset = (header.dictOffset + (uint32_t)dict.len + 7) & ~7u;
+    header.restartOffset = header.runOffset + (uint32_t)runs.len;
+    header.voterOffset = header.restartOffset + (uint32_t)restarts.len;
+    header.timeOffset = header.voterOffset + (uint32_t)voters.len;
+    header.hashOffset = header.timeOffset + (uint32_t)times.len;
+    header.totalLength = header.hashOffset + (uint32_t)hashes.len;
+    hashBlock(last, header.lastHash);
+
+    static const unsigned char pad[8] = {0};
+    out->len = 0;
+    if (bufferAppend(out, &header, sizeof(header)) || bufferAppend(out, dict.data, dict.len) ||
+        bufferAppend(out, pad, header.runOffset - header.dictOffset - dict.len) ||
+        bufferAppend(out, runs.data, runs.len) || bufferAppend(out, restarts.data, restarts.len) ||
+        bufferAppend(out, voters.data, voters.len) || bufferAppend(out, times.data, times.len) ||
+        bufferAppend(out, hashes.data, hashes.len)) goto done;
+    entry->length = header.totalLength;
+    status = 0;
+
+done:
+    free(dict.data);
+    free(runs.data);
+    free(restarts.data);
+    free(voters.data);
+    free(times.data);
+    free(hashes.data);
+    return status;
+}
+
+/*
+Seals every complete range of rowsPerSegment blocks (0 = SEGMENT_ROWS) that is not yet
+sealed, then rewrites the chain file at chainPath with the remaining blocks only.
+bc must have been loaded from chainPath and be intact. The segments and their index are
+written before the chain file is replaced; if the replace does not happen, the loaders
+skip the blocks the chain file still holds from the sealed range.
+Returns the number of blocks sealed, or -1 on error.
+*/
+long sealChain(blockchain *bc, const char *chainPath, uint32_t rowsPerSegment) {
+    segmentStore store;
+    long total = 0;
+
+    if (rowsPerSegment == 0) rowsPerSegment = SEGMENT_ROWS;
+    if (rowsPerSegment % (1U << LOADER_CHUNK_LEVEL) != 0 || rowsPerSegment > SEGMENT_MAX_ROWS) {
+        printf("Segments must hold a multiple of %u rows, at most %u\n",
+               1U << LOADER_CHUNK_LEVEL, SEGMENT_MAX_ROWS);
+        return -1;
+    }
+    if (openSegmentStore(&store, chainPath) != 0) {
+        return -1;
+    }
+    uint64_t sealed = sealedBlockCount(&store);
+    if (sealed != bc->sealed) {
+        printf("%s does not match the loaded chain\n", store.archivePath);
+        closeSegmentStore(&store);
+        return -1;
+    }
+    if (bc->length < sealed + rowsPerSegment) {
+        closeSegmentStore(&store);
+        return 0;
+    }
+    if (bc->head->seq != 0 || verifyBlocks(bc, 0) != 1) {
+        printf("The chain failed verification; only an intact chain can be sealed\n");
+        closeSegmentStore(&store);
+        return -1;
+    }
+
+    // Drop whatever an interrupted seal appended past the last indexed segment
+    uint64_t archiveEnd = 0;
+    if (store.count > 0) {
+        archiveEnd = store.entries[store.count - 1].offset + store.entries[store.count - 1].length;
+    }
+    if (access(store.archivePath, F_OK) == 0 && truncate(store.archivePath, (off_t)archiveEnd) != 0) {
+        perror("Failed to trim the segment archive");
+        closeSegmentStore(&store);
+        return -1;
+    }
+    FILE *file = fopen(store.archivePath, "ab");
+    if (!file) {
+        perror("Failed to open segment archive for appending");
+        closeSegmentStore(&store);
+        return -1;
+    }
+
+    block *current = firstUnsealedBlock(bc);
+    byteBuffer encoded = {0};
+    int failed = 0;
+    while (bc->length - sealed >= rowsPerSegment) {
+        segmentIndexEntry entry;
+        if (encodeSegment(current, rowsPerSegment, &encoded, &entry) != 0) {
+            failed = 1;
+            break;
+        }
+        if (store.count == store.capacity) {
+            unsigned long capacity = store.capacity ? store.capacity * 2 : 16;
+            segmentIndexEntry *entries = realloc(store.entries, capacity * sizeof(segmentIndexEntry));
+            if (entries == NULL) {
+                printf("Memory allocation failed\n");
+                failed = 1;
+                break;
+            }
+            store.entries = entries;
+            store.capacity = capacity;
+        }
+        entry.offset = archiveEnd;
+        if (fwrite(encoded.data, 1, encoded.len, file) != encoded.len) {
+            perror("Failed to write segment");
+            failed = 1;
+            break;
+        }
+        store.entries[store.count++] = entry;
+        archiveEnd += encoded.len;
+
+        for (uint32_t i = 0; i < rowsPerSegment; i++) current = current->next;
+        sealed += rowsPerSegment;
+        total += rowsPerSegment;
+    }
+    free(encoded.data);
+    if (fclose(file) != 0) {
+        failed = 1;
+    }
+    // Only the index makes segments visible, so a failed write just leaves unused bytes
+    if (failed || writeSegmentIndex(&store) != 0) {
+        closeSegmentStore(&store);
+        return -1;
+    }
+
+    bc->sealed = sealed;
+    char tmpPath[310], indexPath[310];
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", chainPath);
+    if (writeChainFile(current, tmpPath) != 0 || rename(tmpPath, chainPath) != 0) {
+        perror("Failed to rewrite the chain file");
+        remove(tmpPath);
+        LOG_WARN("segment", "%s still holds the sealed blocks; they are skipped when it loads", chainPath);
+    }
+    // Offsets in the sparse index refer to the old chain file
+    snprintf(indexPath, sizeof(indexPath), "%s%s", chainPath, CHAIN_INDEX_SUFFIX);
+    remove(indexPath);
+
+    LOG_INFO("segment", "Sealed %ld blocks; %lu segments in %s", total, store.count, store.archivePath);
+    closeSegmentStore(&store);
+    return total;
+}
+
+// Reads and checks a whole segment; the caller frees it
+static unsigned char *readSegment(segmentStore *store, FILE *file, const segmentIndexEntry *entry) {
+    unsigned char *data = malloc(entry->length);
+    if (data == NULL) {
+        printf("Memory allocation failed\n");
+        return NULL;
+    }
+    const segmentHeader *header = (const segmentHeader *)data;
+    if (entry->length < sizeof(segmentHeader) || readAt(file, entry->offset, data, entry->length) != 0 ||
+        memcmp(header->magic, SEGMENT_MAGIC, 4) != 0 || header->version != SEGMENT_VERSION ||
+        header->totalLength != entry->length || header->rowCount != entry->rowCount ||
+        header->firstSeq != entry->firstSeq || header->hashOffset > entry->length ||
+        (uint64_t)header->rowCount * SHA256_DIGEST_LENGTH != entry->length - header->hashOffset) {
+        LOG_ERROR("segment", "Corrupt segment at offset %lu of %s",
+                  (unsigned long)entry->offset, store->archivePath);
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+// Splits the candidate dictionary into pointers and lengths; returns -1 if it is malformed
+static int readDictionary(const unsigned char *dict, const unsigned char *end, uint32_t count,
+                          const unsigned char **ids, unsigned char *lengths) {
+    if (count > 256) {
+        return -1;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        if (dict >= end || dict + 1 + dict[0] > end) {
+            return -1;
+        }
+        lengths[i] = dict[0];
+        ids[i] = dict + 1;
+        dict += 1 + dict[0];
+    }
+    return 0;
+}
+
+/*
+Row-by-row cursor over a segment in memory. A row is reached by decoding forward from
+the restart point at or before it, so positioning costs at most 16 prefix and time
+decodes and moving to the next row costs one of each.
+*/
+typedef struct segmentCursor {
+    const unsigned char *seg;
+    const segmentHeader *header;
+    const segmentRun *runs;
+    const unsigned char *dictIDs[256];
+    unsigned char dictLengths[256];
+    const unsigned char *voter, *voterEnd;
+    const unsigned char *time, *timeEnd;
+    uint32_t row;
+    uint32_t run;
+    int64_t timestamp;
+    char voterID[SEGMENT_ID_MAX + 1];
+} segmentCursor;
+
+// Checks the table layout of seg against its header; returns -1 if it does not add up
+static int openCursor(segmentCursor *cursor, const unsigned char *seg) {
+    const segmentHeader *header = (const segmentHeader *)seg;
+    uint32_t restarts = (header->rowCount + SEGMENT_RESTART_INTERVAL - 1) / SEGMENT_RESTART_INTERVAL;
+
+    memset(cursor, 0, sizeof(*cursor));
+    cursor->seg = seg;
+    cursor->header = header;
+    if (header->rowCount == 0 || header->runCount == 0 || header->runCount > header->rowCount ||
+        header->restartCount != restarts || header->runOffset < header->dictOffset ||
+        header->restartOffset != header->runOffset + header->runCount * sizeof(segmentRun) ||
+        header->voterOffset != header->restartOffset + restarts * sizeof(segmentRestart) ||
+        header->timeOffset < header->voterOffset || header->hashOffset < header->timeOffset ||
+        readDictionary(seg + header->dictOffset, seg + header->runOffset, header->dictCount,
+                       cursor->dictIDs, cursor->dictLengths) != 0) {
+        return -1;
+    }
+    cursor->runs = (const segmentRun *)(seg + header->runOffset);
+    cursor->voterEnd = seg + header->timeOffset;
+    cursor->timeEnd = seg + header->hashOffset;
+    return 0;
+}
+
+// Decodes the voter ID of the row the cursor has just moved to
+static int decodeVoter(segmentCursor *cursor) {
+    const unsigned char *p = cursor->voter;
+    if (p + 2 > cursor->voterEnd || p + 2 + p[1] > cursor->voterEnd ||
+        p[0] > strlen(cursor->voterID) || p[0] + p[1] > SEGMENT_ID_MAX) {
+        return -1;
+    }
+    memcpy(cursor->voterID + p[0], p + 2, p[1]);
+    cursor->voterID[p[0] + p[1]] = '\0';
+    cursor->voter = p + 2 + p[1];
+    return 0;
+}
+
+// Candidate run of the current row; runs only move forward while the cursor does
+static int findRun(segmentCursor *cursor) {
+    while (cursor->run < cursor->header->runCount && cursor->runs[cursor->run].end <= cursor->row) {
+        cursor->run++;
+    }
+    if (cursor->run == cursor->header->runCount ||
+        cursor->runs[cursor->run].dict >= cursor->header->dictCount) {
+        return -1;
+    }
+    return 0;
+}
+
+static int loadRestart(segmentCursor *cursor, uint32_t row) {
+    const segmentHeader *header = cursor->header;
+    const segmentRestart *restart =
+        (const segmentRestart *)(cursor->seg + header->restartOffset) + row / SEGMENT_RESTART_INTERVAL;
+    if (restart->voterOffset > header->timeOffset - header->voterOffset ||
+        restart->timeOffset > header->hashOffset - header->timeOffset) {
+        return -1;
+    }
+    cursor->row = row;
+    cursor->voter = cursor->seg + header->voterOffset + restart->voterOffset;
+    cursor->time = cursor->seg + header->timeOffset + restart->timeOffset;
+    cursor->timestamp = restart->timestamp;
+    cursor->voterID[0] = '\0';
+    return decodeVoter(cursor);
+}
+
+// Moves to the next row; the caller keeps the cursor below rowCount
+static int stepCursor(segmentCursor *cursor) {
+    uint64_t delta;
+    if ((cursor->row + 1) % SEGMENT_RESTART_INTERVAL == 0) {
+        if (loadRestart(cursor, cursor->row + 1) != 0) {
+            return -1;
+        }
+    } else {
+        if (readVarint(&cursor->time, cursor->timeEnd, &delta) != 0) {
+            return -1;
+        }
+        cursor->row++;
+        cursor->timestamp += (int64_t)delta;
+        if (decodeVoter(cursor) != 0) {
+            return -1;
+        }
+    }
+    return findRun(cursor);
+}
+
+static int seekCursor(segmentCursor *cursor, uint32_t row) {
+    if (row >= cursor->header->rowCount ||
+        loadRestart(cursor, row - row % SEGMENT_RESTART_INTERVAL) != 0) {
+        return -1;
+    }
+    // Binary search for the run, as the cursor may move backwards
+    uint32_t low = 0, high = cursor->header->runCount;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (cursor->runs[mid].end <= cursor->row) low = mid + 1; else high = mid;
+    }
+    cursor->run = low;
+    if (findRun(cursor) != 0) {
+        return -1;
+    }
+    while (cursor->row < row) {
+        if (stepCursor(cursor) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static const unsigned char *cursorPrevhash(const segmentCursor *cursor) {
+    return cursor->seg + cursor->header->hashOffset + (size_t)cursor->row * SHA256_DIGEST_LENGTH;
+}
+
+static void cursorRecord(const segmentCursor *cursor, chainRecord *record) {
+    const segmentRun *run = &cursor->runs[cursor->run];
+    record->seq = cursor->header->firstSeq + cursor->row;
+    record->timestamp = cursor->timestamp;
+    // Long IDs are truncated like chainindex.c does for the chain file
+    snprintf(record->voterID, sizeof(record->voterID), "%.*s",
+             (int)sizeof(record->voterID) - 1, cursor->voterID);
+    snprintf(record->candID, sizeof(record->candID), "%.*s",
+             (int)cursor->dictLengths[run->dict], (const char *)cursor->dictIDs[run->dict]);
+    memcpy(record->prevhash, cursorPrevhash(cursor), SHA256_DIGEST_LENGTH);
+}
+
+/*
+Decodes every sealed block into blocks[0..sealedBlockCount) with their IDs packed into
+strings, which must hold sealedStringBytes. Each block's next points at the following
+array element; the caller links the last one. Returns 0 on success and -1 on a read
+error or a corrupt segment.
+*/
+int decodeSegmentBlocks(segmentStore *store, block *blocks, char *strings) {
+    segmentCursor cursor;
+    uint64_t i = 0;
+    int status = 0;
+
+    if (store->count == 0) {
+        return 0;
+    }
+    FILE *file = fopen(store->archivePath, "rb");
+    if (!file) {
+        perror("Failed to open segment archive");
+        return -1;
+    }
+    for (unsigned long s = 0; s < store->count && status == 0; s++) {
+        unsigned char *seg = readSegment(store, file, &store->entries[s]);
+        if (seg == NULL || openCursor(&cursor, seg) != 0 || seekCursor(&cursor, 0) != 0) {
+            status = -1;
+        }
+        for (uint32_t row = 0; status == 0 && row < cursor.header->rowCount; row++) {
+            if (row > 0 && stepCursor(&cursor) != 0) {
+                status = -1;
+                break;
+            }
+            const segmentRun *run = &cursor.runs[cursor.run];
+            size_t voterLen = strlen(cursor.voterID) + 1;
+            size_t candLen = cursor.dictLengths[run->dict];
+            block *b = &blocks[i];
+
+            b->voterID = strings;
+            memcpy(strings, cursor.voterID, voterLen);
+            strings += voterLen;
+            b->candID = strings;
+            memcpy(strings, cursor.dictIDs[run->dict], candLen);
+            strings[candLen] = '\0';
+            strings += candLen + 1;
+            b->seq = cursor.header->firstSeq + row;
+            b->timestamp = cursor.timestamp;
+            memcpy(b->prevhash, cursorPrevhash(&cursor), SHA256_DIGEST_LENGTH);
+            b->next = &blocks[i + 1];
+            i++;
+        }
+        if (status != 0) {
+            LOG_ERROR("segment", "Corrupt segment %lu in %s", s, store->archivePath);
+        }
+        free(seg);
+    }
+    fclose(file);
+    return status;
+}
+
+// Index of the segment holding seq, or -1 if seq is not sealed
+static long findSegment(const segmentStore *store, uint64_t seq) {
+    unsigned long low = 0, high = store->count;
+    while (low < high) {
+        unsigned long mid = low + (high - low) / 2;
+        if (store->entries[mid].firstSeq + store->entries[mid].rowCount <= seq) low = mid + 1; else high = mid;
+    }
+    return low < store->count && store->entries[low].firstSeq <= seq ? (long)low : -1;
+}
+
+/*
+Reads sealed block number seq into record. Only the segment's header, dictionary, run
+table, one restart entry, at most 16 rows of the voter and time columns and one hash are
+read, each into its place in a buffer the size of the segment.
+Returns 0 if found and -1 if seq is not sealed or the segment cannot be read.
+*/
+int readSegmentBlock(segmentStore *store, uint64_t seq, chainRecord *record) {
+    segmentCursor cursor;
+    segmentHeader header;
+    long s = findSegment(store, seq);
+    int status = -1;
+
+    if (s < 0) {
+        return -1;
+    }
+    const segmentIndexEntry *entry = &store->entries[s];
+    FILE *file = fopen(store->archivePath, "rb");
+    if (!file) {
+        perror("Failed to open segment archive");
+        return -1;
+    }
+    unsigned char *seg = NULL;
+    uint32_t row = (uint32_t)(seq - entry->firstSeq);
+    if (readAt(file, entry->offset, &header, sizeof(header)) == 0 &&
+        memcmp(header.magic, SEGMENT_MAGIC, 4) == 0 && header.version == SEGMENT_VERSION &&
+        header.totalLength == entry->length && header.rowCount == entry->rowCount &&
+        header.hashOffset <= entry->length && header.timeOffset <= header.hashOffset &&
+        header.voterOffset <= header.timeOffset && header.dictOffset <= header.voterOffset &&
+        (uint64_t)header.rowCount * SHA256_DIGEST_LENGTH == entry->length - header.hashOffset &&
+        (seg = calloc(1, entry->length)) != NULL) {
+        uint32_t restart = row / SEGMENT_RESTART_INTERVAL;
+        segmentRestart *restarts = (segmentRestart *)(seg + header.restartOffset);
+        memcpy(seg, &header, sizeof(header));
+        if (readAt(file, entry->offset + header.dictOffset, seg + header.dictOffset,
+                   header.voterOffset - header.dictOffset) == 0 &&
+            restart < header.restartCount &&
+            restarts[restart].voterOffset <= header.timeOffset - header.voterOffset &&
+            restarts[restart].timeOffset <= header.hashOffset - header.timeOffset) {
+            // Enough of both columns for the rows from the restart point up to row
+            uint64_t voterStart = header.voterOffset + restarts[restart].voterOffset;
+            uint64_t voterLength = (uint64_t)SEGMENT_RESTART_INTERVAL * (2 + SEGMENT_ID_MAX);
+            uint64_t timeStart = header.timeOffset + restarts[restart].timeOffset;
+            uint64_t timeLength = (uint64_t)SEGMENT_RESTART_INTERVAL * 10;
+            if (voterLength > header.timeOffset - voterStart) voterLength = header.timeOffset - voterStart;
+            if (timeLength > header.hashOffset - timeStart) timeLength = header.hashOffset - timeStart;
+            uint64_t hashStart = header.hashOffset + (uint64_t)row * SHA256_DIGEST_LENGTH;
+            if (readAt(file, entry->offset + voterStart, seg + voterStart, voterLength) == 0 &&
+                readAt(file, entry->offset + timeStart, seg + timeStart, timeLength) == 0 &&
+                readAt(file, entry->offset + hashStart, seg + hashStart, SHA256_DIGEST_LENGTH) == 0 &&
+                openCursor(&cursor, seg) == 0 && seekCursor(&cursor, row) == 0) {
+                cursorRecord(&cursor, record);
+                status = 0;
+            }
+        }
+    }
+    if (status != 0) {
+        LOG_ERROR("segment", "Unable to read block %lu from %s", (unsigned long)seq, store->archivePath);
+    }
+    free(seg);
+    fclose(file);
+    return status;
+}
+
+static int segmentInWindow(const segmentIndexEntry *entry, int64_t from, int64_t to) {
+    return entry->lastTimestamp >= from && entry->firstTimestamp < to;
+}
+
+/*
+Calls visit for every sealed block with from <= timestamp < to, in chain order. Segments
+outside the window are skipped by their index entry, and decoding starts at the last
+restart point before from. *stopped is set if visit asked to stop.
+Returns the number of blocks visited, or -1 if a segment cannot be read.
+*/
+long scanSegmentTimeRange(segmentStore *store, int64_t from, int64_t to,
+                          chainRecordVisitor visit, void *context, int *stopped) {
+    segmentCursor cursor;
+    chainRecord record;
+    long visited = 0;
+
+    *stopped = 0;
+    if (store->count == 0) {
+        return 0;
+    }
+    FILE *file = fopen(store->archivePath, "rb");
+    if (!file) {
+        perror("Failed to open segment archive");
+        return -1;
+    }
+    for (unsigned long s = 0; s < store->count && !*stopped; s++) {
+        if (!segmentInWindow(&store->entries[s], from, to)) {
+            continue;
+        }
+        unsigned char *seg = readSegment(store, file, &store->entries[s]);
+        if (seg == NULL || openCursor(&cursor, seg) != 0) {
+            free(seg);
+            visited = -1;
+            break;
+        }
+        const segmentRestart *restarts = (const segmentRestart *)(seg + cursor.header->restartOffset);
+        uint32_t start = 0;
+        while (start + 1 < cursor.header->restartCount && restarts[start + 1].timestamp < from) start++;
+
+        int status = seekCursor(&cursor, start * SEGMENT_RESTART_INTERVAL);
+        while (status == 0 && cursor.timestamp < to) {
+            if (cursor.timestamp >= from) {
+                cursorRecord(&cursor, &record);
+                visited++;
+                if (visit(&record, context) != 0) {
+                    *stopped = 1;
+                    break;
+                }
+            }
+            if (cursor.row + 1 == cursor.header->rowCount) {
+                break;
+            }
+            status = stepCursor(&cursor);
+        }
+        free(seg);
+        if (status != 0) {
+            LOG_ERROR("segment", "Corrupt segment %lu in %s", s, store->archivePath);
+            visited = -1;
+            break;
+        }
+    }
+    fclose(file);
+    return visited;
+}
+
+/*
+Adds the sealed ballots cast in [from, to) to votes, indexed like candidates. Only the
+dictionary and run table of a segment are read when the whole segment is in the window,
+plus the time column when it is not; voter IDs and hashes are never read.
+Returns the number of sealed ballots in the window (including unknown candidates), or -1.
+*/
+long tallySegmentTimeRange(segmentStore *store, int64_t from, int64_t to,
+                           Candidate *candidates, int numCandidates, int *votes) {
+    const unsigned char *dictIDs[256];
+    unsigned char dictLengths[256];
+    int dictCandidate[256];
+    segmentHeader header;
+    long counted = 0;
+
+    if (store->count == 0) {
+        return 0;
+    }
+    FILE *file = fopen(store->archivePath, "rb");
+    if (!file) {
+        perror("Failed to open segment archive");
+        return -1;
+    }
+    for (unsigned long s = 0; s < store->count && counted >= 0; s++) {
+        const segmentIndexEntry *entry = &store->entries[s];
+        if (!segmentInWindow(entry, from, to)) {
+            continue;
+        }
+        int whole = entry->firstTimestamp >= from && entry->lastTimestamp < to;
+        unsigned char *tables = NULL, *times = NULL;
+        int ok = readAt(file, entry->offset, &header, sizeof(header)) == 0 &&
+                 memcmp(header.magic, SEGMENT_MAGIC, 4) == 0 && header.version == SEGMENT_VERSION &&
+                 header.rowCount == entry->rowCount && header.hashOffset <= entry->length &&
+                 header.dictOffset <= header.runOffset && header.runOffset <= header.restartOffset &&
+                 header.restartOffset - header.runOffset == header.runCount * sizeof(segmentRun) &&
+                 header.voterOffset <= header.timeOffset && header.timeOffset <= header.hashOffset &&
+                 (tables = malloc(header.restartOffset - header.dictOffset + 1)) != NULL &&
+                 readAt(file, entry->offset + header.dictOffset, tables, header.restartOffset - header.dictOffset) == 0 &&
+                 readDictionary(tables, tables + (header.runOffset - header.dictOffset), header.dictCount,
+                                dictIDs, dictLengths) == 0;
+        if (ok && !whole) {
+            size_t timeLength = header.hashOffset - header.timeOffset;
+            ok = (times = malloc(timeLength + 1)) != NULL &&
+                 readAt(file, entry->offset + header.timeOffset, times, timeLength) == 0;
+        }
+        if (ok) {
+            // Each dictionary entry is matched against the candidates once per segment
+            for (uint32_t d = 0; d < header.dictCount; d++) {
+                dictCandidate[d] = -1;
+                for (int c = 0; c < numCandidates; c++) {
+                    if (strlen(candidates[c].id) == dictLengths[d] &&
+                        memcmp(candidates[c].id, dictIDs[d], dictLengths[d]) == 0) {
+                        dictCandidate[d] = c;
+                        break;
+                    }
+                }
+            }
+            const segmentRun *runs = (const segmentRun *)(tables + (header.runOffset - header.dictOffset));
+            const unsigned char *p = times, *end = times ? times + (header.hashOffset - header.timeOffset) : NULL;
+            int64_t timestamp = entry->firstTimestamp;
+            uint32_t start = 0;
+            for (uint32_t r = 0; ok && r < header.runCount; r++) {
+                if (runs[r].dict >= header.dictCount || runs[r].end < start || runs[r].end > header.rowCount) {
+                    ok = 0;
+                    break;
+                }
+                uint32_t inWindow = runs[r].end - start;
+                if (!whole) {
+                    inWindow = 0;
+                    for (uint32_t row = start; row < runs[r].end; row++) {
+                        uint64_t delta;
+                        if (readVarint(&p, end, &delta) != 0) {
+                            ok = 0;
+                            break;
+                        }
+                        timestamp += (int64_t)delta;
+                        inWindow += timestamp >= from && timestamp < to;
+                    }
+                }
+                if (dictCandidate[runs[r].dict] >= 0) {
+                    votes[dictCandidate[runs[r].dict]] += inWindow;
+                }
+                counted += inWindow;
+                start = runs[r].end;
+            }
+            ok = ok && start == header.rowCount;
+        }
+        if (!ok) {
+            LOG_ERROR("segment", "Unable to read segment %lu of %s", s, store->archivePath);
+            counted = -1;
+        }
+        free(tables);
+        free(times);
+    }
+    fclose(file);
+    return counted;
+}
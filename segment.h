@@ -0,0 +1,102 @@
+#ifndef SEGMENT_H
+#define SEGMENT_H
+
+#include <stdint.h>
+#include "blockchain.h"
+#include "chainindex.h"
+
+#define SEGMENT_FILE_SUFFIX ".seg"
+#define SEGMENT_INDEX_SUFFIX ".sidx"
+#define SEGMENT_MAGIC "VSEG"
+#define SEGMENT_INDEX_MAGIC "VSIX"
+#define SEGMENT_VERSION 2
+#define SEGMENT_ROWS 65536           // default rows per sealed segment
+#define SEGMENT_RESTART_INTERVAL 16  // voter IDs and times are stored in full every N rows
+
+/*
+Cold storage for sealed chain ranges.
+
+sealChain moves complete ranges of blocks out of the chain file into <chain>.seg and
+rewrites the chain file with the remaining (hot) blocks only. Each range becomes one
+self-contained columnar segment:
+
+    segmentHeader
+    candidate dictionary   dictCount x (u8 length, bytes)
+    candidate runs         runCount x segmentRun, RLE of dictionary indices
+    restart table          restartCount x segmentRestart, one per 16 rows
+    voter column           rowCount x (u8 shared prefix, u8 suffix length, suffix bytes)
+    time column            rowCount x LEB128 seconds since the previous row
+    hash column            rowCount x 32-byte prevhash, stored raw
+
+Offsets in the header are relative to the start of the segment. A row's seq is firstSeq
+plus its row number. <chain>.sidx holds one segmentIndexEntry per segment in seq order,
+so a block is found by a binary search, one read of its segment and at most 16 prefix
+and time decodes; the entries' time bounds let time-window queries skip segments.
+
+Sealed blocks are still part of the chain: loadBlockchainFromFile and
+loadBlockchainParallel decode the segments ahead of the chain file, so verify, tally and
+the Merkle root cover them, and bc->sealed tells the writers to leave them out of the
+chain file. Segments hold a multiple of 2^LOADER_CHUNK_LEVEL rows, so the hot blocks
+start on a chunk boundary of the parallel loader.
+*/
+typedef struct segmentHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t firstSeq;
+    uint32_t rowCount;
+    uint32_t dictCount;
+    uint32_t runCount;
+    uint32_t restartCount;
+    uint32_t dictOffset;
+    uint32_t runOffset;
+    uint32_t restartOffset;
+    uint32_t voterOffset;
+    uint32_t timeOffset;
+    uint32_t hashOffset;
+    uint32_t totalLength;
+    uint32_t reserved;
+    unsigned char lastHash[SHA256_DIGEST_LENGTH];  // full hash of the segment's last block
+} segmentHeader;
+
+typedef struct segmentRun {
+    uint32_t end;   // one past the last row of the run
+    uint32_t dict;  // index into the candidate dictionary
+} segmentRun;
+
+typedef struct segmentRestart {
+    uint32_t voterOffset;  // into the voter column
+    uint32_t timeOffset;   // into the time column, just past this row's delta
+    int64_t timestamp;
+} segmentRestart;
+
+typedef struct segmentIndexEntry {
+    uint64_t firstSeq;
+    uint64_t offset;        // into <chain>.seg
+    int64_t firstTimestamp;
+    int64_t lastTimestamp;
+    uint32_t rowCount;
+    uint32_t length;
+    uint64_t stringBytes;   // voter and candidate IDs of every row, NULs included
+} segmentIndexEntry;
+
+typedef struct segmentStore {
+    char archivePath[300];
+    char indexPath[300];
+    segmentIndexEntry *entries;
+    unsigned long count;
+    unsigned long capacity;
+} segmentStore;
+
+int openSegmentStore(segmentStore *store, const char *chainPath);
+void closeSegmentStore(segmentStore *store);
+uint64_t sealedBlockCount(const segmentStore *store);
+uint64_t sealedStringBytes(const segmentStore *store);
+long sealChain(blockchain *bc, const char *chainPath, uint32_t rowsPerSegment);
+int decodeSegmentBlocks(segmentStore *store, block *blocks, char *strings);
+int readSegmentBlock(segmentStore *store, uint64_t seq, chainRecord *record);
+long scanSegmentTimeRange(segmentStore *store, int64_t from, int64_t to,
+                          chainRecordVisitor visit, void *context, int *stopped);
+long tallySegmentTimeRange(segmentStore *store, int64_t from, int64_t to,
+                           Candidate *candidates, int numCandidates, int *votes);
+
+#endif
@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "shard.h"
+#include "chainsnapshot.h"
+
+// Per-shard work item for the verification and tally threads
+typedef struct shardJob {
+    shardedChain *sc;
+    int shard;
+    Candidate *candidates;
+    int numCandidates;
+    int *votes;  // numCandidates counters
+    int result;
+    unsigned char root[SHA256_DIGEST_LENGTH];  // root of the tallied prefix
+} shardJob;
+
+static void shardFileName(int shard, char *buf, size_t size) {
+    snprintf(buf, size, SHARD_FILE_FORMAT, shard);
+}
+
+/*
+Reads the stored shard roots into sc->stored. A missing file, or one written for another
+shard layout, leaves every shard with length 0 and the empty root, so verification
+fails for any shard that has blocks.
+*/
+static void loadShardRoots(shardedChain *sc) {
+    blockchain empty;
+    shardRootFileHeader header;
+
+    resetBlockchain(&empty);
+    for (int i = 0; i < sc->numShards; i++) {
+        sc->stored[i].length = 0;
+        memcpy(sc->stored[i].root, empty.merkle_root, SHA256_DIGEST_LENGTH);
+    }
+
+    FILE *file = fopen(SHARD_ROOT_FILE, "rb");
+    if (!file) {
+        return;
+    }
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, SHARD_ROOT_MAGIC, sizeof(header.magic)) != 0) {
+        printf("Invalid shard root file %s\n", SHARD_ROOT_FILE);
+    } else if (header.numShards != (uint32_t)sc->numShards ||
+               header.precinctPrefixLen != sc->precinctPrefixLen) {
+        printf("%s was written for %u shards with precinct prefix %d, not %d and %d\n",
+               SHARD_ROOT_FILE, header.numShards, header.precinctPrefixLen,
+               sc->numShards, sc->precinctPrefixLen);
+    } else if (fread(sc->stored, sizeof(shardRootRecord), sc->numShards, file) != (size_t)sc->numShards) {
+        printf("Shard root file %s is truncated\n", SHARD_ROOT_FILE);
+        for (int i = 0; i < sc->numShards; i++) {
+            sc->stored[i].length = 0;
+            memcpy(sc->stored[i].root, empty.merkle_root, SHA256_DIGEST_LENGTH);
+        }
+    }
+    fclose(file);
+}
+
+// Replaces the root file atomically with the current sc->stored records
+static int writeShardRoots(shardedChain *sc) {
+    shardRootFileHeader header;
+    shardRootRecord records[MAX_SHARDS];
+    char tmpPath[64];
+
+    for (int i = 0; i < sc->numShards; i++) {
+        pthread_mutex_lock(&sc->locks[i]);
+        records[i] = sc->stored[i];
+        pthread_mutex_unlock(&sc->locks[i]);
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHARD_ROOT_MAGIC, sizeof(header.magic));
+    header.numShards = (uint32_t)sc->numShards;
+    header.precinctPrefixLen = sc->precinctPrefixLen;
+
+    pthread_mutex_lock(&sc->rootFileLock);
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", SHARD_ROOT_FILE);
+    FILE *file = fopen(tmpPath, "wb");
+    int ok = file != NULL &&
+             fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(records, sizeof(shardRootRecord), sc->numShards, file) == (size_t)sc->numShards;
+    if (file && fclose(file) != 0) ok = 0;
+    if (!ok || rename(tmpPath, SHARD_ROOT_FILE) != 0) {
+        perror("Failed to write shard roots");
+        remove(tmpPath);
+        ok = 0;
+    }
+    pthread_mutex_unlock(&sc->rootFileLock);
+    return ok ? 0 : -1;
+}
+
+// Records the shard's current length and root as the persisted ones; caller holds the shard lock
+static void storeShardRoot(shardedChain *sc, int shard) {
+    blockchain *bc = &sc->shards[shard];
+    merkleAccumulatorRoot(&bc->merkle_acc, bc->merkle_root);
+    sc->stored[shard].length = bc->length;
+    memcpy(sc->stored[shard].root, bc->merkle_root, SHA256_DIGEST_LENGTH);
+}
+
+/*
+Sets up numShards empty chains and loads any existing shard files and their stored roots.
+Returns 0 on success and -1 if the shard count is out of range.
+*/
+int initializeShardedChain(shardedChain *sc, int numShards, int precinctPrefixLen) {
+    if (numShards < 1 || numShards > MAX_SHARDS) {
+        printf("Shard count must be between 1 and %d\n", MAX_SHARDS);
+        return -1;
+    }
+
+    sc->numShards = numShards;
+    sc->precinctPrefixLen = precinctPrefixLen;
+    for (int i = 0; i < numShards; i++) {
+        char filename[64];
+        shardFileName(i, filename, sizeof(filename));
+        resetBlockchain(&sc->shards[i]);
+        loadBlockchainFromFile(&sc->shards[i], filename);
+        sc->persisted[i] = sc->shards[i].tail;
+        pthread_mutex_init(&sc->locks[i], NULL);
+    }
+    pthread_mutex_init(&sc->rootFileLock, NULL);
+    loadShardRoots(sc);
+    return 0;
+}
+
+void destroyShardedChain(shardedChain *sc) {
+    for (int i = 0; i < sc->numShards; i++) {
+        pthread_mutex_destroy(&sc->locks[i]);
+    }
+    pthread_mutex_destroy(&sc->rootFileLock);
+    sc->numShards = 0;
+}
+
+// FNV-1a over the precinct prefix (or the whole ID), reduced to a shard index
+int shardForVoter(shardedChain *sc, const char *voterID) {
+    unsigned int hash = 2166136261u;
+    size_t len = strlen(voterID);
+
+    if (sc->precinctPrefixLen > 0 && (size_t)sc->precinctPrefixLen < len) {
+        len = sc->precinctPrefixLen;
+    }
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)voterID[i];
+        hash *= 16777619u;
+    }
+    return (int)(hash % (unsigned int)sc->numShards);
+}
+
+// Appends the shard's blocks past persisted[shard] to its file; the caller holds the shard lock
+static int persistShardLocked(shardedChain *sc, int shard) {
+    blockchain *bc = &sc->shards[shard];
+    block *first = sc->persisted[shard] ? sc->persisted[shard]->next : bc->head;
+    char filename[64];
+
+    if (first == NULL) {
+        return 0;
+    }
+    shardFileName(shard, filename, sizeof(filename));
+    if (appendBlocksToFile(bc, first, filename) != 0) {
+        return -1;
+    }
+    sc->persisted[shard] = bc->tail;
+    storeShardRoot(sc, shard);
+    return 0;
+}
+
+/*
+Appends the ballot to its shard in memory only; persistShardedChain writes it out.
+Only the owning shard is locked, so callers on other threads can append to other shards
+at the same time. Returns the new block, or NULL if it could not be created.
+*/
+block *appendShardedBlock(shardedChain *sc, char *voterID, char *candID) {
+    int shard = shardForVoter(sc, voterID);
+    block *newBlock;
+
+    pthread_mutex_lock(&sc->locks[shard]);
+    newBlock = appendBlock(&sc->shards[shard], voterID, candID);
+    pthread_mutex_unlock(&sc->locks[shard]);
+    return newBlock;
+}
+
+/*
+Appends the ballot to its shard and appends that block to the shard file.
+Returns the shard index, or -1 if the block could not be created or written; a block
+that could not be written stays in memory and goes out with the next persist.
+*/
+int castShardedVote(shardedChain *sc, char *voterID, char *candID) {
+    int shard = shardForVoter(sc, voterID);
+    int status;
+
+    pthread_mutex_lock(&sc->locks[shard]);
+    if (appendBlock(&sc->shards[shard], voterID, candID) == NULL) {
+        pthread_mutex_unlock(&sc->locks[shard]);
+        return -1;
+    }
+    status = persistShardLocked(sc, shard);
+    pthread_mutex_unlock(&sc->locks[shard]);
+
+    if (status == 0) {
+        status = writeShardRoots(sc);
+    }
+    return status == 0 ? shard : -1;
+}
+
+/*
+Appends every block not yet on disk to its shard file, one shard at a time.
+Returns 0 on success and -1 if any shard could not be written.
+*/
+int persistShardedChain(shardedChain *sc) {
+    int status = 0;
+
+    for (int i = 0; i < sc->numShards; i++) {
+        pthread_mutex_lock(&sc->locks[i]);
+        if (persistShardLocked(sc, i) != 0) {
+            printf("Failed to write shard %d\n", i);
+            status = -1;
+        }
+        pthread_mutex_unlock(&sc->locks[i]);
+    }
+    if (writeShardRoots(sc) != 0) {
+        status = -1;
+    }
+    return status;
+}
+
+// Top-level root: a Merkle tree whose leaves are the shard roots in shard order
+void calculateShardedRoot(shardedChain *sc, unsigned char *out) {
+    merkleAccumulator acc;
+
+    merkleAccumulatorInit(&acc);
+    for (int i = 0; i < sc->numShards; i++) {
+        unsigned char shardRoot[SHA256_DIGEST_LENGTH];
+        pthread_mutex_lock(&sc->locks[i]);
+        memcpy(shardRoot, sc->shards[i].merkle_root, SHA256_DIGEST_LENGTH);
+        pthread_mutex_unlock(&sc->locks[i]);
+        merkleAccumulatorAdd(&acc, shardRoot);
+    }
+    merkleAccumulatorRoot(&acc, out);
+}
+
+static void *verifyShardThread(void *arg) {
+    shardJob *job = (shardJob *)arg;
+    blockchain *bc = &job->sc->shards[job->shard];
+
+    pthread_mutex_lock(&job->sc->locks[job->shard]);
+    shardRootRecord *stored = &job->sc->stored[job->shard];
+    job->result = verifyBlocks(bc, 0) != 0 && bc->length == stored->length;
+    if (job->result) {
+        unsigned char *root = calculateMerkleRoot(bc);
+        job->result = root != NULL && hashCompare(root, stored->root);
+        free(root);
+    }
+    pthread_mutex_unlock(&job->sc->locks[job->shard]);
+    return NULL;
+}
+
+// The shard lock is held only to capture the snapshot, so votes keep landing during the count
+static void *tallyShardThread(void *arg) {
+    shardJob *job = (shardJob *)arg;
+    chainSnapshot snapshot;
+
+    pthread_mutex_lock(&job->sc->locks[job->shard]);
+    captureChainSnapshot(&job->sc->shards[job->shard], &snapshot);
+    pthread_mutex_unlock(&job->sc->locks[job->shard]);
+    job->result = tallyChainSnapshot(&snapshot, job->candidates, job->numCandidates, job->votes, 1);
+    memcpy(job->root, snapshot.root, SHA256_DIGEST_LENGTH);
+    return NULL;
+}
+
+// Runs fn once per shard, each on its own thread, and waits for all of them.
+static void runShardJobs(shardedChain *sc, shardJob *jobs, void *(*fn)(void *)) {
+    pthread_t threads[MAX_SHARDS];
+    int started[MAX_SHARDS];
+
+    for (int i = 0; i < sc->numShards; i++) {
+        jobs[i].sc = sc;
+        jobs[i].shard = i;
+        started[i] = pthread_create(&threads[i], NULL, fn, &jobs[i]) == 0;
+        if (!started[i]) {
+            fn(&jobs[i]);  // fall back to running it inline
+        }
+    }
+    for (int i = 0; i < sc->numShards; i++) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+}
+
+/*
+Verifies every shard in parallel: the prevhash links, and the length and Merkle root
+recorded in SHARD_ROOT_FILE when the shard was last written.
+Returns 1 if all shards are intact, 0 otherwise.
+*/
+int verifyShardedChain(shardedChain *sc) {
+    shardJob jobs[MAX_SHARDS];
+    int check = 1;
+
+    printf("Starting sharded blockchain verification...\n");
+    runShardJobs(sc, jobs, verifyShardThread);
+
+    for (int i = 0; i < sc->numShards; i++) {
+        printf("Shard %d (%lu blocks): %s\n", i, sc->shards[i].length,
+               jobs[i].result ? "Verified" : "Alteration detected");
+        if (!jobs[i].result) check = 0;
+    }
+
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    calculateShardedRoot(sc, root);
+    printf("Top-level root: ");
+    hashPrinter(root, SHA256_DIGEST_LENGTH);
+    return check;
+}
+
+/*
+Tallies every shard in parallel and prints the combined counts.
+Returns 1 if every shard matched its Merkle root, 0 if any did not, and -1 if the
+counters could not be allocated.
+*/
+int countShardedVotes(shardedChain *sc, Candidate *candidates, int numCandidates) {
+    shardJob jobs[MAX_SHARDS];
+    int *candidate_votes = calloc(numCandidates > 0 ? numCandidates : 1, sizeof(int));
+    int *shardVotes = calloc((size_t)sc->numShards * (numCandidates > 0 ? numCandidates : 1), sizeof(int));
+
+    if (!candidate_votes || !shardVotes) {
+        printf("Memory allocation failed for the sharded tally\n");
+        free(candidate_votes);
+        free(shardVotes);
+        return -1;
+    }
+    for (int i = 0; i < sc->numShards; i++) {
+        jobs[i].candidates = candidates;
+        jobs[i].numCandidates = numCandidates;
+        jobs[i].votes = shardVotes + (size_t)i * numCandidates;
+    }
+    runShardJobs(sc, jobs, tallyShardThread);
+
+    // The top-level root is built from the captured shard roots, so it names exactly the
+    // ballots counted even if more arrived meanwhile
+    merkleAccumulator acc;
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    int intact = 1;
+    merkleAccumulatorInit(&acc);
+    for (int i = 0; i < sc->numShards; i++) {
+        if (jobs[i].result < 0) {
+            printf("Shard %d: tally failed.\n", i);
+            intact = -1;
+        } else if (jobs[i].result == 0) {
+            printf("Shard %d: integrity disrupted; Merkle root does not match.\n", i);
+            if (intact == 1) intact = 0;
+        }
+        for (int c = 0; c < numCandidates; c++) {
+            candidate_votes[c] += jobs[i].votes[c];
+        }
+        merkleAccumulatorAdd(&acc, jobs[i].root);
+    }
+    merkleAccumulatorRoot(&acc, root);
+    printf("Vote counts per candidate (top-level root ");
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) printf("%02x", root[i]);
+    printf("):\n");
+    for (int i = 0; i < numCandidates; i++) {
+        printf("Candidate %d (%s): %d votes\n", i + 1, candidates[i].id, candidate_votes[i]);
+    }
+    free(candidate_votes);
+    free(shardVotes);
+    return intact;
+}
+
+// Rewrites every shard file whole, e.g. after the chains were rebuilt in memory
+void saveShardedChain(shardedChain *sc) {
+    for (int i = 0; i < sc->numShards; i++) {
+        char filename[64];
+        shardFileName(i, filename, sizeof(filename));
+        pthread_mutex_lock(&sc->locks[i]);
+        saveBlockchainToFile(&sc->shards[i], filename);
+        sc->persisted[i] = sc->shards[i].tail;
+        storeShardRoot(sc, i);
+        pthread_mutex_unlock(&sc->locks[i]);
+    }
+    writeShardRoots(sc);
+}
@@ -0,0 +1,60 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include <pthread.h>
+#include "blockchain.h"
+
+#define MAX_SHARDS 64
+#define SHARD_FILE_FORMAT "blockchain_shard_%02d.bin"
+#define SHARD_ROOT_FILE "blockchain_shards.root"
+#define SHARD_ROOT_MAGIC "VSRT"
+
+/*
+Every persist also rewrites SHARD_ROOT_FILE: the shard layout, then the length and Merkle
+root of each shard as written. verifyShardedChain checks the shard files against it, so
+an edited or truncated shard file is caught even though the in-memory root is rebuilt
+from that file.
+*/
+typedef struct shardRootFileHeader {
+    char magic[4];
+    uint32_t numShards;
+    int32_t precinctPrefixLen;
+    uint32_t reserved;
+} shardRootFileHeader;
+
+typedef struct shardRootRecord {
+    uint64_t length;
+    unsigned char root[SHA256_DIGEST_LENGTH];
+} shardRootRecord;
+
+/*
+Sharded mode: ballots are routed to one of numShards independent chains.
+Every shard has its own tail, Merkle accumulator, file and lock, so votes landing on
+different shards append in parallel. The top-level root commits over all shard roots.
+The CLI enables it with --shards N; every command must then use the same N.
+
+Routing hashes the first precinctPrefixLen characters of the voter ID (the precinct),
+or the whole voter ID when precinctPrefixLen is 0.
+*/
+typedef struct shardedChain {
+    int numShards;
+    int precinctPrefixLen;
+    blockchain shards[MAX_SHARDS];
+    pthread_mutex_t locks[MAX_SHARDS];
+    block *persisted[MAX_SHARDS];  // last block on disk per shard; NULL if none
+    shardRootRecord stored[MAX_SHARDS];  // as in SHARD_ROOT_FILE; guarded by the shard lock
+    pthread_mutex_t rootFileLock;
+} shardedChain;
+
+int initializeShardedChain(shardedChain *sc, int numShards, int precinctPrefixLen);
+void destroyShardedChain(shardedChain *sc);
+int shardForVoter(shardedChain *sc, const char *voterID);
+block *appendShardedBlock(shardedChain *sc, char *voterID, char *candID);
+int castShardedVote(shardedChain *sc, char *voterID, char *candID);
+int persistShardedChain(shardedChain *sc);
+void calculateShardedRoot(shardedChain *sc, unsigned char *out);
+int verifyShardedChain(shardedChain *sc);
+int countShardedVotes(shardedChain *sc, Candidate *candidates, int numCandidates);
+void saveShardedChain(shardedChain *sc);
+
+#endif
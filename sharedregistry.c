@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "sharedregistry.h"
+#include "logging.h"
+
+/*
+Epoch-based reclamation. Each reading thread owns a cache-line-sized record holding
+the global epoch it entered a lookup under, or 0 while it is outside one. Records are
+registered on a thread's first lookup and never freed, like the metrics thread blocks.
+*/
+typedef struct registryReader {
+    uint64_t epoch;
+    struct registryReader *next;
+} __attribute__((aligned(64))) registryReader;
+
+static registryReader *readers;
+static pthread_mutex_t readersLock = PTHREAD_MUTEX_INITIALIZER;
+static __thread registryReader *localReader;
+static uint64_t globalEpoch = 1;
+
+static registryReader *currentReader(void) {
+    if (localReader == NULL) {
+        registryReader *reader = aligned_alloc(64, sizeof(registryReader));
+        if (reader == NULL) {
+            return NULL;
+        }
+        reader->epoch = 0;
+        pthread_mutex_lock(&readersLock);
+        reader->next = readers;
+        __atomic_store_n(&readers, reader, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&readersLock);
+        localReader = reader;
+    }
+    return localReader;
+}
+
+/*
+Returns once no reader can still hold a snapshot unpublished before the call.
+Readers that entered before the epoch bump may have loaded it; later ones cannot.
+*/
+static void waitForReaders(void) {
+    uint64_t target = __atomic_add_fetch(&globalEpoch, 1, __ATOMIC_SEQ_CST);
+    registryReader *reader = __atomic_load_n(&readers, __ATOMIC_SEQ_CST);
+
+    for (; reader != NULL; reader = reader->next) {
+        uint64_t epoch;
+        while ((epoch = __atomic_load_n(&reader->epoch, __ATOMIC_SEQ_CST)) != 0 && epoch < target) {
+            sched_yield();
+        }
+    }
+}
+
+static void freeSnapshot(registrySnapshot *snapshot) {
+    if (snapshot == NULL) {
+        return;
+    }
+    free(snapshot->keys);
+    free(snapshot->voted);
+    freeVoterFilter(&snapshot->filter);
+    free(snapshot);
+}
+
+// Flattens the tree with an in-order walk, so keys come out sorted
+static registrySnapshot *buildSnapshot(const AVLTree *tree) {
+    const voterPool *pool = &tree->pool;
+    unsigned long capacity = pool->used ? pool->used : 1;  // bounds the live nodes
+    registrySnapshot *snapshot = calloc(1, sizeof(registrySnapshot));
+
+    if (snapshot == NULL
+        || (snapshot->keys = malloc(capacity * sizeof(uint64_t))) == NULL
+        || (snapshot->voted = malloc(capacity)) == NULL) {
+        LOG_ERROR("registry", "Memory allocation failed");
+        freeSnapshot(snapshot);
+        return NULL;
+    }
+    // Without a filter every lookup just takes the binary search
+    initVoterFilter(&snapshot->filter);
+    resetVoterFilter(&snapshot->filter, capacity);
+
+    uint32_t stack[AVL_MAX_HEIGHT];
+    uint32_t node = tree->root;
+    int top = 0;
+    while (node != 0 || top > 0) {
+        while (node != 0 && top < AVL_MAX_HEIGHT) {
+            stack[top++] = node;
+            node = voterNodeAt(pool, node)->left;
+        }
+        VoterNode *current = voterNodeAt(pool, stack[--top]);
+        uint64_t key = voterIDKey(current->voterID);
+        snapshot->keys[snapshot->count] = key;
+        snapshot->voted[snapshot->count++] = current->voted != 0;
+        if (snapshot->filter.blocks != NULL) {
+            voterFilterAdd(&snapshot->filter, key);
+        }
+        node = current->right;
+    }
+    return snapshot;
+}
+
+// Position of key in the snapshot, or -1 if it is not registered there
+static long snapshotPosition(const registrySnapshot *snapshot, uint64_t key) {
+    if (snapshot->count == 0) {
+        return -1;
+    }
+    if (snapshot->filter.blocks != NULL && !voterFilterMayContain(&snapshot->filter, key)) {
+        return -1;
+    }
+    // Branch-free lower bound: the loop runs log2(count) times whatever the key
+    const uint64_t *base = snapshot->keys;
+    unsigned long length = snapshot->count;
+    while (length > 1) {
+        unsigned long half = length / 2;
+        base = base[half] <= key ? base + half : base;
+        length -= half;
+    }
+    return *base == key ? (long)(base - snapshot->keys) : -1;
+}
+
+static int snapshotLookup(const registrySnapshot *snapshot, uint64_t key) {
+    long position = snapshotPosition(snapshot, key);
+    if (position < 0) {
+        return -1;
+    }
+    return __atomic_load_n(&snapshot->voted[position], __ATOMIC_RELAXED);
+}
+
+/*
+Swaps in a snapshot of the writer's tree and frees the previous one once no reader
+can hold it. Call with writerLock held. Returns 0 on success, -1 if memory ran out
+(readers keep the previous version).
+*/
+static int publishSnapshot(sharedRegistry *registry) {
+    registrySnapshot *next = buildSnapshot(&registry->tree);
+    if (next == NULL) {
+        return -1;
+    }
+    registrySnapshot *previous = __atomic_exchange_n(&registry->current, next, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&registry->version, registry->version + 1, __ATOMIC_RELEASE);
+    waitForReaders();
+    freeSnapshot(previous);
+    return 0;
+}
+
+/*
+Takes over the voters in tree, which is left empty, and publishes the first snapshot.
+Returns 0 on success, -1 if memory ran out (tree is then handed back unchanged).
+*/
+int initSharedRegistry(sharedRegistry *registry, AVLTree *tree) {
+    registry->tree = *tree;
+    registry->version = 1;
+    registry->current = buildSnapshot(&registry->tree);
+    if (registry->current == NULL) {
+        return -1;
+    }
+    memset(tree, 0, sizeof(*tree));
+    pthread_mutex_init(&registry->writerLock, NULL);
+    return 0;
+}
+
+// No lookup may be running or start afterwards
+void destroySharedRegistry(sharedRegistry *registry) {
+    freeSnapshot(registry->current);
+    registry->current = NULL;
+    destroyAVLTree(&registry->tree);
+    pthread_mutex_destroy(&registry->writerLock);
+}
+
+/*
+Lock-free eligibility check, safe from any number of threads while the writer works.
+Returns -1 if the voter is not registered, 0 if registered and not yet voted, 1 if voted.
+*/
+int sharedRegistryLookup(sharedRegistry *registry, const char *voterID) {
+    uint64_t key = voterIDKey(voterID);
+    registryReader *reader = currentReader();
+    int status;
+
+    if (key == VOTER_KEY_INVALID) {
+        return -1;  // too long to be registered
+    }
+
+    if (reader == NULL) {
+        pthread_mutex_lock(&registry->writerLock);
+        status = snapshotLookup(registry->current, key);
+        pthread_mutex_unlock(&registry->writerLock);
+        return status;
+    }
+    // The epoch store must be visible before the snapshot is loaded, hence seq_cst
+    __atomic_store_n(&reader->epoch, __atomic_load_n(&globalEpoch, __ATOMIC_RELAXED), __ATOMIC_SEQ_CST);
+    status = snapshotLookup(__atomic_load_n(&registry->current, __ATOMIC_SEQ_CST), key);
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+    return status;
+}
+
+/*
+Marks a voter as voted, with the same results as updateVoting: 0 if newly marked,
+1 if the voter had already voted, -1 if not registered. Serialized with the writer.
+*/
+int sharedRegistryMarkVoted(sharedRegistry *registry, char *voterID) {
+    pthread_mutex_lock(&registry->writerLock);
+    int status = updateVoting(&registry->tree, voterID);
+    if (status == 0) {
+        // Absent only if the last publish ran out of memory; the next one carries the flag
+        long position = snapshotPosition(registry->current, voterIDKey(voterID));
+        if (position >= 0) {
+            __atomic_store_n(&registry->current->voted[position], 1, __ATOMIC_RELAXED);
+        }
+    }
+    pthread_mutex_unlock(&registry->writerLock);
+    return status;
+}
+
+// Undoes a successful sharedRegistryMarkVoted whose ballot could not be recorded
+void sharedRegistryUndoVoted(sharedRegistry *registry, char *voterID) {
+    pthread_mutex_lock(&registry->writerLock);
+    undoVoting(&registry->tree, voterID);
+    long position = snapshotPosition(registry->current, voterIDKey(voterID));
+    if (position >= 0) {
+        __atomic_store_n(&registry->current->voted[position], 0, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&registry->writerLock);
+}
+
+/*
+Applies a sorted change list (see applyRegistryChanges) and publishes the result as one
+new version. Returns the number of changes that altered the registry, or -1 on error;
+if only the publish failed the changes stay in the tree and go out with the next one.
+*/
+long sharedRegistryApplyChanges(sharedRegistry *registry, registryChange *changes, size_t count) {
+    pthread_mutex_lock(&registry->writerLock);
+    long applied = applyRegistryChanges(&registry->tree, changes, count);
+    if (applied > 0 && publishSnapshot(registry) != 0) {
+        LOG_ERROR("registry", "Registry changes applied but not published");
+        applied = -1;
+    }
+    pthread_mutex_unlock(&registry->writerLock);
+    return applied;
+}
+
+unsigned long sharedRegistryVersion(sharedRegistry *registry) {
+    return __atomic_load_n(&registry->version, __ATOMIC_ACQUIRE);
+}
+
+void sharedRegistrySave(sharedRegistry *registry, const char *filename) {
+    pthread_mutex_lock(&registry->writerLock);
+    saveTreeToBinaryFile(&registry->tree, filename);
+    pthread_mutex_unlock(&registry->writerLock);
+}
@@ -0,0 +1,52 @@
+#ifndef SHAREDREGISTRY_H
+#define SHAREDREGISTRY_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "avl.h"
+#include "voterfilter.h"
+
+/*
+Immutable version of the registry that readers search: every registered key in
+ascending order, the voted flag of each key (written atomically, by the writer only)
+and a membership filter in front of the binary search.
+*/
+typedef struct registrySnapshot {
+    uint64_t *keys;
+    unsigned char *voted;
+    unsigned long count;
+    voterFilter filter;
+} registrySnapshot;
+
+/*
+Read-mostly registry for concurrent eligibility checks.
+
+Readers never lock: sharedRegistryLookup searches the currently published snapshot.
+A single writer at a time (writerLock) owns the AVLTree, applies a batch of changes
+to it and publishes a new snapshot built from it, so a registration costs O(N) and
+should be batched. An old snapshot is freed once every reader that could still see it
+has left (epoch-based reclamation), so a lookup never touches freed memory.
+
+Votes are marked through the writer, against the tree, so two casts for one voter can
+never both succeed; the flag is then set in the published snapshot as well. A lookup
+that overlaps a publish may still see the previous version of a voter.
+
+voting-cli cast --threads N uses it to check ballots from N threads at once.
+*/
+typedef struct sharedRegistry {
+    AVLTree tree;
+    registrySnapshot *current;
+    unsigned long version;  // snapshots published so far
+    pthread_mutex_t writerLock;
+} sharedRegistry;
+
+int initSharedRegistry(sharedRegistry *registry, AVLTree *tree);
+void destroySharedRegistry(sharedRegistry *registry);
+int sharedRegistryLookup(sharedRegistry *registry, const char *voterID);
+int sharedRegistryMarkVoted(sharedRegistry *registry, char *voterID);
+void sharedRegistryUndoVoted(sharedRegistry *registry, char *voterID);
+long sharedRegistryApplyChanges(sharedRegistry *registry, registryChange *changes, size_t count);
+unsigned long sharedRegistryVersion(sharedRegistry *registry);
+void sharedRegistrySave(sharedRegistry *registry, const char *filename);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef CHAINTEST_H
+#define CHAINTEST_H
+
+#include "blockchain.h"
+
+/*
+Chain helpers shared by the chain tests. Test chains vote for TEST_CANDIDATES candidates
+in turn, so block i goes to candidate i % TEST_CANDIDATES.
+*/
+#define TEST_CANDIDATES 3
+
+static char *testCandidateIDs[TEST_CANDIDATES] = {"CAND-A", "CAND-B", "CAND-C"};
+
+static inline void testCandidates(Candidate *candidates) {
+    for (int i = 0; i < TEST_CANDIDATES; i++) {
+        candidates[i].id = testCandidateIDs[i];
+        snprintf(candidates[i].name, sizeof(candidates[i].name), "Candidate %d", i);
+    }
+}
+
+static inline void appendTestBlocks(blockchain *bc, unsigned long from, unsigned long count) {
+    char voterID[16];
+    for (unsigned long i = from; i < from + count; i++) {
+        snprintf(voterID, sizeof(voterID), "T%06lu", i);
+        appendBlock(bc, voterID, testCandidateIDs[i % TEST_CANDIDATES]);
+    }
+}
+
+// Recomputes every prevhash after blocks were edited, so the chain verifies again
+static inline void relinkChain(blockchain *bc) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256((unsigned char *)"", 0, hash);
+    for (block *b = bc->head; b != NULL; b = b->next) {
+        memcpy(b->prevhash, hash, SHA256_DIGEST_LENGTH);
+        hashBlock(b, hash);
+    }
+    rebuildChainState(bc);
+}
+
+static inline void freeTestChain(blockchain *bc) {
+    block *b = bc->head;
+    while (b != NULL) {
+        block *next = b->next;
+        free(b->voterID);
+        free(b->candID);
+        free(b);
+        b = next;
+    }
+    resetBlockchain(bc);
+}
+
+#endif
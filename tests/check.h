@@ -0,0 +1,22 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+/*
+Assertions for the ctest executables. A failed CHECK prints its location and the test
+keeps going, so one run reports every broken expectation; main returns CHECK_RESULT().
+*/
+static int checkFailures;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_RESULT() (checkFailures ? 1 : 0)
+
+#endif
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <string.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "chainindex.h"
+#include "check.h"
+#include "chaintest.h"
+
+#define INDEX_BLOCKS 5000
+#define INDEX_BASE_TIME 1700000000
+
+// Writes bc in the original headerless format: lengths, IDs and prevhash, no seq or time
+static void writeLegacyChain(blockchain *bc, const char *filename) {
+    FILE *file = fopen(filename, "wb");
+    for (block *b = bc->head; b != NULL; b = b->next) {
+        size_t voterLength = strlen(b->voterID) + 1;
+        size_t candLength = strlen(b->candID) + 1;
+        fwrite(&voterLength, sizeof(size_t), 1, file);
+        fwrite(&candLength, sizeof(size_t), 1, file);
+        fwrite(b->voterID, 1, voterLength, file);
+        fwrite(b->candID, 1, candLength, file);
+        fwrite(b->prevhash, 1, SHA256_DIGEST_LENGTH, file);
+    }
+    fclose(file);
+}
+
+static int fileVersion(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    int version = file ? readChainFileHeader(file) : -1;
+    if (file) fclose(file);
+    return version;
+}
+
+// A legacy file loads with timestamp 0, verifies, and is upgraded by the next append
+static void testLegacyUpgrade(void) {
+    blockchain bc, loaded;
+
+    resetBlockchain(&bc);
+    appendTestBlocks(&bc, 0, 50);
+    for (block *b = bc.head; b != NULL; b = b->next) {
+        b->timestamp = 0;  // legacy blocks carry no time and keep the original hash
+    }
+    relinkChain(&bc);
+    writeLegacyChain(&bc, "legacy.bin");
+    freeTestChain(&bc);
+    CHECK(fileVersion("legacy.bin") == CHAIN_FILE_LEGACY);
+
+    resetBlockchain(&loaded);
+    loadBlockchainFromFile(&loaded, "legacy.bin");
+    CHECK(loaded.length == 50);
+    CHECK(verifyBlocks(&loaded, 0) == 1);
+    CHECK(loaded.tail != NULL && loaded.tail->seq == 49 && loaded.tail->timestamp == 0);
+
+    block *last = loaded.tail;
+    appendTestBlocks(&loaded, 50, 10);
+    CHECK(appendBlocksToFile(&loaded, last->next, "legacy.bin") == 0);
+    CHECK(fileVersion("legacy.bin") == CHAIN_FILE_VERSION);
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    merkleAccumulatorRoot(&loaded.merkle_acc, root);
+    freeTestChain(&loaded);
+
+    loadBlockchainFromFile(&loaded, "legacy.bin");
+    CHECK(loaded.length == 60);
+    CHECK(verifyBlocks(&loaded, 0) == 1);
+    CHECK(hashCompare(loaded.merkle_root, root));
+    CHECK(loaded.head->timestamp == 0 && loaded.tail->timestamp > 0 && loaded.tail->seq == 59);
+
+    // seq and timestamp are covered by the hash of upgraded blocks
+    block *b = loaded.head;
+    for (int i = 0; i < 55; i++) b = b->next;
+    b->timestamp += 86400;
+    CHECK(verifyBlocks(&loaded, 0) == 0);
+    freeTestChain(&loaded);
+}
+
+static void testIndex(void) {
+    blockchain bc;
+    chainIndex index;
+    chainRecord record;
+    Candidate candidates[TEST_CANDIDATES];
+    int votes[TEST_CANDIDATES] = {0};
+
+    remove("indexed.bin");
+    remove("indexed.bin" CHAIN_INDEX_SUFFIX);
+    resetBlockchain(&bc);
+    appendTestBlocks(&bc, 0, INDEX_BLOCKS);
+    unsigned long i = 0;
+    for (block *b = bc.head; b != NULL; b = b->next, i++) {
+        b->timestamp = INDEX_BASE_TIME + i / 100;  // 100 ballots per second
+    }
+    relinkChain(&bc);
+    saveBlockchainToFile(&bc, "indexed.bin");
+
+    CHECK(openChainIndex(&index, "indexed.bin") == 0);
+    CHECK(index.blocks == INDEX_BLOCKS);
+    CHECK(readChainBlock(&index, 0, &record) == 0 && strcmp(record.voterID, "T000000") == 0);
+    CHECK(readChainBlock(&index, 1234, &record) == 0 && strcmp(record.voterID, "T001234") == 0 &&
+          record.timestamp == INDEX_BASE_TIME + 12 && strcmp(record.candID, testCandidateIDs[1234 % 3]) == 0);
+    CHECK(readChainBlock(&index, INDEX_BLOCKS, &record) == -1);
+
+    // [base + 10, base + 20) holds blocks 1000..1999
+    testCandidates(candidates);
+    CHECK(tallyChainTimeRange(&index, INDEX_BASE_TIME + 10, INDEX_BASE_TIME + 20,
+                              candidates, TEST_CANDIDATES, votes) == 1000);
+    CHECK(votes[0] == 333 && votes[1] == 334 && votes[2] == 333);
+    CHECK(tallyChainTimeRange(&index, 0, INDEX_BASE_TIME, candidates, TEST_CANDIDATES, votes) == 0);
+    closeChainIndex(&index);
+
+    // Reopening after an append scans only the new records
+    block *last = bc.tail;
+    appendTestBlocks(&bc, INDEX_BLOCKS, 10);
+    CHECK(appendBlocksToFile(&bc, last->next, "indexed.bin") == 0);
+    CHECK(openChainIndex(&index, "indexed.bin") == 0);
+    CHECK(index.blocks == INDEX_BLOCKS + 10);
+    CHECK(readChainBlock(&index, INDEX_BLOCKS + 5, &record) == 0 && strcmp(record.voterID, "T005005") == 0);
+    closeChainIndex(&index);
+    freeTestChain(&bc);
+}
+
+int main(void) {
+    testLegacyUpgrade();
+    testIndex();
+    return CHECK_RESULT();
+}
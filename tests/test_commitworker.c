@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "commitworker.h"
+#include "prefixindex.h"
+#include "check.h"
+#include "chaintest.h"
+
+static int isVoted(AVLTree *tree, const char *voterID) {
+    char id[VOTER_KEY_SIZE + 1];
+    snprintf(id, sizeof(id), "%s", voterID);
+    VoterNode *voter = findVoter(tree, id);
+    return voter != NULL && voter->voted;
+}
+
+// Ballots the UI submits: only a registered voter and an exact candidate ID reach the chain
+static void testSubmitBallot(void) {
+    Candidate items[TEST_CANDIDATES];
+    CandidateTable candidates = {.items = items, .count = TEST_CANDIDATES, .capacity = TEST_CANDIDATES};
+    prefixIndex candidateIndex;
+    AVLTree tree;
+    blockchain bc;
+    commitWorker worker;
+
+    remove("blockchain_data.bin");
+    remove("voter_data.bin");
+    testCandidates(items);
+    CHECK(buildCandidatePrefixIndex(&candidateIndex, &candidates) == 0);
+    initializeTree(&tree);
+    CHECK(registerVoter(&tree, "V1") == 1);
+    CHECK(registerVoter(&tree, "V2") == 1);
+    resetBlockchain(&bc);
+    CHECK(startCommitWorker(&worker, &bc, &tree) == 0);
+
+    CHECK(submitBallot(&worker, &candidateIndex, "V1", "NOPE") == SUBMIT_UNKNOWN_CANDIDATE);
+    CHECK(submitBallot(&worker, &candidateIndex, "V1", "CAND") == SUBMIT_UNKNOWN_CANDIDATE);  // a prefix only
+    CHECK(submitBallot(&worker, &candidateIndex, "V3", "CAND-A") == SUBMIT_NOT_REGISTERED);
+    CHECK(submitBallot(&worker, &candidateIndex, "V2", "CAND-A") == SUBMIT_QUEUED);
+    stopCommitWorker(&worker);
+
+    CHECK(!isVoted(&tree, "V1"));
+    CHECK(isVoted(&tree, "V2"));
+    CHECK(bc.length == 1);
+    CHECK(bc.tail != NULL && strcmp(bc.tail->candID, "CAND-A") == 0);
+
+    // The rejected voter can still vote
+    CHECK(startCommitWorker(&worker, &bc, &tree) == 0);
+    CHECK(submitBallot(&worker, &candidateIndex, "V2", "CAND-B") == SUBMIT_ALREADY_VOTED);
+    CHECK(submitBallot(&worker, &candidateIndex, "V1", "CAND-B") == SUBMIT_QUEUED);
+    stopCommitWorker(&worker);
+    CHECK(isVoted(&tree, "V1"));
+    CHECK(bc.length == 2);
+
+    // Completion events of both workers carry a malloc'd result
+    SDL_Event e;
+    while (SDL_PollEvent(&e)) {
+        if (e.type >= SDL_USEREVENT) {
+            free(e.user.data1);
+        }
+    }
+    freeTestChain(&bc);
+    destroyAVLTree(&tree);
+    freePrefixIndex(&candidateIndex);
+}
+
+int main(void) {
+    if (SDL_Init(SDL_INIT_EVENTS) != 0) {
+        fprintf(stderr, "SDL_Init failed: %s\n", SDL_GetError());
+        return 1;
+    }
+    testSubmitBallot();
+    SDL_Quit();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <string.h>
+#include "avl.h"
+#include "voterfilter.h"
+#include "check.h"
+
+#define TEST_KEYS 100000
+
+static void testNoFalseNegatives(void) {
+    voterFilter filter;
+    unsigned long falsePositives = 0;
+
+    initVoterFilter(&filter);
+    CHECK(resetVoterFilter(&filter, TEST_KEYS) == 0);
+    for (uint64_t k = 0; k < TEST_KEYS; k++) {
+        voterFilterAdd(&filter, k * 2654435761ULL);
+    }
+    for (uint64_t k = 0; k < TEST_KEYS; k++) {
+        CHECK(voterFilterMayContain(&filter, k * 2654435761ULL));
+    }
+    for (uint64_t k = 0; k < TEST_KEYS; k++) {
+        falsePositives += voterFilterMayContain(&filter, k * 2654435761ULL + 1);
+    }
+    // About 0.4% at 12 bits per key; 2% leaves room for hash clustering
+    CHECK(falsePositives < TEST_KEYS / 50);
+
+    CHECK(resetVoterFilter(&filter, TEST_KEYS) == 0);
+    CHECK(!voterFilterMayContain(&filter, 2654435761ULL));
+    freeVoterFilter(&filter);
+}
+
+// The registry filter grows with the tree and keeps answering for every voter
+static void testRegistryFilter(void) {
+    AVLTree tree = {0};
+    char id[VOTER_KEY_SIZE];
+    unsigned long rejected = 0;
+
+    for (int i = 0; i < 20000; i++) {
+        snprintf(id, sizeof(id), "R%05d", i);
+        registerVoter(&tree, id);
+    }
+    CHECK(tree.filter.blocks != NULL);
+    for (int i = 0; i < 20000; i++) {
+        snprintf(id, sizeof(id), "R%05d", i);
+        CHECK(voterMayBeRegistered(&tree, id));
+    }
+    for (int i = 0; i < 20000; i++) {
+        snprintf(id, sizeof(id), "X%05d", i);
+        rejected += !voterMayBeRegistered(&tree, id);
+        CHECK(updateVoting(&tree, id) == -1);
+    }
+    CHECK(rejected > 19000);
+    CHECK(!voterMayBeRegistered(&tree, "TOOLONGID"));
+    destroyAVLTree(&tree);
+}
+
+int main(void) {
+    testNoFalseNegatives();
+    testRegistryFilter();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "avl.h"
+#include "check.h"
+
+#define TEST_VOTERS 20000
+
+static void voterName(char *out, int i) {
+    snprintf(out, VOTER_KEY_SIZE, "V%05d", i);
+}
+
+/*
+Walks the subtree checking the AVL invariants: keys strictly increasing in order, stored
+heights correct and balance within one. Returns the subtree height; counts nodes.
+*/
+static int checkSubtree(const AVLTree *tree, uint32_t node, uint64_t *lastKey, int *first,
+                        unsigned long *nodes, unsigned long *voted) {
+    if (node == 0) {
+        return 0;
+    }
+    const VoterNode *current = voterNodeAt(&tree->pool, node);
+    int left = checkSubtree(tree, current->left, lastKey, first, nodes, voted);
+    uint64_t key = voterIDKey(current->voterID);
+    CHECK(*first || key > *lastKey);
+    *first = 0;
+    *lastKey = key;
+    (*nodes)++;
+    *voted += current->voted != 0;
+    int right = checkSubtree(tree, current->right, lastKey, first, nodes, voted);
+
+    int height = 1 + (left > right ? left : right);
+    CHECK(current->height == height);
+    CHECK(left - right >= -1 && left - right <= 1);
+    return height;
+}
+
+static void checkTree(const AVLTree *tree) {
+    uint64_t lastKey = 0;
+    int first = 1;
+    unsigned long nodes = 0, voted = 0;
+    checkSubtree(tree, tree->root, &lastKey, &first, &nodes, &voted);
+    CHECK(nodes == tree->stats.registered);
+    CHECK(voted == tree->stats.voted);
+}
+
+static void testInsertFindDelete(void) {
+    AVLTree tree = {0};
+    char id[VOTER_KEY_SIZE];
+
+    for (int i = 0; i < TEST_VOTERS; i++) {
+        voterName(id, (i * 7919) % TEST_VOTERS);  // scrambled insertion order
+        CHECK(registerVoter(&tree, id) == 1);
+    }
+    voterName(id, 42);
+    CHECK(registerVoter(&tree, id) == 0);
+    CHECK(tree.stats.registered == TEST_VOTERS);
+    checkTree(&tree);
+
+    CHECK(updateVoting(&tree, id) == 0);
+    CHECK(updateVoting(&tree, id) == 1);
+    CHECK(updateVoting(&tree, "NOBODY") == -1);
+    CHECK(findVoter(&tree, id) != NULL && findVoter(&tree, id)->voted == 1);
+
+    // Deleting every other voter exercises leaf, one-child and two-child removal
+    for (int i = 0; i < TEST_VOTERS; i += 2) {
+        voterName(id, i);
+        CHECK(unregisterVoter(&tree, id) == 1);
+        CHECK(unregisterVoter(&tree, id) == 0);
+        CHECK(findVoter(&tree, id) == NULL);
+    }
+    CHECK(tree.stats.registered == TEST_VOTERS / 2);
+    CHECK(tree.stats.voted == 0);  // V00042 was deleted with its vote
+    checkTree(&tree);
+
+    voterName(id, 1);
+    CHECK(findVoter(&tree, id) != NULL);
+    destroyAVLTree(&tree);
+    CHECK(tree.root == 0 && findVoter(&tree, id) == NULL);
+}
+
+// Deleted nodes go back to the pool and are handed out again before it grows
+static void testPoolReuse(void) {
+    AVLTree tree = {0};
+    char id[VOTER_KEY_SIZE];
+
+    for (int i = 0; i < 1000; i++) {
+        voterName(id, i);
+        registerVoter(&tree, id);
+    }
+    uint32_t used = tree.pool.used;
+    VoterNode *kept = findVoter(&tree, "V00999");
+    for (int i = 0; i < 500; i++) {
+        voterName(id, i);
+        unregisterVoter(&tree, id);
+    }
+    for (int i = 0; i < 500; i++) {
+        voterName(id, 5000 + i);
+        CHECK(registerVoter(&tree, id) == 1);
+    }
+    CHECK(tree.pool.used == used);
+    CHECK(findVoter(&tree, "V00999") == kept);  // surviving nodes never move
+    checkTree(&tree);
+    destroyAVLTree(&tree);
+}
+
+// IDs that fill the key are rejected rather than truncated onto another voter
+static void testLongIDs(void) {
+    AVLTree tree = {0};
+
+    CHECK(registerVoter(&tree, "ABCDEFG") == 1);
+    CHECK(registerVoter(&tree, "ABCDEFGH") == -1);
+    CHECK(registerVoter(&tree, "ABCDEFGHI") == -1);
+    CHECK(voterIDKey("ABCDEFGH") == VOTER_KEY_INVALID);
+    CHECK(findVoter(&tree, "ABCDEFGX") == NULL);
+    CHECK(updateVoting(&tree, "ABCDEFGX") == -1);
+    CHECK(rekeyVoter(&tree, "ABCDEFG", "ABCDEFGH") == -1);
+    CHECK(tree.stats.registered == 1);
+    destroyAVLTree(&tree);
+}
+
+static void testRekey(void) {
+    AVLTree tree = {0};
+
+    registerVoter(&tree, "A1");
+    registerVoter(&tree, "B2");
+    updateVoting(&tree, "A1");
+    CHECK(rekeyVoter(&tree, "A1", "B2") == 1);
+    CHECK(rekeyVoter(&tree, "ZZ", "C3") == -1);
+    CHECK(rekeyVoter(&tree, "A1", "C3") == 0);
+    CHECK(findVoter(&tree, "A1") == NULL);
+    CHECK(findVoter(&tree, "C3") != NULL && findVoter(&tree, "C3")->voted == 1);
+    CHECK(tree.stats.registered == 2 && tree.stats.voted == 1);
+    checkTree(&tree);
+    destroyAVLTree(&tree);
+}
+
+static registryChange change(const char *id, int op, int voted) {
+    registryChange c;
+    memset(&c, 0, sizeof(c));
+    snprintf(c.voterID, sizeof(c.voterID), "%s", id);
+    c.op = op;
+    c.voted = voted;
+    return c;
+}
+
+// Runs one list of mixed changes with count small or large relative to the registry
+static void testChanges(int registered, int changed) {
+    AVLTree tree = {0};
+    registryChange *changes = calloc(changed + 1, sizeof(registryChange));
+    char id[VOTER_KEY_SIZE];
+    long expected = 0;
+
+    for (int i = 0; i < registered; i++) {
+        voterName(id, 2 * i);  // even numbers only
+        registerVoter(&tree, id);
+    }
+    for (int i = 0; i < changed; i++) {
+        int present = i % 2 == 0 && i / 2 < registered;
+        voterName(id, i);
+        if (i % 3 == 0) {
+            changes[i] = change(id, REGISTRY_ADD, 0);
+            expected += !present;
+        } else if (i % 3 == 1) {
+            changes[i] = change(id, REGISTRY_REMOVE, 0);
+            expected += present;
+        } else {
+            changes[i] = change(id, REGISTRY_SET_VOTED, 1);
+            expected += present;
+        }
+    }
+    sortRegistryChanges(changes, changed);
+    CHECK(applyRegistryChanges(&tree, changes, changed) == expected);
+    checkTree(&tree);
+    CHECK(findVoter(&tree, "V00003") != NULL);  // added
+    CHECK(findVoter(&tree, "V00004") == NULL);  // removed
+    CHECK(findVoter(&tree, "V00002") != NULL && findVoter(&tree, "V00002")->voted == 1);
+
+    // A repeated ID rejects the whole list and leaves the tree alone
+    unsigned long before = tree.stats.registered;
+    changes[0] = change("V00001", REGISTRY_ADD, 0);
+    changes[1] = change("V00001", REGISTRY_REMOVE, 0);
+    CHECK(applyRegistryChanges(&tree, changes, 2) == -1);
+    CHECK(tree.stats.registered == before);
+    free(changes);
+    destroyAVLTree(&tree);
+}
+
+static void testSaveLoad(void) {
+    AVLTree tree = {0}, loaded = {0};
+    char id[VOTER_KEY_SIZE];
+
+    for (int i = 0; i < 3000; i++) {
+        voterName(id, i);
+        registerVoter(&tree, id);
+        if (i % 5 == 0) updateVoting(&tree, id);
+    }
+    saveTreeToBinaryFile(&tree, "registry_test.bin");
+    loadTreeFromBinaryFile(&loaded, "registry_test.bin");
+    CHECK(loaded.stats.registered == 3000 && loaded.stats.voted == 600);
+    checkTree(&loaded);
+    CHECK(findVoter(&loaded, "V00010") != NULL && findVoter(&loaded, "V00010")->voted == 1);
+    CHECK(findVoter(&loaded, "V00011") != NULL && findVoter(&loaded, "V00011")->voted == 0);
+    destroyAVLTree(&tree);
+    destroyAVLTree(&loaded);
+}
+
+// An old file with an unterminated 8-character ID: that record is skipped, the rest load
+static void testLoadLegacyLongID(void) {
+    AVLTree tree = {0}, loaded = {0};
+    char id[VOTER_KEY_SIZE];
+
+    for (int i = 0; i < 3000; i++) {
+        voterName(id, i);
+        registerVoter(&tree, id);
+        if (i % 5 == 0) updateVoting(&tree, id);
+    }
+    saveTreeToBinaryFile(&tree, "registry_test.bin");
+
+    // The root is the first record and heads both subtrees; its ID starts the record
+    VoterNode *root = voterNodeAt(&tree.pool, tree.root);
+    char rootID[VOTER_KEY_SIZE];
+    memcpy(rootID, root->voterID, VOTER_KEY_SIZE);
+    unsigned long voted = tree.stats.voted - (root->voted != 0);
+    FILE *file = fopen("registry_test.bin", "r+b");
+    CHECK(file != NULL && fwrite("V0000000", 1, VOTER_KEY_SIZE, file) == VOTER_KEY_SIZE);
+    fclose(file);
+
+    loadTreeFromBinaryFile(&loaded, "registry_test.bin");
+    CHECK(loaded.stats.registered == 2999 && loaded.stats.voted == voted);
+    checkTree(&loaded);
+    CHECK(findVoter(&loaded, rootID) == NULL);
+    for (int i = 0; i < 3000; i++) {
+        voterName(id, i);
+        CHECK(strcmp(id, rootID) == 0 || findVoter(&loaded, id) != NULL);
+    }
+    destroyAVLTree(&tree);
+    destroyAVLTree(&loaded);
+}
+
+int main(void) {
+    testInsertFindDelete();
+    testPoolReuse();
+    testLongIDs();
+    testRekey();
+    testChanges(10000, 60);     // key by key
+    testChanges(1000, 3000);    // merged with the in-order walk
+    testSaveLoad();
+    testLoadLegacyLongID();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,252 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "blockchain.h"
+#include "avl.h"
+#include "chainindex.h"
+#include "loader.h"
+#include "segment.h"
+#include "check.h"
+#include "chaintest.h"
+
+#define SEAL_ROWS 4096
+#define SEAL_BLOCKS (3 * SEAL_ROWS + 100)
+#define SEAL_BASE_TIME 1700000000
+
+static long fileSize(const char *filename) {
+    struct stat st;
+    return stat(filename, &st) == 0 ? (long)st.st_size : 0;
+}
+
+static void copyFile(const char *from, const char *to) {
+    char buffer[65536];
+    size_t n;
+    FILE *in = fopen(from, "rb");
+    FILE *out = fopen(to, "wb");
+    while (in && out && (n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        fwrite(buffer, 1, n, out);
+    }
+    if (in) fclose(in);
+    if (out) fclose(out);
+}
+
+static void removeChain(const char *filename) {
+    char path[300];
+    remove(filename);
+    snprintf(path, sizeof(path), "%s%s", filename, SEGMENT_FILE_SUFFIX);
+    remove(path);
+    snprintf(path, sizeof(path), "%s%s", filename, SEGMENT_INDEX_SUFFIX);
+    remove(path);
+    snprintf(path, sizeof(path), "%s%s", filename, CHAIN_INDEX_SUFFIX);
+    remove(path);
+}
+
+// Saves SEAL_BLOCKS blocks cast 100 per second from SEAL_BASE_TIME and returns their root
+static void saveTestChain(const char *filename, unsigned char *root) {
+    blockchain bc;
+
+    removeChain(filename);
+    resetBlockchain(&bc);
+    appendTestBlocks(&bc, 0, SEAL_BLOCKS);
+    unsigned long i = 0;
+    for (block *b = bc.head; b != NULL; b = b->next, i++) {
+        b->timestamp = SEAL_BASE_TIME + i / 100;
+    }
+    relinkChain(&bc);
+    saveBlockchainToFile(&bc, filename);
+    memcpy(root, bc.merkle_root, SHA256_DIGEST_LENGTH);
+    freeTestChain(&bc);
+}
+
+// Both loaders return the same blocks, root and sealed count
+static int sameChain(blockchain *a, blockchain *b) {
+    if (a->length != b->length || a->sealed != b->sealed || !hashCompare(a->merkle_root, b->merkle_root)) {
+        return 0;
+    }
+    for (block *x = a->head, *y = b->head; x != NULL; x = x->next, y = y->next) {
+        if (y == NULL || x->seq != y->seq || x->timestamp != y->timestamp ||
+            strcmp(x->voterID, y->voterID) != 0 || strcmp(x->candID, y->candID) != 0 ||
+            memcmp(x->prevhash, y->prevhash, SHA256_DIGEST_LENGTH) != 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void testSealAndLoad(void) {
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    blockchain bc, loaded;
+    int verified = 0;
+
+    saveTestChain("sealed.bin", root);
+    long original = fileSize("sealed.bin");
+
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "sealed.bin");
+    CHECK(sealChain(&bc, "sealed.bin", 1000) == -1);  // not a multiple of the loader chunk
+    CHECK(sealChain(&bc, "sealed.bin", SEAL_ROWS) == 3 * SEAL_ROWS);
+    CHECK(bc.sealed == 3 * SEAL_ROWS);
+    long stored = fileSize("sealed.bin") + fileSize("sealed.bin" SEGMENT_FILE_SUFFIX) +
+                  fileSize("sealed.bin" SEGMENT_INDEX_SUFFIX);
+    CHECK(stored < original);
+    freeTestChain(&bc);
+
+    // The chain loads whole from the segments and the remaining chain file
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "sealed.bin");
+    CHECK(bc.length == SEAL_BLOCKS && bc.sealed == 3 * SEAL_ROWS);
+    CHECK(hashCompare(bc.merkle_root, root));
+    CHECK(verifyBlocks(&bc, 0) == 1);
+    CHECK(strcmp(bc.tail->voterID, "T012387") == 0 && bc.tail->seq == SEAL_BLOCKS - 1);
+
+    resetBlockchain(&loaded);
+    CHECK(loadBlockchainParallel(&loaded, "sealed.bin", 2, &verified) == 0);
+    CHECK(verified == 1);
+    CHECK(sameChain(&bc, &loaded));
+    freeLoadedBlockchain(&loaded);
+
+    // Writers leave the sealed blocks out of the chain file
+    block *last = bc.tail;
+    appendTestBlocks(&bc, SEAL_BLOCKS, 10);
+    CHECK(appendBlocksToFile(&bc, last->next, "sealed.bin") == 0);
+    saveBlockchainToFile(&bc, "sealed.bin");
+    merkleAccumulatorRoot(&bc.merkle_acc, root);
+    CHECK(sealChain(&bc, "sealed.bin", SEAL_ROWS) == 0);  // no complete range left
+    freeTestChain(&bc);
+
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "sealed.bin");
+    CHECK(bc.length == SEAL_BLOCKS + 10);
+    CHECK(hashCompare(bc.merkle_root, root));
+    CHECK(verifyBlocks(&bc, 0) == 1);
+    resetBlockchain(&loaded);
+    CHECK(loadBlockchainParallel(&loaded, "sealed.bin", 2, &verified) == 0);
+    CHECK(verified == 1);
+    CHECK(sameChain(&bc, &loaded));
+    freeLoadedBlockchain(&loaded);
+    freeTestChain(&bc);
+}
+
+static int collectSeq(const chainRecord *record, void *context) {
+    uint64_t *seqs = context;
+    seqs[seqs[0]++ + 1] = record->seq;
+    return seqs[0] == 5;
+}
+
+// Sealed blocks are found through the chain index like any other block
+static void testSealedIndex(void) {
+    chainIndex index;
+    chainRecord record;
+    Candidate candidates[TEST_CANDIDATES];
+    int votes[TEST_CANDIDATES] = {0};
+    uint64_t seqs[6] = {0};
+
+    CHECK(openChainIndex(&index, "sealed.bin") == 0);
+    CHECK(readChainBlock(&index, 0, &record) == 0 && strcmp(record.voterID, "T000000") == 0);
+    CHECK(readChainBlock(&index, 5000, &record) == 0 && strcmp(record.voterID, "T005000") == 0 &&
+          record.timestamp == SEAL_BASE_TIME + 50 && strcmp(record.candID, testCandidateIDs[5000 % 3]) == 0);
+    CHECK(readChainBlock(&index, 3 * SEAL_ROWS - 1, &record) == 0 && strcmp(record.voterID, "T012287") == 0);
+    CHECK(readChainBlock(&index, 3 * SEAL_ROWS, &record) == 0 && strcmp(record.voterID, "T012288") == 0);
+    CHECK(readChainBlock(&index, SEAL_BLOCKS + 10, &record) == -1);
+
+    // [base + 40, base + 50) holds blocks 4000..4999, across the first two segments
+    testCandidates(candidates);
+    CHECK(tallyChainTimeRange(&index, SEAL_BASE_TIME + 40, SEAL_BASE_TIME + 50,
+                              candidates, TEST_CANDIDATES, votes) == 1000);
+    CHECK(votes[0] == 333 && votes[1] == 334 && votes[2] == 333);
+
+    // [base + 120, base + 125) holds blocks 12000..12387, sealed and hot
+    memset(votes, 0, sizeof(votes));
+    CHECK(tallyChainTimeRange(&index, SEAL_BASE_TIME + 120, SEAL_BASE_TIME + 125,
+                              candidates, TEST_CANDIDATES, votes) == 388);
+    CHECK(votes[0] + votes[1] + votes[2] == 388);
+
+    // A scan stops where the visitor asks it to, in chain order
+    CHECK(scanChainTimeRange(&index, SEAL_BASE_TIME + 40, SEAL_BASE_TIME + 41, collectSeq, seqs) == 5);
+    CHECK(seqs[1] == 4000 && seqs[5] == 4004);
+    closeChainIndex(&index);
+}
+
+// A seal interrupted before the chain file was replaced loads the same chain
+static void testInterruptedSeal(void) {
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    blockchain bc, loaded;
+    chainIndex index;
+    chainRecord record;
+    Candidate candidates[TEST_CANDIDATES];
+    int votes[TEST_CANDIDATES] = {0};
+    int verified = 0;
+
+    saveTestChain("crash.bin", root);
+    copyFile("crash.bin", "crash.old");
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "crash.bin");
+    CHECK(sealChain(&bc, "crash.bin", 2 * SEAL_ROWS) == 2 * SEAL_ROWS);
+    freeTestChain(&bc);
+    copyFile("crash.old", "crash.bin");
+
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "crash.bin");
+    CHECK(bc.length == SEAL_BLOCKS && bc.sealed == 2 * SEAL_ROWS);
+    CHECK(hashCompare(bc.merkle_root, root));
+    CHECK(verifyBlocks(&bc, 0) == 1);
+    resetBlockchain(&loaded);
+    CHECK(loadBlockchainParallel(&loaded, "crash.bin", 2, &verified) == 0);
+    CHECK(verified == 1);
+    CHECK(sameChain(&bc, &loaded));
+    freeLoadedBlockchain(&loaded);
+    freeTestChain(&bc);
+
+    testCandidates(candidates);
+    CHECK(openChainIndex(&index, "crash.bin") == 0);
+    CHECK(tallyChainTimeRange(&index, 0, SEAL_BASE_TIME + 1000, candidates, TEST_CANDIDATES, votes) == SEAL_BLOCKS);
+    CHECK(readChainBlock(&index, 100, &record) == 0 && strcmp(record.voterID, "T000100") == 0);
+    CHECK(readChainBlock(&index, 2 * SEAL_ROWS, &record) == 0 && strcmp(record.voterID, "T008192") == 0);
+    closeChainIndex(&index);
+    remove("crash.old");
+}
+
+// A hash altered inside a segment breaks verification like one in the chain file
+static void testTamperedSegment(void) {
+    unsigned char root[SHA256_DIGEST_LENGTH];
+    blockchain bc;
+    segmentStore store;
+    int verified = 1;
+
+    saveTestChain("tamper.bin", root);
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "tamper.bin");
+    CHECK(sealChain(&bc, "tamper.bin", SEAL_ROWS) == 3 * SEAL_ROWS);
+    freeTestChain(&bc);
+
+    // The hash column ends the segment; change the prevhash of its last row
+    CHECK(openSegmentStore(&store, "tamper.bin") == 0 && store.count == 3);
+    FILE *file = fopen("tamper.bin" SEGMENT_FILE_SUFFIX, "r+b");
+    CHECK(file != NULL);
+    long offset = (long)(store.entries[0].offset + store.entries[0].length - 8);
+    closeSegmentStore(&store);
+    int byte = 0;
+    fseek(file, offset, SEEK_SET);
+    byte = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(byte ^ 0x01, file);
+    fclose(file);
+
+    resetBlockchain(&bc);
+    loadBlockchainFromFile(&bc, "tamper.bin");
+    CHECK(bc.length == SEAL_BLOCKS);
+    CHECK(verifyBlocks(&bc, 0) == 0);
+    freeTestChain(&bc);
+    resetBlockchain(&bc);
+    CHECK(loadBlockchainParallel(&bc, "tamper.bin", 2, &verified) == 0);
+    CHECK(verified == 0);
+    freeLoadedBlockchain(&bc);
+}
+
+int main(void) {
+    testSealAndLoad();
+    testSealedIndex();
+    testInterruptedSeal();
+    testTamperedSegment();
+    return CHECK_RESULT();
+}
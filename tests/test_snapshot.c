@@ -0,0 +1,74 @@
+#include <stdio.h>
+#include <string.h>
+#include "blockchain.h"
+#include "chainsnapshot.h"
+#include "check.h"
+#include "chaintest.h"
+
+#define SNAPSHOT_BLOCKS 10000  // several tally chunks plus a partial one
+
+// A snapshot counts exactly the captured prefix, however the work is split
+static void testSnapshotPrefix(void) {
+    blockchain bc;
+    chainSnapshot snapshot;
+    Candidate candidates[TEST_CANDIDATES];
+    unsigned char root[SHA256_DIGEST_LENGTH];
+
+    testCandidates(candidates);
+    resetBlockchain(&bc);
+    appendTestBlocks(&bc, 0, SNAPSHOT_BLOCKS);
+    merkleAccumulatorRoot(&bc.merkle_acc, root);
+    captureChainSnapshot(&bc, &snapshot);
+    appendTestBlocks(&bc, SNAPSHOT_BLOCKS, 500);  // arrives after the capture
+
+    CHECK(snapshot.length == SNAPSHOT_BLOCKS);
+    CHECK(hashCompare(snapshot.root, root));
+    for (int threads = 1; threads <= 4; threads += 3) {
+        int votes[TEST_CANDIDATES] = {0};
+        CHECK(tallyChainSnapshot(&snapshot, candidates, TEST_CANDIDATES, votes, threads) == 1);
+        CHECK(votes[0] == 3334 && votes[1] == 3333 && votes[2] == 3333);
+    }
+
+    freeTestChain(&bc);
+}
+
+// Editing a counted block no longer matches the captured root
+static void testSnapshotTamper(void) {
+    blockchain bc;
+    chainSnapshot snapshot;
+    Candidate candidates[TEST_CANDIDATES];
+    int votes[TEST_CANDIDATES] = {0};
+
+    testCandidates(candidates);
+    resetBlockchain(&bc);
+    appendTestBlocks(&bc, 0, SNAPSHOT_BLOCKS);
+    captureChainSnapshot(&bc, &snapshot);
+
+    block *b = bc.head;
+    for (int i = 0; i < 5000; i++) b = b->next;
+    free(b->candID);
+    b->candID = strdup(testCandidateIDs[(5000 + 1) % TEST_CANDIDATES]);
+    CHECK(tallyChainSnapshot(&snapshot, candidates, TEST_CANDIDATES, votes, 2) == 0);
+    freeTestChain(&bc);
+}
+
+static void testEmptySnapshot(void) {
+    blockchain bc;
+    chainSnapshot snapshot;
+    Candidate candidates[TEST_CANDIDATES];
+    int votes[TEST_CANDIDATES] = {0};
+
+    testCandidates(candidates);
+    resetBlockchain(&bc);
+    captureChainSnapshot(&bc, &snapshot);
+    CHECK(snapshot.length == 0);
+    CHECK(tallyChainSnapshot(&snapshot, candidates, TEST_CANDIDATES, votes, 4) == 1);
+    CHECK(votes[0] == 0 && votes[1] == 0 && votes[2] == 0);
+}
+
+int main(void) {
+    testSnapshotPrefix();
+    testSnapshotTamper();
+    testEmptySnapshot();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "textcache.h"
+
+typedef struct textCacheEntry {
+    char *text;
+    TTF_Font *font;
+    SDL_Renderer *renderer;
+    SDL_Color color;
+    SDL_Texture *texture;
+    int w, h;
+    unsigned long lastUsed;
+} textCacheEntry;
+
+static textCacheEntry cache[TEXT_CACHE_SETS][TEXT_CACHE_WAYS];
+static unsigned long cacheClock;
+
+static unsigned int hashText(TTF_Font *font, const char *text, SDL_Color color) {
+    unsigned int hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    hash ^= ((unsigned int)color.r << 24) | ((unsigned int)color.g << 16) |
+            ((unsigned int)color.b << 8) | color.a;
+    hash *= 16777619u;
+    hash ^= (unsigned int)(size_t)font;
+    return hash * 16777619u;
+}
+
+static void releaseEntry(textCacheEntry *entry) {
+    if (entry->texture) SDL_DestroyTexture(entry->texture);
+    free(entry->text);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/*
+Returns the texture for text, rasterizing it only on a cache miss.
+The texture stays owned by the cache. Returns NULL for an empty string or on failure.
+*/
+SDL_Texture *getTextTexture(SDL_Renderer *renderer, TTF_Font *font, const char *text,
+                            SDL_Color color, int *w, int *h) {
+    if (text == NULL || text[0] == '\0') return NULL;
+
+    textCacheEntry *set = cache[hashText(font, text, color) % TEXT_CACHE_SETS];
+    textCacheEntry *victim = &set[0];
+    cacheClock++;
+
+    for (int i = 0; i < TEXT_CACHE_WAYS; i++) {
+        textCacheEntry *entry = &set[i];
+        if (entry->texture && entry->font == font && entry->renderer == renderer &&
+            memcmp(&entry->color, &color, sizeof(color)) == 0 && strcmp(entry->text, text) == 0) {
+            entry->lastUsed = cacheClock;
+            if (w) *w = entry->w;
+            if (h) *h = entry->h;
+            return entry->texture;
+        }
+        if (entry->lastUsed < victim->lastUsed) victim = entry;
+    }
+
+    SDL_Surface *surface = TTF_RenderText_Blended(font, text, color);
+    if (!surface) {
+        fprintf(stderr, "Text rendering failed: %s\n", TTF_GetError());
+        return NULL;
+    }
+    SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, surface);
+    int surfaceW = surface->w, surfaceH = surface->h;
+    SDL_FreeSurface(surface);
+    if (!texture) {
+        fprintf(stderr, "Texture creation failed: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    releaseEntry(victim);
+    victim->text = strdup(text);
+    if (victim->text == NULL) {
+        SDL_DestroyTexture(texture);
+        return NULL;
+    }
+    victim->font = font;
+    victim->renderer = renderer;
+    victim->color = color;
+    victim->texture = texture;
+    victim->w = surfaceW;
+    victim->h = surfaceH;
+    victim->lastUsed = cacheClock;
+
+    if (w) *w = surfaceW;
+    if (h) *h = surfaceH;
+    return texture;
+}
+
+// Destroys every cached texture; call before the renderer is destroyed.
+void clearTextCache(void) {
+    for (int s = 0; s < TEXT_CACHE_SETS; s++) {
+        for (int i = 0; i < TEXT_CACHE_WAYS; i++) {
+            releaseEntry(&cache[s][i]);
+        }
+    }
+}
@@ -0,0 +1,21 @@
+#ifndef TEXTCACHE_H
+#define TEXTCACHE_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+/*
+Keyed cache of rendered text textures.
+A string is rasterized and uploaded once per (font, color, text); later frames reuse the
+texture. Entries live in a 4-way set-associative table and the least recently used entry
+of a set is evicted, so edited input fields only cost a rasterization when their content
+changes and old contents age out on their own.
+*/
+#define TEXT_CACHE_SETS 128
+#define TEXT_CACHE_WAYS 4
+
+SDL_Texture *getTextTexture(SDL_Renderer *renderer, TTF_Font *font, const char *text,
+                            SDL_Color color, int *w, int *h);
+void clearTextCache(void);
+
+#endif
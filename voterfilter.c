@@ -0,0 +1,85 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "voterfilter.h"
+
+// Odd constants that spread one 32-bit hash into eight bit positions
+static const uint32_t filterSalts[VOTER_FILTER_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+// Finalizer from MurmurHash3; voter keys share long common prefixes
+static inline uint64_t mixKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+static inline uint32_t *filterBlock(const voterFilter *filter, uint64_t hash) {
+    // Multiply-shift maps the high half onto [0, blockCount) without a division
+    uint32_t block = (uint32_t)(((hash >> 32) * filter->blockCount) >> 32);
+    return filter->blocks + (size_t)block * VOTER_FILTER_BLOCK_WORDS;
+}
+
+void initVoterFilter(voterFilter *filter) {
+    filter->blocks = NULL;
+    filter->blockCount = 0;
+    filter->capacity = 0;
+    filter->count = 0;
+}
+
+void freeVoterFilter(voterFilter *filter) {
+    free(filter->blocks);
+    initVoterFilter(filter);
+}
+
+/*
+Empties the filter and sizes it for capacity keys.
+Returns 0 on success, -1 if memory ran out (the filter is then empty and disabled).
+*/
+int resetVoterFilter(voterFilter *filter, unsigned long capacity) {
+    if (capacity < VOTER_FILTER_MIN_CAPACITY) {
+        capacity = VOTER_FILTER_MIN_CAPACITY;
+    }
+    unsigned long bits = capacity * VOTER_FILTER_BITS_PER_KEY;
+    unsigned long blockBits = VOTER_FILTER_BLOCK_WORDS * 32;
+    unsigned long blockCount = (bits + blockBits - 1) / blockBits;
+    size_t size = blockCount * VOTER_FILTER_BLOCK_WORDS * sizeof(uint32_t);
+
+    // aligned_alloc needs a multiple of the alignment
+    size = (size + 63) & ~(size_t)63;
+    free(filter->blocks);
+    initVoterFilter(filter);
+    if (blockCount > UINT32_MAX || (filter->blocks = aligned_alloc(64, size)) == NULL) {
+        printf("Memory allocation failed\n");
+        return -1;
+    }
+    memset(filter->blocks, 0, size);
+    filter->blockCount = (uint32_t)blockCount;
+    filter->capacity = capacity;
+    return 0;
+}
+
+void voterFilterAdd(voterFilter *filter, uint64_t key) {
+    uint64_t hash = mixKey(key);
+    uint32_t *block = filterBlock(filter, hash);
+    for (int i = 0; i < VOTER_FILTER_BLOCK_WORDS; i++) {
+        block[i] |= 1U << (((uint32_t)hash * filterSalts[i]) >> 27);
+    }
+    filter->count++;
+}
+
+// Returns 0 if key was never added; 1 if it probably was
+int voterFilterMayContain(const voterFilter *filter, uint64_t key) {
+    uint64_t hash = mixKey(key);
+    const uint32_t *block = filterBlock(filter, hash);
+    uint32_t missing = 0;
+    for (int i = 0; i < VOTER_FILTER_BLOCK_WORDS; i++) {
+        missing |= ~block[i] & (1U << (((uint32_t)hash * filterSalts[i]) >> 27));
+    }
+    return missing == 0;
+}
@@ -0,0 +1,32 @@
+#ifndef VOTERFILTER_H
+#define VOTERFILTER_H
+
+#include <stdint.h>
+
+#define VOTER_FILTER_BITS_PER_KEY 12
+#define VOTER_FILTER_MIN_CAPACITY 4096
+#define VOTER_FILTER_BLOCK_WORDS 8  // 32-byte blocks, two per cache line
+
+/*
+Split-block Bloom filter over 64-bit voter keys, used to reject unregistered IDs
+before the registry tree is walked.
+
+A key hashes to one 32-byte block and sets one bit in each of its eight 32-bit words,
+so a lookup touches a single cache line. At 12 bits per key the false-positive rate is
+about 0.4%; a negative answer is always exact. Keys cannot be removed: a deleted voter
+stays a (harmless) false positive until the filter is rebuilt.
+*/
+typedef struct voterFilter {
+    uint32_t *blocks;
+    uint32_t blockCount;
+    unsigned long capacity;  // keys the filter was sized for
+    unsigned long count;     // keys added since the last reset
+} voterFilter;
+
+void initVoterFilter(voterFilter *filter);
+void freeVoterFilter(voterFilter *filter);
+int resetVoterFilter(voterFilter *filter, unsigned long capacity);
+void voterFilterAdd(voterFilter *filter, uint64_t key);
+int voterFilterMayContain(const voterFilter *filter, uint64_t key);
+
+#endif